@@ -5,6 +5,8 @@
 #ifndef CTRL_PROTOCOL_H
 #define CTRL_PROTOCOL_H
 
+#include "pkt_endian.h"
+#include <stddef.h>
 #include <stdint.h>
 
 #pragma pack(push, 1)
@@ -83,4 +85,86 @@ typedef struct
 } control_cmd_t;
 #pragma pack(pop)
 
+// ========= 线上编解码 ========
+// 布局与上面 pack(1) 结构体在小端平台上的内存布局一致（mode 为 4 字节枚举），
+// 用逐字段小端读写代替直接拷贝结构体，与主机字节序和对齐无关
+#define CTRL_CMD_WIRE_SIZE 15 // 不含调试文本
+#define CTRL_CMD_OFFSET_SERVO 2
+#define CTRL_CMD_OFFSET_MODE 4
+#define CTRL_CMD_OFFSET_MOTION 8
+#define CTRL_CMD_OFFSET_TEXT_LEN 14
+
+/**
+ * 编码控制指令（调试文本取自 cmd->ping_text）
+ * @return 编码长度，缓冲区不足返回 0
+ */
+static inline size_t control_cmd_encode(const control_cmd_t* cmd, uint8_t* out, const size_t out_cap)
+{
+    const size_t len = CTRL_CMD_WIRE_SIZE + cmd->ping_text.len;
+    if (out_cap < len)
+    {
+        return 0;
+    }
+    pkt_store_u8(out, cmd->ctrl_id);
+    pkt_store_u8(out + 1, cmd->ctrl_fields);
+    pkt_store_u8(out + CTRL_CMD_OFFSET_SERVO, cmd->servo.angle);
+    pkt_store_u8(out + CTRL_CMD_OFFSET_SERVO + 1, cmd->servo.speed);
+    pkt_store_le32(out + CTRL_CMD_OFFSET_MODE, (uint32_t)cmd->motor.mode);
+    uint8_t* motion = out + CTRL_CMD_OFFSET_MOTION;
+    memset(motion, 0, sizeof(motor_motion_t));
+    if (cmd->motor.mode == CTRL_MODE_DIFFERENTIAL)
+    {
+        pkt_store_le16(motion, (uint16_t)cmd->motor.motion.diff.linear_vel);
+        pkt_store_le16(motion + 2, (uint16_t)cmd->motor.motion.diff.angular_vel);
+        pkt_store_u8(motion + 4, cmd->motor.motion.diff.accel);
+    }
+    else if (cmd->motor.mode == CTRL_MODE_DIRECT)
+    {
+        pkt_store_le16(motion, (uint16_t)cmd->motor.motion.direct.left_speed);
+        pkt_store_le16(motion + 2, (uint16_t)cmd->motor.motion.direct.right_speed);
+        pkt_store_u8(motion + 4, cmd->motor.motion.direct.left_accel);
+        pkt_store_u8(motion + 5, cmd->motor.motion.direct.right_accel);
+    }
+    pkt_store_u8(out + CTRL_CMD_OFFSET_TEXT_LEN, cmd->ping_text.len);
+    memcpy(out + CTRL_CMD_WIRE_SIZE, cmd->ping_text.msg, cmd->ping_text.len);
+    return len;
+}
+
+/**
+ * 解码控制指令（不拷贝调试文本）
+ * @param cmd  输出，ping_text.msg 不填写
+ * @param text 输出，指向 in 中的调试文本
+ * @return 0-成功，-1-数据被截断
+ */
+static inline int control_cmd_decode(control_cmd_t* cmd, const uint8_t** text, const uint8_t* in, const size_t len)
+{
+    if (len < CTRL_CMD_WIRE_SIZE || len < CTRL_CMD_WIRE_SIZE + (size_t)in[CTRL_CMD_OFFSET_TEXT_LEN])
+    {
+        return -1;
+    }
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->ctrl_id = pkt_load_u8(in);
+    cmd->ctrl_fields = pkt_load_u8(in + 1);
+    cmd->servo.angle = pkt_load_u8(in + CTRL_CMD_OFFSET_SERVO);
+    cmd->servo.speed = pkt_load_u8(in + CTRL_CMD_OFFSET_SERVO + 1);
+    cmd->motor.mode = (motor_ctrl_mode_t)pkt_load_le32(in + CTRL_CMD_OFFSET_MODE);
+    const uint8_t* motion = in + CTRL_CMD_OFFSET_MOTION;
+    if (cmd->motor.mode == CTRL_MODE_DIFFERENTIAL)
+    {
+        cmd->motor.motion.diff.linear_vel = (int16_t)pkt_load_le16(motion);
+        cmd->motor.motion.diff.angular_vel = (int16_t)pkt_load_le16(motion + 2);
+        cmd->motor.motion.diff.accel = pkt_load_u8(motion + 4);
+    }
+    else if (cmd->motor.mode == CTRL_MODE_DIRECT)
+    {
+        cmd->motor.motion.direct.left_speed = (int16_t)pkt_load_le16(motion);
+        cmd->motor.motion.direct.right_speed = (int16_t)pkt_load_le16(motion + 2);
+        cmd->motor.motion.direct.left_accel = pkt_load_u8(motion + 4);
+        cmd->motor.motion.direct.right_accel = pkt_load_u8(motion + 5);
+    }
+    cmd->ping_text.len = pkt_load_u8(in + CTRL_CMD_OFFSET_TEXT_LEN);
+    *text = in + CTRL_CMD_WIRE_SIZE;
+    return 0;
+}
+
 #endif //CTRL_PROTOCOL_H
@@ -0,0 +1,110 @@
+//
+// 虚拟内存镜像环形缓冲区
+//
+
+#ifndef MIRROR_RING_H
+#define MIRROR_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 同一块共享内存（memfd，不支持时用 shm_open）在虚拟地址空间中背靠背映射两次：
+ * buffer[i] 与 buffer[i + capacity] 是同一个字节。因此从任意位置开始、长度不超过 capacity 的
+ * 可读/可写区域在虚拟地址上总是连续的，读写只需一次 memcpy，解析器也可以直接在环内
+ * 处理跨越绕回点的帧。容量按页大小（开启大页时按大页大小）向上取整。
+ * 与 RingBuffer_t 相同，不做线程同步。
+ */
+
+// 大页大小（x86-64/AArch64 默认 2MB）
+#define MIRROR_RING_HUGE_PAGE_SIZE (2u * 1024 * 1024)
+
+typedef struct {
+    uint8_t *buffer; // 第一份映射的起始地址，其后紧跟第二份映射
+    size_t capacity; // 缓冲区容量
+    size_t head; // 写位置（单调递增）
+    size_t tail; // 读位置（单调递增）
+    void *mapping; // 整个保留区域（含对齐余量），用于释放
+    size_t mappingSize; // 保留区域大小
+    bool hugePages; // 实际是否使用了大页
+} MirrorRing_t;
+
+/**
+ * 初始化镜像环形缓冲区
+ * @param mr 缓冲区指针
+ * @param capacity 最小容量（向上取整为页大小的整数倍）
+ * @param hugePages 是否尝试使用大页，系统未配置大页时自动退回普通页（见 mr->hugePages）
+ * @return 是否初始化成功
+ */
+bool MirrorRing_Init(MirrorRing_t *mr, size_t capacity, bool hugePages);
+
+/**
+ * 释放镜像环形缓冲区
+ * @param mr 缓冲区指针
+ */
+void MirrorRing_Free(MirrorRing_t *mr);
+
+/**
+ * 写入数据（一次 memcpy）
+ * @param mr 缓冲区指针
+ * @param data 要写入的数据指针
+ * @param length 要写入的数据长度
+ * @return 是否写入成功，空间不足时不写入
+ */
+bool MirrorRing_Write(MirrorRing_t *mr, const uint8_t *data, size_t length);
+
+/**
+ * 读取数据（一次 memcpy）
+ * @param mr 缓冲区指针
+ * @param data 输出缓冲区
+ * @param length 要读取的最大长度
+ * @return 实际读取的数据长度
+ */
+size_t MirrorRing_Read(MirrorRing_t *mr, uint8_t *data, size_t length);
+
+/**
+ * 获取连续的可写区域（供 read 等直接写入）
+ * @param mr 缓冲区指针
+ * @param length 输出可写长度（即空闲空间）
+ * @return 可写区域起始地址
+ */
+uint8_t *MirrorRing_WritePtr(MirrorRing_t *mr, size_t *length);
+
+/**
+ * 提交已写入可写区域的数据
+ * @param mr 缓冲区指针
+ * @param length 写入长度（不超过 MirrorRing_WritePtr 返回的长度）
+ */
+void MirrorRing_Produce(MirrorRing_t *mr, size_t length);
+
+/**
+ * 获取连续的可读区域（即使数据跨越绕回点）
+ * @param mr 缓冲区指针
+ * @param length 输出可读长度（即已用空间）
+ * @return 可读区域起始地址
+ */
+const uint8_t *MirrorRing_ReadPtr(MirrorRing_t *mr, size_t *length);
+
+/**
+ * 丢弃已处理的数据
+ * @param mr 缓冲区指针
+ * @param length 丢弃长度（不超过已用空间）
+ */
+void MirrorRing_Consume(MirrorRing_t *mr, size_t length);
+
+/**
+ * 获取空闲空间
+ * @param mr 缓冲区指针
+ * @return 空闲空间大小
+ */
+size_t MirrorRing_GetFreeSpace(const MirrorRing_t *mr);
+
+/**
+ * 获取已用空间
+ * @param mr 缓冲区指针
+ * @return 已用空间大小
+ */
+size_t MirrorRing_GetUsedSpace(const MirrorRing_t *mr);
+
+#endif //MIRROR_RING_H
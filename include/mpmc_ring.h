@@ -0,0 +1,96 @@
+//
+// 多生产者多消费者无锁帧队列
+//
+
+#ifndef MPMC_RING_H
+#define MPMC_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 有界 MPMC 队列（Vyukov 序号槽位算法），每个槽位存放一整帧（长度不超过 slotSize）。
+ * 生产者/消费者各自用一次 CAS 认领位置，槽位序号表示该槽位当前可写还是可读，
+ * 不需要互斥锁；批量接口一次 CAS 认领多个连续槽位。
+ * 与 RingBuffer_t 不同，这里按帧入队出队，不会出现半帧。
+ */
+
+// 缓存行大小（入队、出队位置分别独占一行，避免生产者与消费者互相失效）
+#define MPMC_RING_CACHE_LINE 64
+
+typedef struct {
+    uint8_t *slots; // 槽位数组（每个槽位 slotStride 字节，缓存行对齐）
+    uint32_t capacity; // 槽位数（2 的幂）
+    uint32_t mask; // capacity - 1
+    uint32_t slotSize; // 单帧最大长度
+    uint32_t slotStride; // 槽位间距
+    _Alignas(MPMC_RING_CACHE_LINE) atomic_size_t enqueuePos; // 下一个入队位置
+    _Alignas(MPMC_RING_CACHE_LINE) atomic_size_t dequeuePos; // 下一个出队位置
+} MpmcRing_t;
+
+/**
+ * 初始化队列
+ * @param ring 队列指针
+ * @param capacity 槽位数（向上取整为 2 的幂，至少为 2）
+ * @param slotSize 单帧最大长度，通常为 PROTOCOL_MAX_FRAME_LEN
+ * @return 是否初始化成功
+ */
+bool MpmcRing_Init(MpmcRing_t *ring, uint32_t capacity, uint16_t slotSize);
+
+/**
+ * 释放队列（调用前所有生产者、消费者须已退出）
+ * @param ring 队列指针
+ */
+void MpmcRing_Free(MpmcRing_t *ring);
+
+/**
+ * 入队一帧
+ * @param ring 队列指针
+ * @param data 帧数据
+ * @param length 帧长度
+ * @return 是否成功，队列满或帧过长时返回 false
+ */
+bool MpmcRing_Enqueue(MpmcRing_t *ring, const uint8_t *data, uint16_t length);
+
+/**
+ * 批量入队，一次认领多个连续槽位（保持 frames 中的顺序）
+ * @param ring 队列指针
+ * @param frames 各帧数据指针
+ * @param lengths 各帧长度
+ * @param count 帧数
+ * @return 实际入队的帧数（frames 的前缀），队列空间不足或遇到过长帧时截断
+ */
+uint32_t MpmcRing_EnqueueBatch(MpmcRing_t *ring, const uint8_t *const *frames, const uint16_t *lengths,
+                               uint32_t count);
+
+/**
+ * 出队一帧
+ * @param ring 队列指针
+ * @param data 输出缓冲区，至少 slotSize 字节
+ * @param length 输出帧长度
+ * @return 是否成功，队列空时返回 false
+ */
+bool MpmcRing_Dequeue(MpmcRing_t *ring, uint8_t *data, uint16_t *length);
+
+/**
+ * 批量出队，各帧首尾相接写入 out（可直接整体写入串口）
+ * @param ring 队列指针
+ * @param out 输出缓冲区
+ * @param outSize 输出缓冲区大小，每 slotSize 字节最多取出一帧
+ * @param lengths 输出各帧长度，可为 NULL
+ * @param maxCount 最多出队帧数
+ * @return 实际出队的帧数
+ */
+uint32_t MpmcRing_DequeueBatch(MpmcRing_t *ring, uint8_t *out, size_t outSize, uint16_t *lengths,
+                               uint32_t maxCount);
+
+/**
+ * 获取队列中的帧数（并发时为近似值）
+ * @param ring 队列指针
+ * @return 帧数
+ */
+uint32_t MpmcRing_GetCount(MpmcRing_t *ring);
+
+#endif //MPMC_RING_H
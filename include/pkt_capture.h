@@ -0,0 +1,124 @@
+#ifndef PKT_CAPTURE_H
+#define PKT_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 原始串口数据抓包格式
+ *
+ * 文件头(16): magic "SPKTCAP1"(8) + version(4) + reserved(4)
+ * 记录头(16): ts_ns(8) + port_id(2) + len(2) + reserved(4)，随后是 len 字节原始数据
+ * 所有字段均为小端；ts_ns 为 CLOCK_MONOTONIC 纳秒。
+ */
+
+#define PROTOCOL_CAPTURE_MAGIC "SPKTCAP1"
+#define PROTOCOL_CAPTURE_VERSION 1
+#define PROTOCOL_CAPTURE_FILE_HEADER_LEN 16
+#define PROTOCOL_CAPTURE_RECORD_HEADER_LEN 16
+// 默认写缓冲区大小
+#define PROTOCOL_CAPTURE_DEFAULT_BUFFER (64 * 1024)
+
+/**
+ * @brief 抓包写入器（带缓冲，满时一次性写盘）
+ */
+typedef struct
+{
+    int fd; // 文件描述符
+    uint8_t* buffer; // 写缓冲区
+    size_t capacity; // 写缓冲区大小
+    size_t used; // 写缓冲区已用长度
+    uint64_t records; // 已写入记录数
+    uint64_t bytes; // 已写入原始数据字节数
+} protocol_capture_writer_t;
+
+/**
+ * @brief 一条抓包记录
+ */
+typedef struct
+{
+    uint64_t ts_ns; // 读取时间戳
+    uint16_t port_id; // 端口ID
+    uint16_t len; // 数据长度
+    const uint8_t* data; // 原始数据（指向映射内存）
+} protocol_capture_record_t;
+
+/**
+ * @brief 抓包读取器（mmap 整个文件）
+ */
+typedef struct
+{
+    const uint8_t* base; // 映射基址
+    size_t size; // 文件大小
+    size_t pos; // 当前读取位置
+} protocol_capture_reader_t;
+
+/**
+ * 当前单调时钟（纳秒）
+ */
+uint64_t protocol_capture_now_ns(void);
+
+/**
+ * 创建抓包文件
+ * @param writer      写入器
+ * @param path        文件路径（已存在则覆盖）
+ * @param buffer_size 写缓冲区大小，0 使用默认值
+ * @return 是否成功
+ */
+bool protocol_capture_open(protocol_capture_writer_t* writer, const char* path, size_t buffer_size);
+
+/**
+ * 记录一次串口读取
+ * @param writer  写入器
+ * @param port_id 端口ID
+ * @param ts_ns   时间戳，通常取 protocol_capture_now_ns()
+ * @param data    读取到的数据
+ * @param len     数据长度
+ * @return 0-成功，-1-写盘失败
+ */
+int protocol_capture_write(protocol_capture_writer_t* writer, uint16_t port_id, uint64_t ts_ns,
+                           const uint8_t* data, uint16_t len);
+
+/**
+ * 将缓冲区内容写盘
+ * @param writer 写入器
+ * @return 0-成功，-1-写盘失败
+ */
+int protocol_capture_flush(protocol_capture_writer_t* writer);
+
+/**
+ * 写盘并关闭抓包文件
+ * @param writer 写入器
+ */
+void protocol_capture_close(protocol_capture_writer_t* writer);
+
+/**
+ * 映射抓包文件并校验文件头（魔数与版本号）
+ * @param reader 读取器
+ * @param path   文件路径
+ * @return 是否成功
+ */
+bool protocol_capture_map(protocol_capture_reader_t* reader, const char* path);
+
+/**
+ * 读取下一条记录
+ * @param reader 读取器
+ * @param record 输出记录
+ * @return 1-成功，0-已到文件末尾，-1-记录被截断
+ */
+int protocol_capture_next(protocol_capture_reader_t* reader, protocol_capture_record_t* record);
+
+/**
+ * 回到第一条记录
+ * @param reader 读取器
+ */
+void protocol_capture_rewind(protocol_capture_reader_t* reader);
+
+/**
+ * 解除映射
+ * @param reader 读取器
+ */
+void protocol_capture_unmap(protocol_capture_reader_t* reader);
+
+#endif //PKT_CAPTURE_H
@@ -0,0 +1,123 @@
+#ifndef PKT_COMPRESS_H
+#define PKT_COMPRESS_H
+
+#include "pkt_protocol.h"
+#include <stdint.h>
+
+/*
+ * 负载压缩
+ *
+ * 压缩后的帧在类型字节上置 PROTOCOL_TYPE_FLAG_COMPRESSED，帧头/CRC/帧尾不变，
+ * 未启用压缩的接收端会把它当作未知类型忽略。
+ *
+ * 压缩负载格式:
+ *   codec(1) + 原始长度(2, 小端) + 编码数据
+ */
+
+// 压缩负载头长度: codec(1) + raw_len(2)
+#define PROTOCOL_COMPRESS_HEADER_LEN 3
+// 单帧解压后的最大长度，解码时以此限制输出，保证解码开销有界
+#define PROTOCOL_MAX_UNCOMPRESSED_LEN 512
+
+/**
+ * @brief 压缩算法
+ */
+typedef enum
+{
+    PROTOCOL_CODEC_NONE = 0x00, // 不压缩
+    PROTOCOL_CODEC_LZ = 0x01, // 字节型 LZ77，适合日志文本
+    PROTOCOL_CODEC_DELTA16 = 0x02, // int16 差分 + zigzag varint，适合传感器采样
+    PROTOCOL_CODEC_MAX
+} protocol_codec_t;
+
+/**
+ * @brief 压缩统计
+ */
+typedef struct
+{
+    uint64_t raw_bytes; // 压缩前负载字节数
+    uint64_t wire_bytes; // 实际发送的负载字节数
+    uint32_t frames_compressed; // 压缩发送的帧数
+    uint32_t frames_stored; // 压缩不划算而原样发送的帧数
+    uint32_t frames_decoded; // 成功解压的帧数
+    uint32_t decode_errors; // 解压失败的帧数
+} protocol_compress_stats_t;
+
+/**
+ * @brief 压缩上下文（按协议类型选择算法）
+ */
+typedef struct
+{
+    uint8_t codec[PROTOCOL_TYPE_MAX]; // 各类型使用的算法 @see protocol_codec_t
+    protocol_compress_stats_t stats; // 统计信息
+} protocol_compressor_t;
+
+/**
+ * 初始化压缩上下文，默认 LOG 使用 LZ，SENSOR 使用 DELTA16，CONTROL 不压缩
+ * @param compressor 压缩上下文
+ */
+void protocol_compressor_init(protocol_compressor_t* compressor);
+
+/**
+ * 设置某协议类型使用的压缩算法
+ * @param compressor 压缩上下文
+ * @param type       协议类型
+ * @param codec      压缩算法
+ */
+void protocol_compressor_set_codec(protocol_compressor_t* compressor, protocol_type_t type,
+                                   protocol_codec_t codec);
+
+/**
+ * 压缩负载（含压缩负载头）
+ * @param codec   压缩算法
+ * @param in      原始数据
+ * @param in_len  原始数据长度，不超过 PROTOCOL_MAX_UNCOMPRESSED_LEN
+ * @param out     输出缓冲区
+ * @param out_cap 输出缓冲区大小
+ * @return 压缩后长度，输出空间不足或参数非法返回 -1
+ */
+int protocol_compress(protocol_codec_t codec, const uint8_t* in, uint16_t in_len,
+                      uint8_t* out, uint16_t out_cap);
+
+/**
+ * 解压负载
+ * @param in      压缩负载（含压缩负载头）
+ * @param in_len  压缩负载长度
+ * @param out     输出缓冲区
+ * @param out_cap 输出缓冲区大小
+ * @return 解压后长度，数据损坏或空间不足返回 -1
+ */
+int protocol_decompress(const uint8_t* in, uint16_t in_len, uint8_t* out, uint16_t out_cap);
+
+/**
+ * @brief 按类型配置压缩并打包协议帧
+ * @note 压缩结果不比原始数据短时按原样打包；原始数据超过 PROTOCOL_MAX_DATA_LEN 且无法压缩到帧内时返回 NULL
+ *
+ * @param compressor 压缩上下文
+ * @param type       协议类型，可带 PROTOCOL_TYPE_FLAG_CRC32C（按 PROTOCOL_TYPE_ID 选择算法，标志保留到帧内）
+ * @param data       数据内容
+ * @param data_len   数据长度，不超过 PROTOCOL_MAX_UNCOMPRESSED_LEN
+ * @param frame_len  协议帧数据长度
+ */
+uint8_t* protocol_pack_frame_compressed(protocol_compressor_t* compressor, protocol_type_t type,
+                                        const uint8_t* data, uint16_t data_len, uint16_t* frame_len);
+
+/**
+ * 解压接收到的帧负载并累计统计
+ * @param compressor 压缩上下文
+ * @param in         帧负载
+ * @param in_len     帧负载长度
+ * @param out        输出缓冲区
+ * @param out_cap    输出缓冲区大小
+ * @return 解压后长度，失败返回 -1
+ */
+int protocol_decompress_payload(protocol_compressor_t* compressor, const uint8_t* in, uint16_t in_len,
+                                uint8_t* out, uint16_t out_cap);
+
+/**
+ * 压缩率（发送字节 / 原始字节），没有数据时返回 1.0
+ * @param stats 压缩统计
+ */
+double protocol_compress_ratio(const protocol_compress_stats_t* stats);
+
+#endif //PKT_COMPRESS_H
@@ -0,0 +1,74 @@
+#ifndef PKT_CRC_H
+#define PKT_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 多缓冲区 CRC16-CCITT
+ *
+ * 与 crc16_ccitt 结果完全一致（初值 0xFFFF，多项式 0x1021，不反射）。
+ * 单个 CRC 的查表计算是一条串行依赖链，每字节都要等上一字节的结果；
+ * 这里把 PROTOCOL_CRC_LANES 个互不相关的缓冲区交错在同一个循环里，各条依赖链由 CPU 并行执行。
+ * 某条通道的缓冲区算完后立即换上下一个，长度不同的帧也能保持所有通道忙碌。
+ * 数量很大时（离线校验抓包）还可以再按线程切分。
+ *
+ * CRC32C（Castagnoli，反射多项式 0x82F63B78，初值与结果异或均为 0xFFFFFFFF）
+ *
+ * 类型字节带 PROTOCOL_TYPE_FLAG_CRC32C 的帧使用 4 字节 CRC32C 代替 CRC16。
+ * x86 上 CPU 支持 SSE4.2 时使用 crc32 指令（每条指令处理 8 字节），否则使用 slicing-by-8 查表。
+ */
+
+// 交错的通道数
+#define PROTOCOL_CRC_LANES 8
+
+/**
+ * 查表计算 CRC16（逐缓冲区，可分段调用）
+ * @param crc  初值（首段为 0xFFFF）
+ * @param data 数据
+ * @param len  长度
+ * @return 更新后的 CRC
+ */
+uint16_t protocol_crc16_update(uint16_t crc, const uint8_t* data, size_t len);
+
+/**
+ * 计算多个独立缓冲区的 CRC16
+ * @param data  各缓冲区
+ * @param lens  各缓冲区长度
+ * @param crcs  输出各缓冲区的 CRC
+ * @param count 缓冲区数
+ */
+void protocol_crc16_multi(const uint8_t* const* data, const size_t* lens, uint16_t* crcs, size_t count);
+
+/**
+ * 计算 CRC32C，可分段调用
+ * @param crc  上一段的结果（首段为 0）
+ * @param data 数据
+ * @param len  长度
+ * @return CRC32C
+ */
+uint32_t protocol_crc32c(uint32_t crc, const uint8_t* data, size_t len);
+
+/**
+ * 软件实现（用于对比测试和基准）
+ */
+uint32_t protocol_crc32c_sw(uint32_t crc, const uint8_t* data, size_t len);
+
+/**
+ * 校验多个完整线上帧的 CRC 字段（帧头 + 负载的 CRC 与帧内小端 CRC 比较，CRC32C 帧按 CRC32C 校验）
+ * @param frames 各帧起始地址（从帧头 0x55 开始）
+ * @param lens   各帧长度（含帧尾）
+ * @param ok     输出各帧是否通过，可为 NULL
+ * @param count  帧数
+ * @return 通过的帧数
+ */
+size_t protocol_crc16_verify_frames(const uint8_t* const* frames, const size_t* lens, uint8_t* ok, size_t count);
+
+/**
+ * 同 protocol_crc16_verify_frames，按线程切分
+ * @param threads 线程数（0 或 1 时在调用线程内完成）
+ */
+size_t protocol_crc16_verify_frames_mt(const uint8_t* const* frames, const size_t* lens, uint8_t* ok, size_t count,
+                                       unsigned threads);
+
+#endif //PKT_CRC_H
@@ -0,0 +1,95 @@
+#ifndef PKT_DECODE_H
+#define PKT_DECODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 离线并行解码（大体积原始串口转储）
+ *
+ * 把连续的原始字节流切成若干块，由线程池并行处理：每块从块首按“等待帧头”状态开始，
+ * 用 protocol_scan_header 跳过噪声，按帧头中的长度直接定位帧尾并查表校验 CRC，不逐字节走状态机、不分配内存。
+ * 块首的推测状态可能与顺序解析不同（上一块的帧跨越了块边界，或错位的候选帧吞掉了真正的帧头），
+ * 合并时从上一块的真实结束位置继续顺序解码，直到与本块解出的某个帧头位置重合，之后两者完全一致。
+ * 结果（帧序列、各类型计数、错误统计）与从头逐字节调用 protocol_parse_byte 相同。
+ */
+
+// 默认块大小
+#define PROTOCOL_DECODE_DEFAULT_CHUNK (4u * 1024 * 1024)
+// 最小块大小（须远大于最大帧长，保证跨边界的帧只涉及相邻两块）
+#define PROTOCOL_DECODE_MIN_CHUNK 4096u
+
+/**
+ * @brief 解码选项
+ */
+typedef struct
+{
+    unsigned threads; // 线程数，0 表示在线 CPU 数
+    size_t chunk_size; // 块大小，0 表示 PROTOCOL_DECODE_DEFAULT_CHUNK
+    bool collect_frames; // 是否输出每个帧的位置
+} protocol_decode_options_t;
+
+/**
+ * @brief 解出的帧（负载通过 protocol_decode_frame_data 访问）
+ */
+typedef struct
+{
+    uint64_t offset; // 帧头在字节流中的偏移
+    uint16_t len; // 负载长度
+    uint8_t type; // 协议类型（原始类型字节）
+} protocol_decoded_frame_t;
+
+/**
+ * @brief 解码结果
+ */
+typedef struct
+{
+    uint64_t bytes; // 输入字节数
+    uint64_t frames; // 解析成功的帧数
+    uint64_t payload_bytes; // 成功帧的负载总字节数
+    uint64_t crc_errors; // CRC 校验失败的帧数
+    uint64_t format_errors; // 长度越界或帧尾错误的帧数
+    uint64_t incomplete_bytes; // 结尾处未完成帧的字节数
+    uint64_t type_counts[256]; // 按类型字节统计的成功帧数
+    protocol_decoded_frame_t* frame_list; // 按顺序排列的帧（collect_frames 时）
+    size_t frame_count; // frame_list 中的帧数
+    const uint8_t* base; // 字节流起始地址
+    size_t mapped_size; // protocol_decode_file 映射的大小，0 表示不拥有 base
+} protocol_decode_result_t;
+
+/**
+ * 并行解码内存中的字节流
+ * @param data   字节流
+ * @param len    长度
+ * @param opts   选项，NULL 使用默认值
+ * @param result 输出结果，使用后调用 protocol_decode_result_free
+ * @return 是否成功（内存或线程不足时失败）
+ */
+bool protocol_decode_buffer(const uint8_t* data, size_t len, const protocol_decode_options_t* opts,
+                            protocol_decode_result_t* result);
+
+/**
+ * 映射原始转储文件并并行解码（映射保留到 protocol_decode_result_free，供读取帧负载）
+ * @param path   文件路径
+ * @param opts   选项，NULL 使用默认值
+ * @param result 输出结果
+ * @return 是否成功
+ */
+bool protocol_decode_file(const char* path, const protocol_decode_options_t* opts, protocol_decode_result_t* result);
+
+/**
+ * 取帧负载
+ * @param result 解码结果
+ * @param frame  frame_list 中的帧
+ * @return 负载起始地址
+ */
+const uint8_t* protocol_decode_frame_data(const protocol_decode_result_t* result,
+                                          const protocol_decoded_frame_t* frame);
+
+/**
+ * 释放帧列表并解除映射
+ */
+void protocol_decode_result_free(protocol_decode_result_t* result);
+
+#endif //PKT_DECODE_H
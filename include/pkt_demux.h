@@ -0,0 +1,165 @@
+#ifndef PKT_DEMUX_H
+#define PKT_DEMUX_H
+
+#include "pkt_compress.h"
+#include "pkt_protocol_buf.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 按类型分流
+ *
+ * 接收器解析出的帧按类型复制到各自的有界队列（stream），每个队列由自己的消费者线程处理，
+ * 重负载类型（如传感器解码）不会拖慢控制指令。队列策略:
+ *   ORDERED     严格按到达顺序逐帧交付：上一帧 release 之前不会交出下一帧；满时丢弃新帧
+ *   PARALLEL    多个消费者可同时各取一帧并行处理，不保证完成顺序；满时丢弃新帧
+ *   BEST_EFFORT 满时丢弃最旧的未取出帧腾出队尾槽位；槽位按环形顺序复用，
+ *               队尾槽位仍在处理中（已 pop 未 release）时只能丢弃新帧
+ * 入队在接收器线程上执行，默认从不等待，慢消费者不会阻塞其他类型的帧；
+ * ORDERED/PARALLEL 可用 protocol_stream_set_push_timeout 允许满时有限等待后再丢弃。
+ */
+
+// 队列中单帧的最大长度（可容纳解压后的负载）
+#define PROTOCOL_STREAM_FRAME_MAX PROTOCOL_MAX_UNCOMPRESSED_LEN
+
+typedef enum
+{
+    PROTOCOL_STREAM_ORDERED,
+    PROTOCOL_STREAM_PARALLEL,
+    PROTOCOL_STREAM_BEST_EFFORT,
+} protocol_stream_policy_t;
+
+/**
+ * @brief 队列中的一帧（pop 得到，处理完必须 release）
+ */
+typedef struct
+{
+    uint8_t state; // 内部使用
+    uint8_t type; // 帧类型
+    uint16_t len; // 负载长度
+    uint32_t seq; // 在本队列中的到达序号
+    protocol_frame_times_t times; // 接收器记录的时间戳（未开启时为 0）
+    uint64_t enqueue_ns; // 入队时间（接收器开启时间戳时记录），用于统计排队延迟
+    uint8_t data[PROTOCOL_STREAM_FRAME_MAX]; // 负载
+} protocol_stream_frame_t;
+
+/**
+ * @brief 队列统计
+ */
+typedef struct
+{
+    uint32_t pushed; // 入队帧数
+    uint32_t delivered; // 交给消费者的帧数
+    uint32_t dropped; // 丢弃的帧数（队列满、超长或已关闭）
+    uint32_t producer_waits; // 生产者因队列满等待的次数（设置了 push_timeout_ms 时）
+} protocol_stream_stats_t;
+
+/**
+ * @brief 单类型（或一组类型）的帧队列
+ */
+typedef struct
+{
+    protocol_stream_policy_t policy; // 队列策略
+    protocol_stream_frame_t* slots; // 环形槽位
+    uint16_t capacity; // 槽位数
+    uint16_t head; // 最旧的未取出帧
+    uint16_t tail; // 下一个写入位置
+    uint16_t ready; // 未取出帧数
+    uint16_t in_flight; // 已取出未释放帧数
+    uint32_t next_seq; // 下一个到达序号
+    int push_timeout_ms; // 满时生产者最长等待时间（ORDERED/PARALLEL），0 表示立即丢弃
+    bool closed; // 已关闭，消费者取完剩余帧后返回 NULL
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty; // 有帧可取（或关闭）
+    pthread_cond_t not_full; // 有槽位可写
+    protocol_stream_stats_t stats; // 统计
+} protocol_stream_t;
+
+/**
+ * @brief 分流器
+ */
+typedef struct
+{
+    protocol_stream_t* routes[PROTOCOL_TYPE_ID(0xFF) + 1]; // 按类型 ID 索引
+    protocol_stream_t* fallback; // 未配置类型的去向，NULL 时丢弃
+    uint32_t unrouted; // 无去向被丢弃的帧数
+} protocol_demux_t;
+
+/**
+ * 初始化队列
+ * @param stream   队列
+ * @param policy   队列策略
+ * @param capacity 槽位数
+ * @return 是否成功
+ */
+bool protocol_stream_init(protocol_stream_t* stream, protocol_stream_policy_t policy, uint16_t capacity);
+
+/**
+ * 设置 ORDERED/PARALLEL 队列满时生产者的最长等待时间（默认 0，立即丢弃）
+ * @param timeout_ms 最长等待时间（毫秒），负数按 0 处理；等待期间接收器不会交付其他帧
+ */
+void protocol_stream_set_push_timeout(protocol_stream_t* stream, int timeout_ms);
+
+/**
+ * 复制一帧入队，不会无限等待（见 protocol_stream_set_push_timeout）
+ * @param times 帧时间戳，可为 NULL
+ * @return 0-成功，-1-队列满、负载超过 PROTOCOL_STREAM_FRAME_MAX 或队列已关闭（计入 stats.dropped）
+ */
+int protocol_stream_push(protocol_stream_t* stream, uint8_t type, const uint8_t* data, uint16_t len,
+                         const protocol_frame_times_t* times);
+
+/**
+ * 取出一帧
+ * @param stream     队列
+ * @param timeout_ms 最长等待时间，负数一直等待
+ * @return 帧，超时或队列已关闭且取空时返回 NULL
+ */
+protocol_stream_frame_t* protocol_stream_pop(protocol_stream_t* stream, int timeout_ms);
+
+/**
+ * 处理完毕，归还槽位
+ */
+void protocol_stream_release(protocol_stream_t* stream, protocol_stream_frame_t* frame);
+
+/**
+ * 关闭队列，唤醒所有等待者
+ */
+void protocol_stream_close(protocol_stream_t* stream);
+
+/**
+ * 释放队列（调用前所有消费者须已退出）
+ */
+void protocol_stream_destroy(protocol_stream_t* stream);
+
+/**
+ * 初始化分流器（所有类型无去向）
+ */
+void protocol_demux_init(protocol_demux_t* demux);
+
+/**
+ * 把类型（按 PROTOCOL_TYPE_ID 匹配，压缩标志不影响路由）分到队列
+ * @param stream 队列，NULL 取消该类型的路由
+ */
+void protocol_demux_route(protocol_demux_t* demux, uint8_t type, protocol_stream_t* stream);
+
+/**
+ * 设置未配置类型的去向
+ */
+void protocol_demux_set_fallback(protocol_demux_t* demux, protocol_stream_t* stream);
+
+/**
+ * 分发一帧
+ * @param times 帧时间戳，可为 NULL
+ * @return 0-已入队，-1-无去向或被丢弃
+ */
+int protocol_demux_dispatch(protocol_demux_t* demux, uint8_t type, const uint8_t* data, uint16_t len,
+                            const protocol_frame_times_t* times);
+
+/**
+ * 把分流器挂到接收器上（通过 protocol_receiver_set_handler）
+ */
+void protocol_demux_attach(protocol_demux_t* demux, protocol_receiver* receiver);
+
+#endif //PKT_DEMUX_H
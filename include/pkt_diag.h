@@ -0,0 +1,126 @@
+#ifndef PKT_DIAG_H
+#define PKT_DIAG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 诊断通道（代替热路径上的 printf）
+ *
+ * 热路径只调用 protocol_diag_report：按错误码原子计数，并按错误码限速
+ * （每个时间窗口最多 burst 条），未被限速的事件放入无锁队列后立即返回，不格式化、不做 I/O。
+ * 事件由调用方 protocol_diag_drain 或后台线程（protocol_diag_start）取出交给 sink 格式化输出；
+ * 被限速的条数附在同一错误码的下一条事件上。队列满时只计数。
+ * 未调用 protocol_diag_init 时只计数，不排队。
+ */
+
+typedef enum
+{
+    PROTOCOL_DIAG_PACK_TOO_LONG, // 打包时负载过长，arg 为负载长度
+    PROTOCOL_DIAG_PACK_NO_MEMORY, // 打包时分配失败，arg 为帧长度
+    PROTOCOL_DIAG_RX_DISCARDED, // 接收缓冲区已满，丢弃新数据，arg 为丢弃字节数
+    PROTOCOL_DIAG_TXQ_REJECTED, // 发送队列满，拒绝新帧，arg 为队列中的帧数
+    PROTOCOL_DIAG_PACK_BAD_TYPE, // 打包时类型无效，arg 为类型
+    PROTOCOL_DIAG_CODE_COUNT
+} protocol_diag_code_t;
+
+// 默认限速：每个错误码每秒最多 10 条
+#define PROTOCOL_DIAG_DEFAULT_BURST 10
+#define PROTOCOL_DIAG_DEFAULT_INTERVAL_MS 1000
+
+/**
+ * @brief 一条诊断事件
+ */
+typedef struct
+{
+    uint64_t ts_ns; // 单调时钟纳秒
+    uint64_t arg; // 错误码相关的参数
+    uint64_t suppressed; // 上一条同错误码事件之后被限速的条数
+    uint32_t code; // protocol_diag_code_t
+} protocol_diag_event_t;
+
+/**
+ * @brief 诊断统计
+ */
+typedef struct
+{
+    uint64_t counts[PROTOCOL_DIAG_CODE_COUNT]; // 各错误码发生次数（含被限速的）
+    uint64_t suppressed; // 被限速的事件数
+    uint64_t queue_dropped; // 队列满丢弃的事件数
+    uint64_t delivered; // 已交给 sink 的事件数
+} protocol_diag_stats_t;
+
+/**
+ * @brief 事件输出函数（在 drain 的调用线程或后台线程中调用）
+ */
+typedef void (*protocol_diag_sink_fn)(void* user, const protocol_diag_event_t* event);
+
+/**
+ * 初始化事件队列和限速参数（在报告线程启动前调用；关闭后再次初始化沿用原队列，忽略 queue_capacity）
+ * @param queue_capacity 队列容量（帧数）
+ * @param burst          每个时间窗口每个错误码最多排队的事件数
+ * @param interval_ms    时间窗口
+ * @return 是否成功
+ */
+bool protocol_diag_init(uint32_t queue_capacity, uint32_t burst, uint32_t interval_ms);
+
+/**
+ * 设置事件输出函数，NULL 表示取出后丢弃
+ */
+void protocol_diag_set_sink(protocol_diag_sink_fn sink, void* user);
+
+/**
+ * 报告一次事件（热路径，无锁、无 I/O）
+ */
+void protocol_diag_report(protocol_diag_code_t code, uint64_t arg);
+
+/**
+ * 在调用线程中取出排队的事件并交给 sink
+ * @return 处理的事件数
+ */
+size_t protocol_diag_drain(void);
+
+/**
+ * 启动后台线程，每 period_ms 取出一次事件
+ * @return 是否成功
+ */
+bool protocol_diag_start(uint32_t period_ms);
+
+/**
+ * 停止后台线程（停止前取出剩余事件）
+ */
+void protocol_diag_stop(void);
+
+/**
+ * 停止后台线程，之后只计数不排队；队列不释放，报告线程可以仍在运行
+ */
+void protocol_diag_shutdown(void);
+
+/**
+ * 获取统计
+ */
+void protocol_diag_get_stats(protocol_diag_stats_t* stats);
+
+/**
+ * 清零统计和限速状态
+ */
+void protocol_diag_reset_stats(void);
+
+/**
+ * 错误码名称
+ */
+const char* protocol_diag_name(protocol_diag_code_t code);
+
+/**
+ * 把事件格式化为一行文本（不含换行）
+ * @return 写入的字符数（不含结尾的 0）
+ */
+int protocol_diag_format(const protocol_diag_event_t* event, char* out, size_t cap);
+
+/**
+ * 输出到 stderr 的 sink
+ */
+void protocol_diag_stderr_sink(void* user, const protocol_diag_event_t* event);
+
+#endif //PKT_DIAG_H
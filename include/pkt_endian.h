@@ -0,0 +1,80 @@
+#ifndef PKT_ENDIAN_H
+#define PKT_ENDIAN_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * 线上字节序编解码
+ *
+ * 协议所有多字节字段均为小端。以下函数对任意对齐的地址读写小端整数：
+ * 小端平台上 memcpy 会被编译成一条非对齐 load/store（x86、ARMv7+/AArch64），
+ * 大端平台上额外一条字节交换指令，都不含运行时分支，也不依赖 packed 结构体。
+ */
+
+#if !defined(__BYTE_ORDER__)
+#error "pkt_endian.h: 编译器未定义 __BYTE_ORDER__，无法确定平台字节序"
+#elif __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define PKT_BIG_ENDIAN 1
+#define PKT_LE16(x) __builtin_bswap16(x)
+#define PKT_LE32(x) __builtin_bswap32(x)
+#define PKT_LE64(x) __builtin_bswap64(x)
+#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PKT_BIG_ENDIAN 0
+#define PKT_LE16(x) (x)
+#define PKT_LE32(x) (x)
+#define PKT_LE64(x) (x)
+#else
+#error "pkt_endian.h: 不支持的平台字节序"
+#endif
+
+static inline uint8_t pkt_load_u8(const uint8_t* p)
+{
+    return p[0];
+}
+
+static inline uint16_t pkt_load_le16(const uint8_t* p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return PKT_LE16(v);
+}
+
+static inline uint32_t pkt_load_le32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return PKT_LE32(v);
+}
+
+static inline uint64_t pkt_load_le64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return PKT_LE64(v);
+}
+
+static inline void pkt_store_u8(uint8_t* p, const uint8_t v)
+{
+    p[0] = v;
+}
+
+static inline void pkt_store_le16(uint8_t* p, uint16_t v)
+{
+    v = PKT_LE16(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline void pkt_store_le32(uint8_t* p, uint32_t v)
+{
+    v = PKT_LE32(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline void pkt_store_le64(uint8_t* p, uint64_t v)
+{
+    v = PKT_LE64(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+#endif //PKT_ENDIAN_H
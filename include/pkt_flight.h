@@ -0,0 +1,113 @@
+#ifndef PKT_FLIGHT_H
+#define PKT_FLIGHT_H
+
+#include "pkt_protocol.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 飞行记录器：固定大小的环，保存最近 N 条原始帧和解析事件
+ *
+ * 记录时只做一次原子自增、一次时钟读取和一次 memcpy，不格式化、不加锁、不分配，
+ * 可以常开在热路径上。多个线程可以同时记录；导出时跳过正在写入的条目。
+ * 需要时（或收到信号时）导出，只使用 write(2)，可以在信号处理函数中调用。
+ *
+ * 二进制导出格式（小端）:
+ *   文件头(16): magic "SPKTFLT1"(8) + version(4) + 记录器容量(4)，随后的条目直到文件结尾
+ *   条目头(24): seq(8) + ts_ns(8) + event(1) + type(1) + len(2) + caplen(2) + reserved(2)，随后是 caplen 字节数据
+ * 文本导出格式: 每条一行 "seq ts_ns EVENT type=0x.. len=..: 55 AA ..."
+ */
+
+#define PROTOCOL_FLIGHT_MAGIC "SPKTFLT1"
+#define PROTOCOL_FLIGHT_VERSION 1
+#define PROTOCOL_FLIGHT_FILE_HEADER_LEN 16
+#define PROTOCOL_FLIGHT_ENTRY_HEADER_LEN 24
+// 每条记录保存的最大字节数（可容纳一个完整帧）
+#define PROTOCOL_FLIGHT_CAPTURE_LEN PROTOCOL_MAX_FRAME_LEN
+
+typedef enum
+{
+    PROTOCOL_FLIGHT_RX, // 收到完整帧
+    PROTOCOL_FLIGHT_TX, // 发送帧
+    PROTOCOL_FLIGHT_CRC_ERROR, // CRC 校验失败（数据为出错前最多一帧长度的原始字节）
+    PROTOCOL_FLIGHT_FORMAT_ERROR, // 长度越界或帧尾错误（同上）
+    PROTOCOL_FLIGHT_DROP, // 接收缓冲区丢弃数据（len 为丢弃字节数，超过 65535 时截断）
+    PROTOCOL_FLIGHT_USER, // 应用自定义事件
+} protocol_flight_event_t;
+
+typedef enum
+{
+    PROTOCOL_FLIGHT_DUMP_BINARY,
+    PROTOCOL_FLIGHT_DUMP_HEX,
+} protocol_flight_format_t;
+
+/**
+ * @brief 一条记录
+ */
+typedef struct
+{
+    atomic_uint_fast64_t seq; // 序号 + 1，0 表示空或正在写入
+    uint64_t ts_ns; // 单调时钟纳秒
+    uint8_t event; // protocol_flight_event_t
+    uint8_t type; // 帧类型
+    uint16_t len; // 原始长度
+    uint16_t caplen; // 保存的长度
+    uint8_t data[PROTOCOL_FLIGHT_CAPTURE_LEN]; // 保存的数据
+} protocol_flight_entry_t;
+
+/**
+ * @brief 飞行记录器
+ */
+typedef struct
+{
+    protocol_flight_entry_t* entries; // 环形条目
+    uint32_t capacity; // 条目数（2 的幂）
+    atomic_uint_fast64_t next; // 下一个序号
+} protocol_flight_t;
+
+/**
+ * 初始化飞行记录器
+ * @param flight   记录器
+ * @param capacity 保存的最近条目数（向上取整为 2 的幂）
+ * @return 是否成功
+ */
+bool protocol_flight_init(protocol_flight_t* flight, uint32_t capacity);
+
+/**
+ * 记录一条事件
+ * @param flight 记录器
+ * @param event  事件类型
+ * @param type   帧类型
+ * @param data   原始数据，超过 PROTOCOL_FLIGHT_CAPTURE_LEN 的部分截断
+ * @param len    数据长度
+ */
+void protocol_flight_record(protocol_flight_t* flight, protocol_flight_event_t event, uint8_t type,
+                            const uint8_t* data, uint16_t len);
+
+/**
+ * 按从旧到新的顺序导出
+ * @param flight 记录器
+ * @param fd     输出文件描述符
+ * @param format 导出格式
+ * @return 导出的条目数，写入失败返回 -1
+ */
+int protocol_flight_dump(protocol_flight_t* flight, int fd, protocol_flight_format_t format);
+
+/**
+ * 收到信号时导出（进程内只能有一个记录器绑定信号）
+ * @param flight 记录器
+ * @param signo  信号，如 SIGUSR1
+ * @param fd     输出文件描述符
+ * @param format 导出格式
+ * @return 0-成功，-1-失败
+ */
+int protocol_flight_install_signal(protocol_flight_t* flight, int signo, int fd, protocol_flight_format_t format);
+
+/**
+ * 释放飞行记录器（调用前须解除信号绑定或确保不会再收到信号）
+ */
+void protocol_flight_destroy(protocol_flight_t* flight);
+
+#endif //PKT_FLIGHT_H
@@ -0,0 +1,143 @@
+#ifndef PKT_FRAGMENT_H
+#define PKT_FRAGMENT_H
+
+#include "pkt_protocol.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 分片与重组
+ *
+ * 超过 PROTOCOL_MAX_DATA_LEN 的消息拆分为多个 PROTOCOL_TYPE_FRAGMENT 帧，分片负载格式:
+ *   msg_id(2) + index(2) + count(2) + 原始类型(1) + 分片数据
+ * 多字节字段均为小端。除最后一片外，每片数据长度固定为 PROTOCOL_FRAGMENT_DATA_LEN。
+ */
+
+// 分片头长度
+#define PROTOCOL_FRAGMENT_HEADER_LEN 7
+// 单个分片可携带的数据长度
+#define PROTOCOL_FRAGMENT_DATA_LEN (PROTOCOL_MAX_DATA_LEN - PROTOCOL_FRAGMENT_HEADER_LEN)
+
+/**
+ * @brief 分片帧输出函数，每打包好一个分片帧调用一次
+ * @return 0-成功，其他值中止发送
+ */
+typedef int (*fragment_emit)(void* user, const uint8_t* frame, uint16_t frame_len);
+
+/**
+ * @brief 重组完成的消息
+ */
+typedef struct
+{
+    uint8_t type; // 原始协议类型
+    uint16_t msg_id; // 消息ID
+    const uint8_t* data; // 消息数据（指向重组池内缓冲区）
+    uint32_t len; // 消息长度
+    uint16_t slot; // 所在重组槽位，保留消息时用于归还
+} protocol_message_t;
+
+/**
+ * @brief 消息回调
+ * @return true 表示保留缓冲区（零拷贝交付），稍后需调用 protocol_reassembler_release 归还；
+ *         false 表示回调返回后立即回收
+ */
+typedef bool (*message_callback)(const protocol_message_t* msg);
+
+/**
+ * @brief 重组槽位
+ */
+typedef struct
+{
+    uint8_t state; // 槽位状态 0-空闲 1-重组中 2-已交付被保留
+    uint8_t type; // 原始协议类型
+    uint16_t msg_id; // 消息ID
+    uint16_t frag_count; // 分片总数
+    uint16_t frag_received; // 已收到分片数
+    uint32_t total_len; // 消息总长度（收到最后一片后确定）
+    uint32_t deadline_ms; // 超时时间点
+    uint8_t* bitmap; // 分片接收位图
+    uint8_t* buffer; // 重组缓冲区
+} protocol_reassembly_slot_t;
+
+/**
+ * @brief 重组统计
+ */
+typedef struct
+{
+    uint32_t messages; // 重组完成的消息数
+    uint32_t fragments; // 收到的有效分片数
+    uint32_t duplicates; // 重复分片数
+    uint32_t timeouts; // 超时丢弃的消息数
+    uint32_t dropped; // 非法或无空闲槽位丢弃的分片数
+} protocol_reassembly_stats_t;
+
+/**
+ * @brief 分片重组器
+ */
+typedef struct
+{
+    protocol_reassembly_slot_t* slots; // 重组槽位（并发重组上限）
+    uint16_t max_slots; // 槽位数量
+    uint16_t max_fragments; // 单条消息最大分片数
+    uint32_t timeout_ms; // 重组超时时间
+    uint8_t* pool; // 缓冲池（所有槽位的缓冲区和位图一次性分配）
+    message_callback callback; // 消息回调
+    protocol_reassembly_stats_t stats; // 统计信息
+} protocol_reassembler_t;
+
+/**
+ * 将消息拆分为分片帧并逐个输出
+ * @param type     原始协议类型
+ * @param msg_id   消息ID（同一时间在途的消息需唯一）
+ * @param data     消息数据
+ * @param len      消息长度
+ * @param emit     分片帧输出函数
+ * @param user     输出函数上下文
+ * @return 发送的分片数，失败返回 -1
+ */
+int protocol_fragment_send(protocol_type_t type, uint16_t msg_id, const uint8_t* data, uint32_t len,
+                           fragment_emit emit, void* user);
+
+/**
+ * 初始化重组器
+ * @param reassembler     重组器
+ * @param max_slots       并发重组的消息上限
+ * @param max_message_len 单条消息最大长度
+ * @param timeout_ms      重组超时时间
+ * @param callback        消息回调
+ * @return 是否初始化成功
+ */
+bool protocol_reassembler_init(protocol_reassembler_t* reassembler, uint16_t max_slots, uint32_t max_message_len,
+                               uint32_t timeout_ms, message_callback callback);
+
+/**
+ * 处理一个分片帧负载（PROTOCOL_TYPE_FRAGMENT 帧的数据部分）
+ * @param reassembler 重组器
+ * @param payload     分片帧负载
+ * @param len         负载长度
+ * @param now_ms      当前时间（单调时钟，毫秒）
+ */
+void protocol_reassembler_on_fragment(protocol_reassembler_t* reassembler, const uint8_t* payload, uint16_t len,
+                                      uint32_t now_ms);
+
+/**
+ * 丢弃超时未完成的重组
+ * @param reassembler 重组器
+ * @param now_ms      当前时间（单调时钟，毫秒）
+ */
+void protocol_reassembler_poll(protocol_reassembler_t* reassembler, uint32_t now_ms);
+
+/**
+ * 归还回调中保留的消息缓冲区
+ * @param reassembler 重组器
+ * @param msg         回调中收到的消息
+ */
+void protocol_reassembler_release(protocol_reassembler_t* reassembler, const protocol_message_t* msg);
+
+/**
+ * 销毁重组器，释放缓冲池
+ * @param reassembler 重组器
+ */
+void protocol_reassembler_destroy(protocol_reassembler_t* reassembler);
+
+#endif //PKT_FRAGMENT_H
@@ -0,0 +1,92 @@
+#ifndef PKT_POOL_H
+#define PKT_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 内存分配
+ *
+ * 库内所有动态内存都经 protocol_malloc/protocol_realloc/protocol_free 分配，
+ * 默认转发到 malloc/realloc/free，可通过 protocol_set_allocator 整体替换。
+ *
+ * 帧缓冲池 protocol_pool_allocator() 按协议帧长度划分大小等级，
+ * 每个线程持有本地缓存，只有在本地缓存耗尽或溢出时才批量访问全局空闲链表；
+ * 超过最大等级的请求（如接收缓冲区）直接转发给系统分配器。
+ * 池中内存只在进程内复用，不归还系统，长期运行时驻留内存保持在峰值以内。
+ */
+
+// 大小等级数量
+#define PROTOCOL_POOL_CLASS_COUNT 3
+// 各等级块大小：小帧（ACK/控制）、中等负载、最大帧
+#define PROTOCOL_POOL_CLASS_SIZES {32, 64, 128}
+
+/**
+ * @brief 可替换的分配器
+ */
+typedef struct
+{
+    void* (*alloc)(void* ctx, size_t size);
+    void* (*realloc)(void* ctx, void* ptr, size_t size);
+    void (*free)(void* ctx, void* ptr);
+    void* ctx; // 分配器上下文
+} protocol_allocator_t;
+
+/**
+ * @brief 单个大小等级的统计
+ */
+typedef struct
+{
+    uint32_t block_size; // 块大小
+    uint64_t allocs; // 累计分配次数
+    uint64_t frees; // 累计释放次数
+    uint64_t in_use; // 当前占用块数
+    uint64_t capacity; // 已向系统申请的块数
+    uint64_t refills; // 线程缓存从全局链表批量获取的次数
+} protocol_pool_class_stats_t;
+
+/**
+ * @brief 帧缓冲池统计
+ */
+typedef struct
+{
+    protocol_pool_class_stats_t classes[PROTOCOL_POOL_CLASS_COUNT];
+    uint64_t large_allocs; // 超出最大等级、转发给系统分配器的次数
+    uint64_t large_frees;
+} protocol_pool_stats_t;
+
+/**
+ * 替换库使用的分配器
+ * @param allocator 分配器，NULL 恢复为 malloc/realloc/free
+ * @note 需在创建任何接收器或打包任何帧之前调用，已分配的内存必须由同一分配器释放
+ */
+void protocol_set_allocator(const protocol_allocator_t* allocator);
+
+/**
+ * 按当前分配器申请内存
+ */
+void* protocol_malloc(size_t size);
+
+/**
+ * 按当前分配器调整内存大小
+ */
+void* protocol_realloc(void* ptr, size_t size);
+
+/**
+ * 按当前分配器释放内存（protocol_pack_frame 返回的帧也应由此释放）
+ */
+void protocol_free(void* ptr);
+
+/**
+ * 获取帧缓冲池分配器
+ * @return 进程内唯一的帧缓冲池分配器
+ */
+const protocol_allocator_t* protocol_pool_allocator(void);
+
+/**
+ * 获取帧缓冲池统计
+ * @param stats 输出统计
+ */
+void protocol_pool_get_stats(protocol_pool_stats_t* stats);
+
+#endif //PKT_POOL_H
@@ -1,4 +1,6 @@
 #pragma once
+#include "pkt_trace.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 /*
@@ -14,56 +16,39 @@
 #define PROTOCOL_MAX_DATA_LEN 108
 
 
-// 检测平台字节序列
-#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && defined(__ORDER_BIG_ENDIAN__)
-// GCC/Clang 风格的字节序检测
-#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
-#define IS_LITTLE_ENDIAN 1
-#else
-        #define IS_LITTLE_ENDIAN 0
-#endif
-#elif defined(_WIN32) || defined(_WIN64)
-    // Windows 平台默认为小端模式
-    #define IS_LITTLE_ENDIAN 1
-#else
-    // 运行时检测字节序
-    static int detect_endian() {
-        unsigned int x = 1;
-        return *(unsigned char*)&x == 1;
-    }
-#define IS_LITTLE_ENDIAN detect_endian()
-#endif
-
-
-// 字节序转换宏
-#define TO_LE16(x) (IS_LITTLE_ENDIAN ? (x) : htole16(x))
-#define TO_LE32(x) (IS_LITTLE_ENDIAN ? (x) : htole32(x))
-
-
 typedef enum
 {
     PROTOCOL_TYPE_MIN = 0x00, // 起始值
     PROTOCOL_TYPE_SENSOR = 0x01, // 传感器数据
     PROTOCOL_TYPE_CONTROL, // 控制指令
     PROTOCOL_TYPE_LOG, // 系统日志
+    PROTOCOL_TYPE_FRAGMENT, // 分片 @see pkt_fragment.h
+    PROTOCOL_TYPE_RELIABLE, // 可靠传输数据 @see pkt_reliable.h
+    PROTOCOL_TYPE_ACK, // 可靠传输确认 @see pkt_reliable.h
     PROTOCOL_TYPE_MAX // 结束值
 } protocol_type_t;
 
-/**
- * @brief 协议头结构体
- * @note 柔性数组结构体，使用1byte对齐
- */
-#pragma pack(push, 1)
-typedef struct
-{
-    uint16_t header; // 帧头 - 0xAA55
-    uint8_t type; // 协议类型
-    uint16_t len; // 数据长度 最大支持65535
-    uint8_t data[0]; // 柔性数组，用于动态数据
-} protocol_header_t;
-#pragma pack(pop)
-
-#define PROTOCOL_HEADER_SIZE sizeof(protocol_header_t)
+// 类型字节标志位（低 6 位为 protocol_type_t）
+#define PROTOCOL_TYPE_FLAG_COMPRESSED 0x80 // 负载已压缩 @see pkt_compress.h
+#define PROTOCOL_TYPE_FLAG_CRC32C 0x40 // 帧尾使用 CRC32C(4) 代替 CRC16(2) @see pkt_crc.h
+// 本库的解析器同时接受两种帧尾，CRC32C 由发送方逐帧选择；
+// 旧版本和 pkt_protocol_static.h 只认识 CRC16，只有确认对端已升级后才能发送 CRC32C 帧
+#define PROTOCOL_TYPE_ID(type) ((type) & 0x3F)
+
+// 帧头各字段偏移: Header(2) + Type(1) + Len(2)，多字节字段均为小端 @see pkt_endian.h
+#define PROTOCOL_OFFSET_HEADER 0
+#define PROTOCOL_OFFSET_TYPE 2
+#define PROTOCOL_OFFSET_LEN 3
+#define PROTOCOL_HEADER_SIZE 5
+// 帧尾部开销: CRC(2) + Tail(2)
+#define PROTOCOL_TRAILER_SIZE (sizeof(uint16_t) * 2)
+// CRC32C 帧的尾部开销: CRC32C(4) + Tail(2)
+#define PROTOCOL_CRC32C_TRAILER_SIZE (sizeof(uint32_t) + sizeof(uint16_t))
+// 按类型字节取尾部开销
+#define PROTOCOL_TRAILER_SIZE_OF(type) \
+    (((type) & PROTOCOL_TYPE_FLAG_CRC32C) ? PROTOCOL_CRC32C_TRAILER_SIZE : PROTOCOL_TRAILER_SIZE)
+// 最大帧长度（按较长的 CRC32C 帧尾计算）
+#define PROTOCOL_MAX_FRAME_LEN (PROTOCOL_HEADER_SIZE + PROTOCOL_MAX_DATA_LEN + PROTOCOL_CRC32C_TRAILER_SIZE)
 
 /**
  * @brief 协议帧结构体
@@ -74,7 +59,7 @@ typedef struct
     uint8_t type; // 协议类型
     uint16_t len; // 数据长度 最大支持65535
     uint8_t* data; // 数据内容 (动态分配)
-    uint16_t crc; // CRC16 校验值
+    uint32_t crc; // 校验值（CRC16，或 CRC32C 帧的 CRC32C）
     uint16_t tail; // 帧尾 (固定值 0x55AA)
 } protocol_frame_t;
 
@@ -91,11 +76,23 @@ typedef enum
     STATE_WAIT_DATA,
     STATE_WAIT_CRC_1,
     STATE_WAIT_CRC_2,
+    STATE_WAIT_CRC_3, // 仅 CRC32C 帧
+    STATE_WAIT_CRC_4, // 仅 CRC32C 帧
     STATE_WAIT_TAIL_1,
     STATE_WAIT_TAIL_2
 } parse_state_t;
 
 
+/**
+ * @brief 解析统计（protocol_parser_reset 时保留）
+ */
+typedef struct
+{
+    uint32_t frames; // 解析成功的帧数
+    uint32_t crc_errors; // CRC 校验失败的帧数
+    uint32_t format_errors; // 长度越界或帧尾错误的帧数
+} protocol_parse_stats_t;
+
 /**
  * @brief 协议解析器
  */
@@ -104,6 +101,9 @@ typedef struct
     parse_state_t state; // 协议解析状态
     protocol_frame_t frame; // 解析出来的协议头
     uint16_t data_index; // 解析出来的数据
+    protocol_parse_stats_t stats; // 解析统计
+    bool timestamps; // 是否记录帧时间戳（protocol_parser_reset 时保留）
+    protocol_frame_times_t times; // 当前帧的时间戳
 } protocol_parser_t;
 
 
@@ -113,12 +113,26 @@ typedef struct
  */
 void protocol_parser_init(protocol_parser_t* parser);
 
+/**
+ * 开启或关闭帧时间戳（识别到帧头、负载接收完毕时各读一次单调时钟）
+ * @param parser 协议解析器
+ * @param enable 是否开启
+ */
+void protocol_parser_enable_timestamps(protocol_parser_t* parser, bool enable);
+
 /**
  * 重置协议解析器
  * @param parser 协议解析器
  */
 void protocol_parser_reset(protocol_parser_t* parser);
 
+/**
+ * 当前未完成帧已消耗的字节数（从帧头第一个字节算起）
+ * @param parser 协议解析器
+ * @return 字节数，等待帧头时为 0
+ */
+uint16_t protocol_parser_pending(const protocol_parser_t* parser);
+
 /**
  * 单字节解析
  * @param parser 协议解析器
@@ -130,7 +144,7 @@ int protocol_parse_byte(protocol_parser_t* parser, uint8_t byte);
 /**
  * @brief 打包协议帧
  *
- * @param type 协议类型
+ * @param type 协议类型，带 PROTOCOL_TYPE_FLAG_CRC32C 时使用 CRC32C 帧尾
  * @param data 数据内容
  * @param data_len 数据长度
  * @param frame_len 协议帧数据长度
@@ -138,6 +152,19 @@ int protocol_parse_byte(protocol_parser_t* parser, uint8_t byte);
 uint8_t* protocol_pack_frame(protocol_type_t type, const uint8_t* data,
                              uint16_t data_len, uint16_t* frame_len);
 
+/**
+ * @brief 打包协议帧到调用方提供的缓冲区（不分配内存）
+ *
+ * @param type 协议类型，带 PROTOCOL_TYPE_FLAG_CRC32C 时使用 CRC32C 帧尾
+ * @param data 数据内容
+ * @param data_len 数据长度
+ * @param out 输出缓冲区
+ * @param out_cap 输出缓冲区大小，PROTOCOL_MAX_FRAME_LEN 即可容纳任意帧
+ * @return 协议帧长度，失败返回 0
+ */
+uint16_t protocol_pack_frame_into(protocol_type_t type, const uint8_t* data,
+                                  uint16_t data_len, uint8_t* out, uint16_t out_cap);
+
 /**
  * CRC16-CCITT 校验
  * @param data   待校验数据 Frame Header + Data
@@ -146,20 +173,6 @@ uint8_t* protocol_pack_frame(protocol_type_t type, const uint8_t* data,
 uint16_t crc16_ccitt(const uint8_t* data, uint16_t length);
 
 // ----------------- Tools -------------------
-/**
- * Host to Little Endian 16
- * @param value   Host Endian
- * @return        Little Endian
- */
-uint16_t htole16(uint16_t value);
-
-/**
- * Host to Little Endian 32
- * @param x       Host Endian
- * @return        Little Endian
- */
-uint32_t htole32(uint32_t x);
-
 /**
  * Print Hex Data
  * @param data Frame data
@@ -6,6 +6,10 @@
 #define PKT_PROTOCOL_BUF_H
 
 #include "pkt_protocol.h"
+#include "pkt_compress.h"
+#include "pkt_flight.h"
+#include "pkt_trace.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -18,6 +22,29 @@ extern void* (*mock_realloc)(void* ptr, size_t size);
  */
 typedef void (*frame_callback)(uint8_t type, const uint8_t* data, uint16_t len);
 
+/**
+ * @brief 带用户上下文的帧处理函数（设置后代替 frame_callback）
+ * times 为帧时间戳，未开启时间戳时为 NULL @see protocol_receiver_enable_timestamps
+ */
+typedef void (*frame_handler)(void* user, uint8_t type, const uint8_t* data, uint16_t len,
+                              const protocol_frame_times_t* times);
+
+/**
+ * @brief 拉取模式下取出的帧（指向接收器内部存储，不拷贝）
+ * 在下一次调用任何接收器接口之前有效
+ */
+typedef struct
+{
+    uint8_t type; // 协议类型（不含 CRC32C 标志，压缩帧解压后为原始类型）
+    uint16_t len; // 数据长度
+    const uint8_t* data; // 数据
+    protocol_frame_times_t times; // 帧时间戳，未开启时间戳时全为 0
+} protocol_frame_view_t;
+
+// 默认扩容上限
+#define PROTOCOL_RECEIVER_DEFAULT_MAX_SIZE (1024 * 1024)
+// 缓冲区下限：至少能容纳两个最大帧，保证半帧加新数据总能放下
+#define PROTOCOL_RECEIVER_MIN_SIZE (2 * PROTOCOL_MAX_FRAME_LEN)
 
 /**
  * @brief 协议接收器结构体（封装缓冲区、解析状态）
@@ -25,29 +52,123 @@ typedef void (*frame_callback)(uint8_t type, const uint8_t* data, uint16_t len);
 typedef struct
 {
     uint8_t* buffer; // 动态分配的缓冲区
-    uint16_t buffer_size; // 缓冲区总大小
-    uint16_t write_pos; // 当前写入位置
-    uint16_t processed_pos; // 跟踪解析处理位置
+    size_t buffer_size; // 缓冲区总大小
+    size_t write_pos; // 当前写入位置
+    size_t processed_pos; // 跟踪解析处理位置
+    size_t initial_size; // 初始大小（收缩下限）
+    size_t max_size; // 扩容上限
+    uint32_t shrink_after; // 连续多少次追加后占用仍不超过 1/4 时收缩一半，0 表示不收缩
+    uint32_t low_usage_count; // 连续低占用次数
+    uint64_t dropped_bytes; // 扩容失败丢弃的字节数
     protocol_parser_t parser; // 协议解析器
     frame_callback callback; // 用户回调函数
+    frame_handler handler; // 带上下文的处理函数，非 NULL 时优先
+    void* handler_user; // 处理函数的用户上下文
+    protocol_compressor_t* compressor; // 解压上下文，NULL 时压缩帧原样上报
+    protocol_latency_hist_t* latency; // 帧头到交付的延迟直方图，NULL 时不统计
+    protocol_flight_t* flight; // 飞行记录器，NULL 时不记录
+    bool pull; // 拉取模式：追加时只存数据，由 protocol_receiver_next_frame 解析
+    uint8_t* pull_scratch; // 拉取模式下的解压缓冲区（按需分配）
 } protocol_receiver;
 
 
 /**
  * @brief 初始化协议接收器
  * @param receiver  接收器对象
- * @param buf_size  缓冲区大小（需大于最大帧长度）
+ * @param buf_size  初始缓冲区大小（小于 PROTOCOL_RECEIVER_MIN_SIZE 时按需扩容）
  * @param callback  数据帧接收完成回调函数
  */
-void protocol_receiver_init(protocol_receiver* receiver, uint16_t buf_size, frame_callback callback);
+void protocol_receiver_init(protocol_receiver* receiver, size_t buf_size, frame_callback callback);
+
+/**
+ * @brief 设置缓冲区大小策略
+ * @param receiver      接收器对象
+ * @param max_size      扩容上限（不小于 PROTOCOL_RECEIVER_MIN_SIZE），超过时分块写入、边写边解析
+ * @param shrink_after  突发结束后，连续多少次追加占用不超过 1/4 才收缩一半（最小到初始大小），0 表示不收缩
+ */
+void protocol_receiver_set_limits(protocol_receiver* receiver, size_t max_size, uint32_t shrink_after);
 
 /**
- * @brief 向接收器追加新接收到的数据
+ * @brief 向接收器追加新接收到的数据（长度不受缓冲区大小限制）
  * @param receiver  接收器对象
  * @param data      新数据指针
  * @param len       新数据长度
  */
-void protocol_receiver_append(protocol_receiver* receiver, const uint8_t* data, uint16_t len);
+void protocol_receiver_append(protocol_receiver* receiver, const uint8_t* data, size_t len);
+
+/**
+ * @brief 预留可直接写入的缓冲区空间（供 read 等直接写入接收器存储，省去一次拷贝）
+ * @param receiver  接收器对象
+ * @param len       需要的空间
+ * @return 写入位置，在 protocol_receiver_commit 之前不能再调用其他接收器接口；超过扩容上限或扩容失败返回 NULL
+ */
+uint8_t* protocol_receiver_reserve(protocol_receiver* receiver, size_t len);
+
+/**
+ * @brief 提交已写入预留空间的数据并尝试解析
+ * @param receiver  接收器对象
+ * @param len       实际写入长度（不超过预留长度）
+ */
+void protocol_receiver_commit(protocol_receiver* receiver, size_t len);
+
+/**
+ * @brief 设置带用户上下文的帧处理函数（如 protocol_demux_attach），NULL 恢复使用 frame_callback
+ * @param receiver  接收器对象
+ * @param handler   处理函数
+ * @param user      用户上下文
+ */
+void protocol_receiver_set_handler(protocol_receiver* receiver, frame_handler handler, void* user);
+
+/**
+ * @brief 切换拉取模式
+ * 拉取模式下 protocol_receiver_append/commit 只保存数据，不解析、不回调；
+ * 由调用方在自己的循环中用 protocol_receiver_next_frame(s) 逐帧或成批取出。
+ * 取出前数据留在缓冲区中，缓冲区达到扩容上限后新数据被丢弃，调用方应先取帧再追加（背压）。
+ * 关闭拉取模式后，下一次追加时解析缓冲区中剩余的数据并回调。
+ * @param receiver  接收器对象
+ * @param enable    是否开启
+ */
+void protocol_receiver_set_pull(protocol_receiver* receiver, bool enable);
+
+/**
+ * @brief 拉取下一帧（拉取模式）
+ * @param receiver  接收器对象
+ * @param view      输出帧，在下一次调用任何接收器接口之前有效
+ * @return 是否取到帧，缓冲区中没有完整帧时返回 false
+ */
+bool protocol_receiver_next_frame(protocol_receiver* receiver, protocol_frame_view_t* view);
+
+/**
+ * @brief 成批拉取帧（拉取模式）
+ * 返回的各帧都在下一次调用任何接收器接口之前有效；解压后的帧使用同一个解压缓冲区，总是批次中的最后一帧
+ * @param receiver  接收器对象
+ * @param views     输出帧数组
+ * @param max       最多取出的帧数
+ * @return 取出的帧数，0 表示没有完整帧
+ */
+size_t protocol_receiver_next_frames(protocol_receiver* receiver, protocol_frame_view_t* views, size_t max);
+
+/**
+ * @brief 开启或关闭帧时间戳
+ * @param receiver  接收器对象
+ * @param enable    是否开启（开启后每帧读 3 次单调时钟）
+ * @param latency   帧头到交付的延迟直方图（NULL 表示不统计），须由调用方先 protocol_latency_reset
+ */
+void protocol_receiver_enable_timestamps(protocol_receiver* receiver, bool enable, protocol_latency_hist_t* latency);
+
+/**
+ * @brief 设置飞行记录器，记录收到的帧、解析错误和丢弃的数据
+ * @param receiver  接收器对象
+ * @param flight    飞行记录器（NULL 表示关闭）
+ */
+void protocol_receiver_set_flight(protocol_receiver* receiver, protocol_flight_t* flight);
+
+/**
+ * @brief 设置解压上下文，压缩帧解压后以原始类型回调
+ * @param receiver    接收器对象
+ * @param compressor  解压上下文（NULL 表示关闭解压）
+ */
+void protocol_receiver_set_compressor(protocol_receiver* receiver, protocol_compressor_t* compressor);
 
 /**
  * @brief 销毁接收器，释放资源
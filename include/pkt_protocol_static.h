@@ -0,0 +1,302 @@
+#ifndef PKT_PROTOCOL_STATIC_H
+#define PKT_PROTOCOL_STATIC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * 编译期配置的纯头文件解析器/打包器
+ *
+ * 所有函数均为 static inline，不依赖 pkt_protocol.c，不做动态分配。配置在编译期固定，
+ * 编译器可以把状态机常量折叠并内联进调用方的读循环。包含本文件前可定义：
+ *
+ *   PKT_STATIC_MAX_DATA_LEN   最大负载长度（默认 108，与 PROTOCOL_MAX_DATA_LEN 相同）
+ *   PKT_STATIC_TYPE_VALID(t)  类型字节是否合法的常量表达式（默认全部合法），不合法时立即重新同步
+ *   PKT_STATIC_CRC            1-帧内带 CRC16（默认），0-省略 CRC 字段
+ *   PKT_STATIC_LEN_BYTES      长度字段字节数，2（默认）或 1
+ *
+ * 默认配置与 pkt_protocol.h 的帧格式完全一致（不支持 PROTOCOL_TYPE_FLAG_CRC32C 帧，这类帧计为 CRC 或格式错误）；
+ * 关闭 CRC 或使用 1 字节长度会改变帧格式，链路两端必须使用相同配置。每个编译单元只能使用一种配置。
+ */
+
+#ifndef PKT_STATIC_MAX_DATA_LEN
+#define PKT_STATIC_MAX_DATA_LEN 108
+#endif
+#ifndef PKT_STATIC_TYPE_VALID
+#define PKT_STATIC_TYPE_VALID(t) 1
+#endif
+#ifndef PKT_STATIC_CRC
+#define PKT_STATIC_CRC 1
+#endif
+#ifndef PKT_STATIC_LEN_BYTES
+#define PKT_STATIC_LEN_BYTES 2
+#endif
+
+#if PKT_STATIC_LEN_BYTES != 1 && PKT_STATIC_LEN_BYTES != 2
+#error "PKT_STATIC_LEN_BYTES must be 1 or 2"
+#endif
+#if PKT_STATIC_MAX_DATA_LEN > (PKT_STATIC_LEN_BYTES == 1 ? 0xFF : 0xFFFF)
+#error "PKT_STATIC_MAX_DATA_LEN does not fit in the length field"
+#endif
+
+#define PKT_STATIC_HEADER_SIZE (3 + PKT_STATIC_LEN_BYTES)
+#define PKT_STATIC_TRAILER_SIZE (2 * PKT_STATIC_CRC + 2)
+#define PKT_STATIC_MAX_FRAME_LEN (PKT_STATIC_HEADER_SIZE + PKT_STATIC_MAX_DATA_LEN + PKT_STATIC_TRAILER_SIZE)
+
+// pkt_static_pack 以 uint16_t 返回帧长
+#if PKT_STATIC_MAX_FRAME_LEN > 0xFFFF
+#error "PKT_STATIC_MAX_FRAME_LEN does not fit in uint16_t"
+#endif
+
+// 帧头 0xAA55、帧尾 0x55AA 的线上字节（小端）
+#define PKT_STATIC_HEAD_0 0x55
+#define PKT_STATIC_HEAD_1 0xAA
+#define PKT_STATIC_TAIL_0 0xAA
+#define PKT_STATIC_TAIL_1 0x55
+
+typedef enum
+{
+    PKT_STATIC_WAIT_HEADER_1,
+    PKT_STATIC_WAIT_HEADER_2,
+    PKT_STATIC_WAIT_TYPE,
+    PKT_STATIC_WAIT_LENGTH_1,
+    PKT_STATIC_WAIT_LENGTH_2,
+    PKT_STATIC_WAIT_DATA,
+    PKT_STATIC_WAIT_CRC_1,
+    PKT_STATIC_WAIT_CRC_2,
+    PKT_STATIC_WAIT_TAIL_1,
+    PKT_STATIC_WAIT_TAIL_2
+} pkt_static_state_t;
+
+/**
+ * @brief 解析器（负载直接存放在结构体内）
+ */
+typedef struct
+{
+    uint8_t state; // pkt_static_state_t
+    uint8_t type; // 类型字节
+    uint16_t len; // 负载长度
+    uint16_t index; // 已接收负载字节
+#if PKT_STATIC_CRC
+    uint16_t crc; // 边接收边计算的 CRC
+    uint16_t frame_crc; // 帧内携带的 CRC
+#endif
+    uint32_t frames; // 解析成功的帧数
+    uint32_t crc_errors; // CRC 校验失败的帧数
+    uint32_t format_errors; // 类型非法、长度越界或帧尾错误的帧数
+    uint8_t data[PKT_STATIC_MAX_DATA_LEN]; // 负载
+} pkt_static_parser_t;
+
+/**
+ * @brief 帧回调（pkt_static_feed 使用），帧内容在 parser->type/len/data
+ */
+typedef void (*pkt_static_frame_fn)(void* user, const pkt_static_parser_t* parser);
+
+// CRC16-CCITT（初值 0xFFFF，多项式 0x1021），逐字节更新
+static inline uint16_t pkt_static_crc_update(uint16_t crc, const uint8_t byte)
+{
+    crc ^= (uint16_t)byte << 8;
+    for (int i = 0; i < 8; i++)
+    {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+static inline void pkt_static_parser_init(pkt_static_parser_t* parser)
+{
+    memset(parser, 0, sizeof(*parser) - sizeof(parser->data));
+    parser->state = PKT_STATIC_WAIT_HEADER_1;
+}
+
+static inline void pkt_static_crc_feed(pkt_static_parser_t* parser, const uint8_t byte)
+{
+#if PKT_STATIC_CRC
+    parser->crc = pkt_static_crc_update(parser->crc, byte);
+#else
+    (void)parser;
+    (void)byte;
+#endif
+}
+
+// 负载接收完毕后的下一状态
+#define PKT_STATIC_AFTER_DATA (PKT_STATIC_CRC ? PKT_STATIC_WAIT_CRC_1 : PKT_STATIC_WAIT_TAIL_1)
+
+static inline void pkt_static_format_error(pkt_static_parser_t* parser)
+{
+    parser->format_errors++;
+    parser->state = PKT_STATIC_WAIT_HEADER_1;
+}
+
+// 长度字段接收完毕
+static inline void pkt_static_length_done(pkt_static_parser_t* parser)
+{
+    if (parser->len > PKT_STATIC_MAX_DATA_LEN)
+    {
+        pkt_static_format_error(parser);
+        return;
+    }
+    parser->index = 0;
+    parser->state = parser->len > 0 ? PKT_STATIC_WAIT_DATA : PKT_STATIC_AFTER_DATA;
+}
+
+/**
+ * 解析一个字节
+ * @return 1-收到完整帧（内容在 parser->type/len/data，下一次调用前有效），0-未完成
+ */
+static inline int pkt_static_parse_byte(pkt_static_parser_t* parser, const uint8_t byte)
+{
+    switch (parser->state)
+    {
+    case PKT_STATIC_WAIT_HEADER_1:
+        if (byte == PKT_STATIC_HEAD_0)
+        {
+            parser->state = PKT_STATIC_WAIT_HEADER_2;
+        }
+        break;
+    case PKT_STATIC_WAIT_HEADER_2:
+        if (byte == PKT_STATIC_HEAD_1)
+        {
+#if PKT_STATIC_CRC
+            parser->crc = pkt_static_crc_update(pkt_static_crc_update(0xFFFF, PKT_STATIC_HEAD_0), PKT_STATIC_HEAD_1);
+#endif
+            parser->state = PKT_STATIC_WAIT_TYPE;
+        }
+        else if (byte != PKT_STATIC_HEAD_0)
+        {
+            parser->state = PKT_STATIC_WAIT_HEADER_1;
+        }
+        break;
+    case PKT_STATIC_WAIT_TYPE:
+        if (!(PKT_STATIC_TYPE_VALID(byte)))
+        {
+            pkt_static_format_error(parser);
+            break;
+        }
+        parser->type = byte;
+        pkt_static_crc_feed(parser, byte);
+        parser->state = PKT_STATIC_WAIT_LENGTH_1;
+        break;
+    case PKT_STATIC_WAIT_LENGTH_1:
+        parser->len = byte;
+        pkt_static_crc_feed(parser, byte);
+        if (PKT_STATIC_LEN_BYTES == 2)
+        {
+            parser->state = PKT_STATIC_WAIT_LENGTH_2;
+        }
+        else
+        {
+            pkt_static_length_done(parser);
+        }
+        break;
+    case PKT_STATIC_WAIT_LENGTH_2:
+        parser->len |= (uint16_t)(byte << 8);
+        pkt_static_crc_feed(parser, byte);
+        pkt_static_length_done(parser);
+        break;
+    case PKT_STATIC_WAIT_DATA:
+        parser->data[parser->index++] = byte;
+        pkt_static_crc_feed(parser, byte);
+        if (parser->index == parser->len)
+        {
+            parser->state = PKT_STATIC_AFTER_DATA;
+        }
+        break;
+#if PKT_STATIC_CRC
+    case PKT_STATIC_WAIT_CRC_1:
+        parser->frame_crc = byte;
+        parser->state = PKT_STATIC_WAIT_CRC_2;
+        break;
+    case PKT_STATIC_WAIT_CRC_2:
+        parser->frame_crc |= (uint16_t)(byte << 8);
+        parser->state = PKT_STATIC_WAIT_TAIL_1;
+        break;
+#endif
+    case PKT_STATIC_WAIT_TAIL_1:
+        if (byte != PKT_STATIC_TAIL_0)
+        {
+            pkt_static_format_error(parser);
+            break;
+        }
+        parser->state = PKT_STATIC_WAIT_TAIL_2;
+        break;
+    case PKT_STATIC_WAIT_TAIL_2:
+        if (byte != PKT_STATIC_TAIL_1)
+        {
+            pkt_static_format_error(parser);
+            break;
+        }
+        parser->state = PKT_STATIC_WAIT_HEADER_1;
+#if PKT_STATIC_CRC
+        if (parser->crc != parser->frame_crc)
+        {
+            parser->crc_errors++;
+            break;
+        }
+#endif
+        parser->frames++;
+        return 1;
+    default:
+        parser->state = PKT_STATIC_WAIT_HEADER_1;
+        break;
+    }
+    return 0;
+}
+
+/**
+ * 解析一段数据，每收到一帧调用一次 on_frame
+ * @return 收到的帧数
+ */
+static inline size_t pkt_static_feed(pkt_static_parser_t* parser, const uint8_t* data, const size_t len,
+                                     const pkt_static_frame_fn on_frame, void* user)
+{
+    size_t frames = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (pkt_static_parse_byte(parser, data[i]))
+        {
+            on_frame(user, parser);
+            frames++;
+        }
+    }
+    return frames;
+}
+
+/**
+ * 打包一帧到调用方缓冲区
+ * @return 帧长度，类型非法、负载过长或缓冲区不足时返回 0
+ */
+static inline uint16_t pkt_static_pack(const uint8_t type, const uint8_t* data, const uint16_t data_len,
+                                       uint8_t* out, const size_t out_cap)
+{
+    const size_t frame_len = PKT_STATIC_HEADER_SIZE + (size_t)data_len + PKT_STATIC_TRAILER_SIZE;
+    if (!(PKT_STATIC_TYPE_VALID(type)) || data_len > PKT_STATIC_MAX_DATA_LEN || out_cap < frame_len)
+    {
+        return 0;
+    }
+    uint8_t* p = out;
+    *p++ = PKT_STATIC_HEAD_0;
+    *p++ = PKT_STATIC_HEAD_1;
+    *p++ = type;
+    *p++ = (uint8_t)(data_len & 0xFF);
+#if PKT_STATIC_LEN_BYTES == 2
+    *p++ = (uint8_t)(data_len >> 8);
+#endif
+    memcpy(p, data, data_len);
+    p += data_len;
+#if PKT_STATIC_CRC
+    uint16_t crc = 0xFFFF;
+    for (const uint8_t* q = out; q < p; q++)
+    {
+        crc = pkt_static_crc_update(crc, *q);
+    }
+    *p++ = (uint8_t)(crc & 0xFF);
+    *p++ = (uint8_t)(crc >> 8);
+#endif
+    *p++ = PKT_STATIC_TAIL_0;
+    *p++ = PKT_STATIC_TAIL_1;
+    return (uint16_t)frame_len;
+}
+
+#endif //PKT_PROTOCOL_STATIC_H
@@ -0,0 +1,145 @@
+#ifndef PKT_RELIABLE_H
+#define PKT_RELIABLE_H
+
+#include "pkt_protocol.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 滑动窗口可靠传输（可选）
+ *
+ * 数据帧 PROTOCOL_TYPE_RELIABLE 负载: seq(2) + 原始类型(1) + 数据
+ * 确认帧 PROTOCOL_TYPE_ACK 负载:      cum_ack(2) + sack(4)
+ *   cum_ack 为接收端期望的下一个序号（之前的全部已收到），
+ *   sack 第 i 位表示序号 cum_ack + 1 + i 已收到（选择确认）。
+ * 多字节字段均为小端，序号按 16 位回绕比较。
+ */
+
+#define PROTOCOL_RELIABLE_HEADER_LEN 3
+#define PROTOCOL_RELIABLE_DATA_LEN (PROTOCOL_MAX_DATA_LEN - PROTOCOL_RELIABLE_HEADER_LEN)
+#define PROTOCOL_ACK_LEN 6
+// 最大窗口（受 SACK 位图宽度限制）
+#define PROTOCOL_RELIABLE_MAX_WINDOW 32
+
+/**
+ * @brief 帧发送函数（把打包好的帧写到链路）
+ * @return 0-成功
+ */
+typedef int (*reliable_send)(void* user, const uint8_t* frame, uint16_t frame_len);
+
+/**
+ * @brief 按序交付回调
+ */
+typedef void (*reliable_deliver)(void* user, uint8_t type, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief 发送窗口槽位
+ */
+typedef struct
+{
+    uint8_t in_use; // 是否等待确认
+    uint8_t sacked; // 已被选择确认
+    uint8_t fast_retx; // 已因 SACK 空洞快速重传
+    uint8_t type; // 原始类型
+    uint16_t seq; // 序号
+    uint16_t len; // 数据长度
+    uint32_t sent_ms; // 最近一次发送时间
+    uint8_t data[PROTOCOL_RELIABLE_DATA_LEN];
+} protocol_reliable_tx_slot_t;
+
+/**
+ * @brief 接收窗口槽位（乱序缓存）
+ */
+typedef struct
+{
+    uint8_t valid;
+    uint8_t type;
+    uint16_t len;
+    uint8_t data[PROTOCOL_RELIABLE_DATA_LEN];
+} protocol_reliable_rx_slot_t;
+
+/**
+ * @brief 可靠传输统计
+ */
+typedef struct
+{
+    uint32_t sent; // 首次发送的数据帧
+    uint32_t retransmits; // 重传次数
+    uint32_t acks_sent; // 发送的确认帧
+    uint32_t acks_received; // 收到的确认帧
+    uint32_t delivered; // 按序交付的数据帧
+    uint32_t duplicates; // 重复数据帧
+    uint32_t out_of_window; // 窗口外丢弃的数据帧
+    uint32_t malformed; // 长度非法（不足帧头或负载超过 PROTOCOL_RELIABLE_DATA_LEN）丢弃的数据帧
+} protocol_reliable_stats_t;
+
+/**
+ * @brief 可靠传输端点（收发双向）
+ */
+typedef struct
+{
+    uint16_t window; // 窗口大小 1~PROTOCOL_RELIABLE_MAX_WINDOW
+    uint32_t rto_ms; // 重传超时
+    // 发送方向
+    uint16_t snd_una; // 最早未确认序号
+    uint16_t snd_nxt; // 下一个发送序号
+    protocol_reliable_tx_slot_t tx[PROTOCOL_RELIABLE_MAX_WINDOW];
+    // 接收方向
+    uint16_t rcv_nxt; // 期望接收的下一个序号
+    protocol_reliable_rx_slot_t rx[PROTOCOL_RELIABLE_MAX_WINDOW];
+
+    reliable_send send; // 帧发送函数
+    reliable_deliver deliver; // 交付回调
+    void* user; // 回调上下文
+    protocol_reliable_stats_t stats; // 统计信息
+} protocol_reliable_t;
+
+/**
+ * 初始化可靠传输端点
+ * @param ep      端点
+ * @param window  窗口大小（超过上限时截断）
+ * @param rto_ms  重传超时
+ * @param send    帧发送函数
+ * @param deliver 按序交付回调
+ * @param user    回调上下文
+ */
+void protocol_reliable_init(protocol_reliable_t* ep, uint16_t window, uint32_t rto_ms,
+                            reliable_send send, reliable_deliver deliver, void* user);
+
+/**
+ * 发送一条可靠数据
+ * @param ep     端点
+ * @param type   原始协议类型
+ * @param data   数据
+ * @param len    数据长度，不超过 PROTOCOL_RELIABLE_DATA_LEN
+ * @param now_ms 当前时间（单调时钟，毫秒）
+ * @return 0-已进入发送窗口（链路发送失败时由重传定时器补发），-1-窗口已满（需稍后重试），-2-参数非法
+ */
+int protocol_reliable_send(protocol_reliable_t* ep, protocol_type_t type, const uint8_t* data, uint16_t len,
+                           uint32_t now_ms);
+
+/**
+ * 发送窗口是否还有空位
+ * @param ep 端点
+ */
+bool protocol_reliable_can_send(const protocol_reliable_t* ep);
+
+/**
+ * 处理收到的帧（在 frame_callback 中调用），非可靠传输帧直接忽略
+ * @param ep     端点
+ * @param type   帧类型
+ * @param data   帧负载
+ * @param len    负载长度
+ * @param now_ms 当前时间（单调时钟，毫秒）
+ */
+void protocol_reliable_on_frame(protocol_reliable_t* ep, uint8_t type, const uint8_t* data, uint16_t len,
+                                uint32_t now_ms);
+
+/**
+ * 驱动重传定时器，需周期性调用
+ * @param ep     端点
+ * @param now_ms 当前时间（单调时钟，毫秒）
+ */
+void protocol_reliable_poll(protocol_reliable_t* ep, uint32_t now_ms);
+
+#endif //PKT_RELIABLE_H
@@ -0,0 +1,29 @@
+#ifndef PKT_SCAN_H
+#define PKT_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 帧头快速定位
+ *
+ * 在字节流中查找帧头字节对 0x55 0xAA（FRAME_HEADER 的小端表示）。
+ * x86 上按 CPU 能力选择 AVX2（每次 32 字节）或 SSE2（每次 16 字节），其他平台使用标量实现。
+ * 接收器在解析器等待帧头时用它跳过噪声；离线处理抓包数据时也可以直接调用。
+ */
+
+/**
+ * 查找第一个候选帧头
+ * @param data 数据
+ * @param len  数据长度
+ * @return 第一个 0x55 0xAA 的偏移；若没有完整字节对但末字节为 0x55（帧头可能跨越数据块），
+ *         返回 len - 1；都没有时返回 len
+ */
+size_t protocol_scan_header(const uint8_t* data, size_t len);
+
+/**
+ * 标量实现（用于对比测试和基准）
+ */
+size_t protocol_scan_header_scalar(const uint8_t* data, size_t len);
+
+#endif //PKT_SCAN_H
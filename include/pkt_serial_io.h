@@ -0,0 +1,99 @@
+#ifndef PKT_SERIAL_IO_H
+#define PKT_SERIAL_IO_H
+
+#include "pkt_protocol_buf.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 多串口读写后端
+ *
+ * 编译时定义 PKT_HAVE_IO_URING 且内核支持时使用 io_uring：每个端口常驻一个读请求，
+ * 读数据直接落在 protocol_receiver 的缓冲区内；发送暂存区整体注册为固定缓冲区，
+ * 用 WRITE_FIXED 提交。一轮 serial_io_poll 内的所有请求通过一次 io_uring_enter 批量提交。
+ * 否则退化为 poll + read/write（端口 fd 会被设置为非阻塞）。
+ */
+
+// 单次读请求的长度
+#define SERIAL_IO_READ_CHUNK 512
+// 每个端口的发送暂存区大小
+#define SERIAL_IO_TX_BUFFER 4096
+
+typedef enum
+{
+    SERIAL_IO_BACKEND_POLL,
+    SERIAL_IO_BACKEND_URING,
+} serial_io_backend_t;
+
+typedef struct
+{
+    int fd; // 串口文件描述符
+    protocol_receiver* receiver; // 接收器
+    uint8_t* tx_buf; // 发送暂存区
+    size_t tx_len; // 暂存区待发送长度
+    size_t tx_inflight; // 已提交、尚未完成的写长度（仅 io_uring）
+    bool read_armed; // 是否有读请求在途（仅 io_uring）
+    bool closed; // 读到 EOF 或出错
+    uint64_t rx_bytes; // 累计接收字节
+    uint64_t tx_bytes; // 累计发送字节
+    uint64_t rx_stalls; // 接收器缓冲区无空间（达到上限或拉取模式下未被取走）而未能读取的次数
+} serial_io_port_t;
+
+typedef struct serial_uring serial_uring_t;
+
+typedef struct
+{
+    serial_io_backend_t backend; // 实际使用的后端
+    serial_io_port_t* ports; // 端口表
+    uint16_t port_count; // 已添加端口数
+    uint16_t max_ports; // 端口上限
+    uint8_t* tx_pool; // 所有端口的发送暂存区（一次分配，便于整体注册）
+    serial_uring_t* uring; // io_uring 上下文
+    uint64_t syscalls; // 读写相关的系统调用次数
+} serial_io_t;
+
+/**
+ * 初始化
+ * @param io           上下文
+ * @param max_ports    端口上限
+ * @param prefer_uring 是否优先使用 io_uring，不可用时自动退化
+ * @return 是否成功
+ */
+bool serial_io_init(serial_io_t* io, uint16_t max_ports, bool prefer_uring);
+
+/**
+ * 添加端口
+ * @param io       上下文
+ * @param fd       已配置好的串口（或伪终端）文件描述符，由调用者负责关闭
+ * @param receiver 已初始化的接收器，端口存在期间不能再直接调用其 append/reserve
+ * @return 端口号，失败返回 -1
+ */
+int serial_io_add_port(serial_io_t* io, int fd, protocol_receiver* receiver);
+
+/**
+ * 暂存一帧待发送数据，在下一次 serial_io_poll 中批量写出
+ * @param io   上下文
+ * @param port 端口号
+ * @param data 帧数据（通常来自 protocol_pack_frame_into）
+ * @param len  帧长度
+ * @return 0-成功，-1-暂存区已满或端口无效
+ */
+int serial_io_send(serial_io_t* io, int port, const uint8_t* data, size_t len);
+
+/**
+ * 提交待发送数据和读请求，并处理完成的读写
+ * @param io         上下文
+ * @param timeout_ms 无事件时最长等待时间，0 不等待，负数一直等待
+ * @return 本轮处理的完成事件数，出错返回 -1
+ */
+int serial_io_poll(serial_io_t* io, int timeout_ms);
+
+/**
+ * 释放资源（不关闭端口 fd）
+ * @param io 上下文
+ */
+void serial_io_destroy(serial_io_t* io);
+
+#endif //PKT_SERIAL_IO_H
@@ -0,0 +1,113 @@
+#ifndef PKT_SHM_H
+#define PKT_SHM_H
+
+#include "pkt_protocol_buf.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 本机共享内存帧广播（网关进程 -> 同机的多个订阅进程）
+ *
+ * 网关把接收器交付的帧写入共享内存中的环形槽位（每帧写一次），订阅者从共享内存读取后回调，
+ * 不经过 socket，增加订阅者不增加发布方的开销。发布方从不等待订阅者：落后超过一圈的订阅者丢帧并计数。
+ * 每个槽位带序号（帧序号 + 1，0 表示正在写入），订阅者把负载复制到本地后再确认序号未变才回调，
+ * 复制期间被覆盖的帧丢弃并计数，回调不会看到不完整的数据。
+ * 订阅者空闲时在共享的 futex 上睡眠；发布方只有在有订阅者睡眠时才调用 FUTEX_WAKE，忙碌时没有系统调用。
+ *
+ * 共享内存可以用名字（shm_open，任意进程按名字打开）或匿名 memfd（通过 fork 继承或 SCM_RIGHTS 传递 fd）。
+ */
+
+// 默认槽位数
+#define PROTOCOL_SHM_DEFAULT_SLOTS 1024
+// 每个槽位可容纳的最大负载（接收器可能交付解压后的帧）
+#define PROTOCOL_SHM_MAX_PAYLOAD PROTOCOL_MAX_UNCOMPRESSED_LEN
+
+/**
+ * @brief 发布方（单线程写入）
+ */
+typedef struct
+{
+    int fd; // 共享内存文件描述符
+    void* base; // 映射基址
+    size_t size; // 映射大小
+    uint32_t mask; // 槽位数 - 1
+    uint64_t next; // 下一个帧序号
+    char name[64]; // shm_open 名字，匿名时为空
+} protocol_shm_pub_t;
+
+/**
+ * @brief 订阅方
+ */
+typedef struct
+{
+    void* base; // 映射基址
+    size_t size; // 映射大小
+    uint32_t mask; // 槽位数 - 1
+    uint64_t next; // 下一个要读取的帧序号
+    uint64_t delivered; // 已回调的帧数
+    uint64_t lost; // 落后超过一圈丢失的帧数
+    uint64_t torn; // 读取期间被覆盖而丢弃的帧数
+} protocol_shm_sub_t;
+
+/**
+ * 创建共享内存环
+ * @param pub   发布方
+ * @param name  shm_open 名字（如 "/spkt_gateway"），已存在时先删除再新建；NULL 时创建匿名 memfd，通过 pub->fd 传给订阅者
+ * @param slots 槽位数（向上取整为 2 的幂），0 使用默认值
+ * @return 是否成功
+ */
+bool protocol_shm_create(protocol_shm_pub_t* pub, const char* name, uint32_t slots);
+
+/**
+ * 发布一帧（拷贝进共享内存一次，之后所有订阅者共享这一份）
+ * @return 是否成功（负载超过 PROTOCOL_SHM_MAX_PAYLOAD 时失败）
+ */
+bool protocol_shm_publish(protocol_shm_pub_t* pub, uint8_t type, const uint8_t* data, uint16_t len);
+
+/**
+ * 把发布方挂到接收器上，接收器交付的每一帧都发布出去（通过 protocol_receiver_set_handler）
+ */
+void protocol_shm_attach(protocol_shm_pub_t* pub, protocol_receiver* receiver);
+
+/**
+ * 解除映射、关闭文件；名字仍指向本环时同时删除名字（已被新发布方重建的名字保留，已打开的订阅者不受影响）
+ */
+void protocol_shm_destroy(protocol_shm_pub_t* pub);
+
+/**
+ * 按名字打开共享内存环，从当前位置开始接收（不回放历史帧）
+ * @return 是否成功
+ */
+bool protocol_shm_open(protocol_shm_sub_t* sub, const char* name);
+
+/**
+ * 通过文件描述符打开共享内存环（fd 由调用方关闭）
+ * @return 是否成功
+ */
+bool protocol_shm_open_fd(protocol_shm_sub_t* sub, int fd);
+
+/**
+ * 取出已发布的帧并回调，负载指向本地副本，只在回调期间有效
+ * @param sub      订阅方
+ * @param callback 回调函数
+ * @param max      最多处理的帧数
+ * @return 回调的帧数
+ */
+size_t protocol_shm_poll(protocol_shm_sub_t* sub, frame_callback callback, size_t max);
+
+/**
+ * 等待新帧
+ * @param sub        订阅方
+ * @param timeout_ms 超时，负数表示一直等待
+ * @return 是否有新帧
+ */
+bool protocol_shm_wait(protocol_shm_sub_t* sub, int timeout_ms);
+
+/**
+ * 解除映射
+ */
+void protocol_shm_close(protocol_shm_sub_t* sub);
+
+#endif //PKT_SHM_H
@@ -0,0 +1,70 @@
+#ifndef PKT_TRACE_H
+#define PKT_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * 帧时间戳与延迟统计
+ *
+ * 解析器开启时间戳后（protocol_receiver_enable_timestamps），在识别到帧头、负载接收完毕、
+ * 交给处理函数前各记录一次单调时钟，随帧一起交给 frame_handler。
+ * 延迟直方图采用对数-线性分桶：每个 2 的幂区间再等分 PROTOCOL_LATENCY_SUB_BUCKETS 份，
+ * 相对误差不超过 1/PROTOCOL_LATENCY_SUB_BUCKETS，记录一次只需一次 clz 和一次自增。
+ * 直方图只允许一个写入线程，读取方应在写入线程内或停止写入后读取。
+ */
+
+#define PROTOCOL_LATENCY_SUB_BITS 3
+#define PROTOCOL_LATENCY_SUB_BUCKETS (1u << PROTOCOL_LATENCY_SUB_BITS)
+#define PROTOCOL_LATENCY_BUCKETS ((64 - PROTOCOL_LATENCY_SUB_BITS + 1) * PROTOCOL_LATENCY_SUB_BUCKETS)
+
+/**
+ * @brief 单帧时间戳（单调时钟纳秒，未开启时为 0）
+ */
+typedef struct
+{
+    uint64_t header_ns; // 识别到帧头
+    uint64_t payload_ns; // 负载接收完毕
+    uint64_t dispatch_ns; // 交给处理函数前
+} protocol_frame_times_t;
+
+/**
+ * @brief 延迟直方图（纳秒）
+ */
+typedef struct
+{
+    uint64_t count; // 样本数
+    uint64_t sum_ns; // 样本总和
+    uint64_t min_ns; // 最小值
+    uint64_t max_ns; // 最大值
+    uint32_t buckets[PROTOCOL_LATENCY_BUCKETS]; // 各桶样本数
+} protocol_latency_hist_t;
+
+/**
+ * 当前单调时钟（纳秒）
+ */
+uint64_t protocol_trace_now_ns(void);
+
+/**
+ * 清空直方图
+ */
+void protocol_latency_reset(protocol_latency_hist_t* hist);
+
+/**
+ * 记录一个样本
+ */
+void protocol_latency_record(protocol_latency_hist_t* hist, uint64_t ns);
+
+/**
+ * 分位数
+ * @param hist     直方图
+ * @param quantile 0.0 ~ 1.0，如 0.99
+ * @return 该分位数所在桶的上界（纳秒），无样本时返回 0
+ */
+uint64_t protocol_latency_quantile(const protocol_latency_hist_t* hist, double quantile);
+
+/**
+ * 平均值（纳秒），无样本时返回 0
+ */
+uint64_t protocol_latency_mean(const protocol_latency_hist_t* hist);
+
+#endif //PKT_TRACE_H
@@ -0,0 +1,116 @@
+#ifndef PKT_TXQ_H
+#define PKT_TXQ_H
+
+#include "pkt_protocol.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 单端口非阻塞发送队列
+ *
+ * 生产者（任意线程）把帧放入队列后立即返回；I/O 线程在 fd 可写时调用 protocol_txq_flush，
+ * 一次 writev 最多写出 PROTOCOL_TXQ_MAX_IOV 帧，并记录部分写入的位置。
+ * 队列字节数涨到高水位时通知生产者暂停，回落到低水位时通知恢复。
+ */
+
+// 单次 writev 的最大帧数
+#define PROTOCOL_TXQ_MAX_IOV 64
+
+/**
+ * @brief 背压通知
+ * @param user      用户上下文
+ * @param throttled true-达到高水位，应暂停生产；false-回落到低水位，可恢复
+ */
+typedef void (*txq_backpressure)(void* user, bool throttled);
+
+/**
+ * @brief 队列中的一帧
+ */
+typedef struct
+{
+    uint16_t len;
+    uint8_t data[PROTOCOL_MAX_FRAME_LEN];
+} protocol_txq_frame_t;
+
+/**
+ * @brief 发送统计
+ */
+typedef struct
+{
+    uint32_t frames; // 已完整写出的帧
+    uint64_t bytes; // 已写出的字节
+    uint32_t writev_calls; // writev 调用次数
+    uint32_t partial_writes; // 部分写入次数
+    uint32_t rejected; // 队列满被拒绝的帧
+} protocol_txq_stats_t;
+
+/**
+ * @brief 发送队列
+ */
+typedef struct
+{
+    int fd; // 输出 fd（初始化时设为非阻塞）
+    protocol_txq_frame_t* frames; // 帧环形队列
+    uint16_t capacity; // 队列容量（帧）
+    uint16_t head; // 队首下标
+    uint16_t count; // 队列中的帧数
+    uint16_t head_offset; // 队首帧已写出的字节数
+    size_t queued_bytes; // 尚未写出的字节数
+    size_t high_watermark; // 高水位（字节）
+    size_t low_watermark; // 低水位（字节）
+    uint16_t high_frames; // 帧数高水位（容量的 3/4），小帧占满队列前也能触发背压
+    uint16_t low_frames; // 帧数低水位（容量的 1/4）
+    bool throttled; // 当前是否处于背压状态
+    txq_backpressure backpressure; // 背压通知，可为 NULL
+    void* user; // 通知的用户上下文
+    pthread_mutex_t lock; // 保护队列状态（生产者与 I/O 线程可能不同）
+    protocol_txq_stats_t stats; // 统计
+} protocol_txq_t;
+
+/**
+ * 初始化发送队列
+ * @param txq            队列
+ * @param fd             输出 fd
+ * @param capacity       队列容量（帧）
+ * @param high_watermark 高水位（字节），0 表示按最大帧长计算的容量的 3/4
+ * @param low_watermark  低水位（字节），需小于高水位
+ * 字节数或帧数（容量的 3/4）任一达到高水位即进入背压，两者都回落到低水位以下才解除
+ * @param backpressure   背压通知，可为 NULL
+ * @param user           通知的用户上下文
+ * @return 是否成功
+ */
+bool protocol_txq_init(protocol_txq_t* txq, int fd, uint16_t capacity, size_t high_watermark,
+                       size_t low_watermark, txq_backpressure backpressure, void* user);
+
+/**
+ * 复制一帧已打包数据入队（不阻塞）
+ * @return 0-成功，-1-队列满或帧过长
+ */
+int protocol_txq_push(protocol_txq_t* txq, const uint8_t* frame, uint16_t len);
+
+/**
+ * 直接在队列中打包一帧（省去一次拷贝，不阻塞）
+ * @return 0-成功，-1-队列满或参数无效
+ */
+int protocol_txq_pack(protocol_txq_t* txq, protocol_type_t type, const uint8_t* data, uint16_t data_len);
+
+/**
+ * 在 fd 可写时写出队列数据，直到队列清空或内核缓冲区满
+ * @return 本次写出的字节数，写出错误返回 -1
+ */
+long protocol_txq_flush(protocol_txq_t* txq);
+
+/**
+ * 队列是否有待写数据（用于决定是否关注 POLLOUT）
+ */
+bool protocol_txq_pending(protocol_txq_t* txq);
+
+/**
+ * 释放队列（不关闭 fd，未写出的数据被丢弃）
+ */
+void protocol_txq_destroy(protocol_txq_t* txq);
+
+#endif //PKT_TXQ_H
@@ -0,0 +1,109 @@
+//
+// 变长记录环形缓冲区
+//
+
+#ifndef RECORD_RING_H
+#define RECORD_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 单生产者单消费者的变长记录环：每条记录为 8 字节长度头 + 数据，在缓冲区中连续存放（8 字节对齐）。
+ * 尾部剩余空间放不下下一条记录时写入填充记录并绕回开头，因此每条记录总是连续的，
+ * 生产者可以直接在环内组装记录（Reserve/Commit），消费者直接在环内读取（Peek/Release），
+ * 全程无内存分配、无拷贝。用于解析线程与处理线程之间传递解码后的帧。
+ */
+
+// 记录头长度
+#define RECORD_RING_HEADER_SIZE 8
+// 缓存行大小（生产者、消费者位置分别独占一行）
+#define RECORD_RING_CACHE_LINE 64
+
+typedef struct {
+    uint8_t *buffer; // 动态分配的缓冲区
+    uint32_t capacity; // 缓冲区容量（8 的倍数）
+    uint32_t maxRecord; // 单条记录数据的最大长度
+    _Alignas(RECORD_RING_CACHE_LINE) atomic_size_t head; // 写位置（单调递增，仅生产者修改）
+    size_t reserveOffset; // 当前预留记录的起始位置（生产者私有）
+    uint32_t reserveLength; // 当前预留长度
+    bool reserved; // 是否有未提交的预留
+    _Alignas(RECORD_RING_CACHE_LINE) atomic_size_t tail; // 读位置（单调递增，仅消费者修改）
+} RecordRing_t;
+
+/**
+ * 初始化记录环
+ * @param rr 记录环指针
+ * @param capacity 缓冲区容量（向上取整为 8 的倍数），单条记录最多约为容量的一半
+ * @return 是否初始化成功
+ */
+bool RecordRing_Init(RecordRing_t *rr, uint32_t capacity);
+
+/**
+ * 释放记录环
+ * @param rr 记录环指针
+ */
+void RecordRing_Free(RecordRing_t *rr);
+
+/**
+ * 预留一条记录的空间（生产者）
+ * @param rr 记录环指针
+ * @param length 最大数据长度
+ * @return 可直接写入的地址，空间不足或超过 maxRecord 时返回 NULL
+ * @note 在 RecordRing_Commit 之前不能再次预留
+ */
+uint8_t *RecordRing_Reserve(RecordRing_t *rr, uint32_t length);
+
+/**
+ * 提交预留的记录，对消费者可见（生产者）
+ * @param rr 记录环指针
+ * @param length 实际数据长度（不超过预留长度），可以为 0（只有记录头的空记录）
+ */
+void RecordRing_Commit(RecordRing_t *rr, uint32_t length);
+
+/**
+ * 放弃当前预留，不产生记录（生产者）
+ * @param rr 记录环指针
+ */
+void RecordRing_Abort(RecordRing_t *rr);
+
+/**
+ * 拷贝写入一条记录（Reserve + memcpy + Commit）
+ * @param rr 记录环指针
+ * @param data 数据
+ * @param length 数据长度
+ * @return 是否写入成功
+ */
+bool RecordRing_Write(RecordRing_t *rr, const uint8_t *data, uint32_t length);
+
+/**
+ * 查看最旧的一条记录（消费者）
+ * @param rr 记录环指针
+ * @param length 输出数据长度
+ * @return 记录数据地址（RecordRing_Release 之前有效），没有记录时返回 NULL
+ */
+uint8_t *RecordRing_Peek(RecordRing_t *rr, uint32_t *length);
+
+/**
+ * 释放最旧的一条记录（消费者，通常先 Peek；之前的填充记录会一并跳过）
+ * @param rr 记录环指针
+ */
+void RecordRing_Release(RecordRing_t *rr);
+
+/**
+ * 检查记录环是否为空
+ * @param rr 记录环指针
+ * @return 是否为空
+ */
+bool RecordRing_IsEmpty(RecordRing_t *rr);
+
+/**
+ * 获取已用空间（含记录头与填充）
+ * @param rr 记录环指针
+ * @return 已用字节数
+ */
+uint32_t RecordRing_GetUsedSpace(RecordRing_t *rr);
+
+#endif //RECORD_RING_H
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "pkt_protocol.h"
+#include "pkt_pool.h"
 #define FRAME_TAIL 0x55AA
 // 初始化解析器
 protocol_parser_t parser;
@@ -23,7 +24,7 @@ void process_received_data(uint8_t *buffer, uint16_t size) {
             }
             printf("\n");
 
-            free(parser.frame.data);
+            protocol_free(parser.frame.data);
             protocol_parser_init(&parser);
         }
     }
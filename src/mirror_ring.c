@@ -0,0 +1,150 @@
+//
+// 虚拟内存镜像环形缓冲区
+//
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "mirror_ring.h"
+
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
+
+/**
+ * 创建指定大小的共享内存文件
+ * @return 文件描述符，失败返回 -1
+ */
+static int createBackingFile(size_t size, bool hugePages) {
+    int fd = -1;
+#ifdef MFD_CLOEXEC
+    fd = memfd_create("mirror_ring", MFD_CLOEXEC | (hugePages ? MFD_HUGETLB : 0));
+#endif
+    if (fd < 0 && !hugePages) {
+        // 没有 memfd 时使用 POSIX 共享内存，打开后立即删除名字
+        char name[64];
+        snprintf(name, sizeof(name), "/mirror_ring_%ld_%p", (long) getpid(), (void *) &fd);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            shm_unlink(name);
+        }
+    }
+    if (fd >= 0 && ftruncate(fd, (off_t) size) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/**
+ * 按给定页大小建立两份背靠背映射
+ * @return 是否成功
+ */
+static bool mapMirror(MirrorRing_t *mr, size_t capacity, size_t pageSize, bool hugePages) {
+    capacity = (capacity + pageSize - 1) / pageSize * pageSize;
+    const int fd = createBackingFile(capacity, hugePages);
+    if (fd < 0) {
+        return false;
+    }
+    // 先保留一段连续地址（大页映射要求地址按大页对齐，多保留一页用于对齐）
+    const size_t reserveSize = 2 * capacity + (hugePages ? pageSize : 0);
+    void *reserve = mmap(NULL, reserveSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserve == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    uint8_t *base = (uint8_t *) (((uintptr_t) reserve + pageSize - 1) & ~(uintptr_t) (pageSize - 1));
+    const bool ok = mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+                    mmap(base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) !=
+                    MAP_FAILED;
+    // 映射建立后不再需要文件描述符
+    close(fd);
+    if (!ok) {
+        munmap(reserve, reserveSize);
+        return false;
+    }
+    mr->buffer = base;
+    mr->capacity = capacity;
+    mr->mapping = reserve;
+    mr->mappingSize = reserveSize;
+    mr->hugePages = hugePages;
+    return true;
+}
+
+// 初始化镜像环形缓冲区
+bool MirrorRing_Init(MirrorRing_t *mr, size_t capacity, bool hugePages) {
+    memset(mr, 0, sizeof(*mr));
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    if (hugePages && mapMirror(mr, capacity, MIRROR_RING_HUGE_PAGE_SIZE, true)) {
+        return true;
+    }
+    return mapMirror(mr, capacity, (size_t) sysconf(_SC_PAGESIZE), false);
+}
+
+// 释放镜像环形缓冲区
+void MirrorRing_Free(MirrorRing_t *mr) {
+    if (mr && mr->mapping) {
+        munmap(mr->mapping, mr->mappingSize);
+        memset(mr, 0, sizeof(*mr));
+    }
+}
+
+// 写入数据
+bool MirrorRing_Write(MirrorRing_t *mr, const uint8_t *data, size_t length) {
+    if (MirrorRing_GetFreeSpace(mr) < length) {
+        return false; // 缓冲区空间不足
+    }
+    memcpy(mr->buffer + mr->head % mr->capacity, data, length);
+    mr->head += length;
+    return true;
+}
+
+// 读取数据
+size_t MirrorRing_Read(MirrorRing_t *mr, uint8_t *data, size_t length) {
+    const size_t used = MirrorRing_GetUsedSpace(mr);
+    if (length > used) {
+        length = used;
+    }
+    memcpy(data, mr->buffer + mr->tail % mr->capacity, length);
+    mr->tail += length;
+    return length;
+}
+
+// 获取连续的可写区域
+uint8_t *MirrorRing_WritePtr(MirrorRing_t *mr, size_t *length) {
+    *length = MirrorRing_GetFreeSpace(mr);
+    return mr->buffer + mr->head % mr->capacity;
+}
+
+// 提交已写入的数据
+void MirrorRing_Produce(MirrorRing_t *mr, size_t length) {
+    const size_t free = MirrorRing_GetFreeSpace(mr);
+    mr->head += length < free ? length : free;
+}
+
+// 获取连续的可读区域
+const uint8_t *MirrorRing_ReadPtr(MirrorRing_t *mr, size_t *length) {
+    *length = MirrorRing_GetUsedSpace(mr);
+    return mr->buffer + mr->tail % mr->capacity;
+}
+
+// 丢弃已处理的数据
+void MirrorRing_Consume(MirrorRing_t *mr, size_t length) {
+    const size_t used = MirrorRing_GetUsedSpace(mr);
+    mr->tail += length < used ? length : used;
+}
+
+// 获取空闲空间
+size_t MirrorRing_GetFreeSpace(const MirrorRing_t *mr) {
+    return mr->capacity - (mr->head - mr->tail);
+}
+
+// 获取已用空间
+size_t MirrorRing_GetUsedSpace(const MirrorRing_t *mr) {
+    return mr->head - mr->tail;
+}
@@ -0,0 +1,168 @@
+//
+// 多生产者多消费者无锁帧队列
+//
+#include <stdlib.h>
+#include <string.h>
+#include "mpmc_ring.h"
+
+// 槽位头部：序号 == 位置 表示可写，== 位置 + 1 表示可读
+typedef struct {
+    atomic_size_t sequence;
+    uint16_t length;
+} MpmcRingSlot_t;
+
+#define SLOT_DATA_OFFSET ((sizeof(MpmcRingSlot_t) + 7) & ~(size_t) 7)
+
+static inline MpmcRingSlot_t *slotAt(const MpmcRing_t *ring, size_t pos) {
+    return (MpmcRingSlot_t *) (ring->slots + (size_t) (pos & ring->mask) * ring->slotStride);
+}
+
+static inline uint8_t *slotData(MpmcRingSlot_t *slot) {
+    return (uint8_t *) slot + SLOT_DATA_OFFSET;
+}
+
+// 初始化队列
+bool MpmcRing_Init(MpmcRing_t *ring, uint32_t capacity, uint16_t slotSize) {
+    memset(ring, 0, sizeof(*ring));
+    if (capacity > (1u << 31)) {
+        capacity = 1u << 31;
+    }
+    uint32_t rounded = 2;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    const size_t stride = (SLOT_DATA_OFFSET + slotSize + MPMC_RING_CACHE_LINE - 1) & ~(size_t) (MPMC_RING_CACHE_LINE - 1);
+    ring->slots = (uint8_t *) aligned_alloc(MPMC_RING_CACHE_LINE, stride * rounded);
+    if (ring->slots == NULL) {
+        return false;
+    }
+    ring->capacity = rounded;
+    ring->mask = rounded - 1;
+    ring->slotSize = slotSize;
+    ring->slotStride = (uint32_t) stride;
+    for (size_t i = 0; i < rounded; i++) {
+        MpmcRingSlot_t *slot = slotAt(ring, i);
+        atomic_init(&slot->sequence, i);
+        slot->length = 0;
+    }
+    atomic_init(&ring->enqueuePos, 0);
+    atomic_init(&ring->dequeuePos, 0);
+    return true;
+}
+
+// 释放队列
+void MpmcRing_Free(MpmcRing_t *ring) {
+    if (ring && ring->slots) {
+        free(ring->slots);
+        ring->slots = NULL;
+        ring->capacity = 0;
+    }
+}
+
+/**
+ * 从 pos 开始认领最多 count 个连续槽位（槽位序号 == 位置 + offset 表示状态就绪）
+ * @return 认领的槽位数，*pos 为认领的起始位置
+ */
+static uint32_t claim(MpmcRing_t *ring, atomic_size_t *cursor, size_t offset, uint32_t count, size_t *pos) {
+    size_t start = atomic_load_explicit(cursor, memory_order_relaxed);
+    for (;;) {
+        uint32_t n = 0;
+        intptr_t diff = 0;
+        while (n < count) {
+            const size_t seq = atomic_load_explicit(&slotAt(ring, start + n)->sequence, memory_order_acquire);
+            diff = (intptr_t) (seq - (start + n + offset));
+            if (diff != 0) {
+                break;
+            }
+            n++;
+        }
+        if (n == 0) {
+            if (diff < 0) {
+                return 0; // 入队时队列满，出队时队列空
+            }
+            // 其他线程已经越过 start，重新读取位置
+            start = atomic_load_explicit(cursor, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(cursor, &start, start + n,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            *pos = start;
+            return n;
+        }
+    }
+}
+
+// 入队一帧
+bool MpmcRing_Enqueue(MpmcRing_t *ring, const uint8_t *data, uint16_t length) {
+    return MpmcRing_EnqueueBatch(ring, &data, &length, 1) == 1;
+}
+
+// 批量入队
+uint32_t MpmcRing_EnqueueBatch(MpmcRing_t *ring, const uint8_t *const *frames, const uint16_t *lengths,
+                               uint32_t count) {
+    // 过长的帧及其之后的帧都不入队，保证入队结果是 frames 的前缀
+    for (uint32_t i = 0; i < count; i++) {
+        if (lengths[i] > ring->slotSize) {
+            count = i;
+            break;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+    size_t pos;
+    const uint32_t n = claim(ring, &ring->enqueuePos, 0, count, &pos);
+    for (uint32_t i = 0; i < n; i++) {
+        MpmcRingSlot_t *slot = slotAt(ring, pos + i);
+        memcpy(slotData(slot), frames[i], lengths[i]);
+        slot->length = lengths[i];
+        atomic_store_explicit(&slot->sequence, pos + i + 1, memory_order_release);
+    }
+    return n;
+}
+
+// 出队一帧
+bool MpmcRing_Dequeue(MpmcRing_t *ring, uint8_t *data, uint16_t *length) {
+    size_t pos;
+    if (claim(ring, &ring->dequeuePos, 1, 1, &pos) == 0) {
+        return false;
+    }
+    MpmcRingSlot_t *slot = slotAt(ring, pos);
+    *length = slot->length;
+    memcpy(data, slotData(slot), slot->length);
+    atomic_store_explicit(&slot->sequence, pos + ring->capacity, memory_order_release);
+    return true;
+}
+
+// 批量出队
+uint32_t MpmcRing_DequeueBatch(MpmcRing_t *ring, uint8_t *out, size_t outSize, uint16_t *lengths,
+                               uint32_t maxCount) {
+    // 按输出缓冲区能容纳的最坏情况限制一次认领的帧数，认领后的帧必须全部取出
+    const size_t fit = ring->slotSize ? outSize / ring->slotSize : maxCount;
+    if (fit < maxCount) {
+        maxCount = (uint32_t) fit;
+    }
+    if (maxCount == 0) {
+        return 0;
+    }
+    size_t pos;
+    const uint32_t n = claim(ring, &ring->dequeuePos, 1, maxCount, &pos);
+    size_t offset = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        MpmcRingSlot_t *slot = slotAt(ring, pos + i);
+        memcpy(out + offset, slotData(slot), slot->length);
+        offset += slot->length;
+        if (lengths) {
+            lengths[i] = slot->length;
+        }
+        atomic_store_explicit(&slot->sequence, pos + i + ring->capacity, memory_order_release);
+    }
+    return n;
+}
+
+// 获取队列中的帧数
+uint32_t MpmcRing_GetCount(MpmcRing_t *ring) {
+    const size_t tail = atomic_load_explicit(&ring->dequeuePos, memory_order_relaxed);
+    const size_t head = atomic_load_explicit(&ring->enqueuePos, memory_order_relaxed);
+    return head > tail ? (uint32_t) (head - tail) : 0;
+}
@@ -0,0 +1,188 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pkt_capture.h"
+#include "pkt_endian.h"
+#include "pkt_pool.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static int write_all(const int fd, const uint8_t* data, size_t len)
+{
+    while (len > 0)
+    {
+        const ssize_t n = write(fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+uint64_t protocol_capture_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+bool protocol_capture_open(protocol_capture_writer_t* writer, const char* path, size_t buffer_size)
+{
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = -1;
+    if (buffer_size < PROTOCOL_CAPTURE_RECORD_HEADER_LEN + UINT16_MAX)
+    {
+        // 保证任意一条记录都能整体放进缓冲区
+        buffer_size = PROTOCOL_CAPTURE_DEFAULT_BUFFER + PROTOCOL_CAPTURE_RECORD_HEADER_LEN + UINT16_MAX;
+    }
+    writer->buffer = protocol_malloc(buffer_size);
+    if (!writer->buffer)
+    {
+        return false;
+    }
+    writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0)
+    {
+        protocol_free(writer->buffer);
+        writer->buffer = NULL;
+        return false;
+    }
+    writer->capacity = buffer_size;
+
+    uint8_t* header = writer->buffer;
+    memcpy(header, PROTOCOL_CAPTURE_MAGIC, 8);
+    pkt_store_le32(header + 8, PROTOCOL_CAPTURE_VERSION);
+    pkt_store_le32(header + 12, 0);
+    writer->used = PROTOCOL_CAPTURE_FILE_HEADER_LEN;
+    return true;
+}
+
+int protocol_capture_write(protocol_capture_writer_t* writer, const uint16_t port_id, const uint64_t ts_ns,
+                           const uint8_t* data, const uint16_t len)
+{
+    const size_t need = PROTOCOL_CAPTURE_RECORD_HEADER_LEN + len;
+    if (writer->used + need > writer->capacity && protocol_capture_flush(writer) < 0)
+    {
+        return -1;
+    }
+    uint8_t* record = writer->buffer + writer->used;
+    pkt_store_le64(record, ts_ns);
+    pkt_store_le16(record + 8, port_id);
+    pkt_store_le16(record + 10, len);
+    pkt_store_le32(record + 12, 0);
+    memcpy(record + PROTOCOL_CAPTURE_RECORD_HEADER_LEN, data, len);
+    writer->used += need;
+    writer->records++;
+    writer->bytes += len;
+    return 0;
+}
+
+int protocol_capture_flush(protocol_capture_writer_t* writer)
+{
+    if (writer->used == 0)
+    {
+        return 0;
+    }
+    if (write_all(writer->fd, writer->buffer, writer->used) < 0)
+    {
+        return -1;
+    }
+    writer->used = 0;
+    return 0;
+}
+
+void protocol_capture_close(protocol_capture_writer_t* writer)
+{
+    if (writer->fd >= 0)
+    {
+        protocol_capture_flush(writer);
+        close(writer->fd);
+    }
+    protocol_free(writer->buffer);
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = -1;
+}
+
+bool protocol_capture_map(protocol_capture_reader_t* reader, const char* path)
+{
+    memset(reader, 0, sizeof(*reader));
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < PROTOCOL_CAPTURE_FILE_HEADER_LEN)
+    {
+        close(fd);
+        return false;
+    }
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
+    // 未知版本的记录格式可能不同，拒绝而不是按当前格式解析
+    if (memcmp(base, PROTOCOL_CAPTURE_MAGIC, 8) != 0 ||
+        pkt_load_le32((const uint8_t*)base + 8) != PROTOCOL_CAPTURE_VERSION)
+    {
+        munmap(base, (size_t)st.st_size);
+        return false;
+    }
+    reader->base = base;
+    reader->size = (size_t)st.st_size;
+    reader->pos = PROTOCOL_CAPTURE_FILE_HEADER_LEN;
+    return true;
+}
+
+int protocol_capture_next(protocol_capture_reader_t* reader, protocol_capture_record_t* record)
+{
+    if (reader->pos == reader->size)
+    {
+        return 0;
+    }
+    if (reader->size - reader->pos < PROTOCOL_CAPTURE_RECORD_HEADER_LEN)
+    {
+        return -1;
+    }
+    const uint8_t* p = reader->base + reader->pos;
+    record->ts_ns = pkt_load_le64(p);
+    record->port_id = pkt_load_le16(p + 8);
+    record->len = pkt_load_le16(p + 10);
+    if (reader->size - reader->pos - PROTOCOL_CAPTURE_RECORD_HEADER_LEN < record->len)
+    {
+        return -1;
+    }
+    record->data = p + PROTOCOL_CAPTURE_RECORD_HEADER_LEN;
+    reader->pos += PROTOCOL_CAPTURE_RECORD_HEADER_LEN + record->len;
+    return 1;
+}
+
+void protocol_capture_rewind(protocol_capture_reader_t* reader)
+{
+    reader->pos = PROTOCOL_CAPTURE_FILE_HEADER_LEN;
+}
+
+void protocol_capture_unmap(protocol_capture_reader_t* reader)
+{
+    if (reader->base)
+    {
+        munmap((void*)reader->base, reader->size);
+    }
+    memset(reader, 0, sizeof(*reader));
+}
@@ -0,0 +1,334 @@
+#include "pkt_compress.h"
+#include "pkt_protocol.h"
+#include "pkt_endian.h"
+#include "pkt_diag.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// ---------------- LZ 参数 ----------------
+// 字面量 token: 0xxxxxxx，后跟 (x+1) 个原始字节
+// 匹配 token:   1LLLLLOO OOOOOOOO，长度 L+3 (3~34)，偏移 O+1 (1~1024)
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (LZ_MIN_MATCH + 0x1F)
+#define LZ_MAX_OFFSET 1024
+#define LZ_MAX_LITERAL 128
+#define LZ_HASH_BITS 8
+#define LZ_HASH_SIZE (1 << LZ_HASH_BITS)
+
+static uint8_t lz_hash(const uint8_t* p)
+{
+    const uint32_t v = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16;
+    return (uint8_t)((v * 2654435761u) >> (32 - LZ_HASH_BITS));
+}
+
+static int lz_emit_literals(const uint8_t* src, uint16_t n, uint8_t* out, uint16_t* op, uint16_t out_cap)
+{
+    while (n > 0)
+    {
+        const uint16_t chunk = n > LZ_MAX_LITERAL ? LZ_MAX_LITERAL : n;
+        if (*op + 1 + chunk > out_cap)
+        {
+            return -1;
+        }
+        out[(*op)++] = (uint8_t)(chunk - 1);
+        memcpy(out + *op, src, chunk);
+        *op += chunk;
+        src += chunk;
+        n -= chunk;
+    }
+    return 0;
+}
+
+static int lz_encode(const uint8_t* in, uint16_t len, uint8_t* out, uint16_t out_cap)
+{
+    uint16_t table[LZ_HASH_SIZE]; // 位置 + 1，0 表示空
+    uint16_t op = 0;
+    uint16_t ip = 0;
+    uint16_t lit_start = 0;
+
+    memset(table, 0, sizeof(table));
+    while (ip + LZ_MIN_MATCH <= len)
+    {
+        const uint8_t h = lz_hash(in + ip);
+        const uint16_t cand = table[h];
+        table[h] = ip + 1;
+        if (cand != 0)
+        {
+            const uint16_t ref = cand - 1;
+            const uint16_t offset = ip - ref;
+            if (offset <= LZ_MAX_OFFSET && memcmp(in + ref, in + ip, LZ_MIN_MATCH) == 0)
+            {
+                uint16_t match_len = LZ_MIN_MATCH;
+                while (match_len < LZ_MAX_MATCH && ip + match_len < len &&
+                    in[ref + match_len] == in[ip + match_len])
+                {
+                    match_len++;
+                }
+                if (lz_emit_literals(in + lit_start, ip - lit_start, out, &op, out_cap) < 0 ||
+                    op + 2 > out_cap)
+                {
+                    return -1;
+                }
+                out[op++] = (uint8_t)(0x80 | ((match_len - LZ_MIN_MATCH) << 2) | ((offset - 1) >> 8));
+                out[op++] = (uint8_t)((offset - 1) & 0xFF);
+                ip += match_len;
+                lit_start = ip;
+                continue;
+            }
+        }
+        ip++;
+    }
+    if (lz_emit_literals(in + lit_start, len - lit_start, out, &op, out_cap) < 0)
+    {
+        return -1;
+    }
+    return op;
+}
+
+static int lz_decode(const uint8_t* in, uint16_t in_len, uint8_t* out, uint16_t raw_len)
+{
+    uint16_t ip = 0;
+    uint16_t op = 0;
+    while (ip < in_len)
+    {
+        const uint8_t token = in[ip++];
+        if (token & 0x80)
+        {
+            if (ip >= in_len)
+            {
+                return -1;
+            }
+            const uint16_t match_len = ((token >> 2) & 0x1F) + LZ_MIN_MATCH;
+            const uint16_t offset = (((token & 0x03) << 8) | in[ip++]) + 1;
+            if (offset > op || op + match_len > raw_len)
+            {
+                return -1;
+            }
+            // 允许源与目标重叠（重复串），逐字节复制
+            for (uint16_t i = 0; i < match_len; i++, op++)
+            {
+                out[op] = out[op - offset];
+            }
+        }
+        else
+        {
+            const uint16_t n = token + 1;
+            if (ip + n > in_len || op + n > raw_len)
+            {
+                return -1;
+            }
+            memcpy(out + op, in + ip, n);
+            ip += n;
+            op += n;
+        }
+    }
+    return op == raw_len ? op : -1;
+}
+
+// ---------------- DELTA16 ----------------
+// 按小端 int16 采样做差分，差值 zigzag 后以 varint（最多 3 字节）输出；奇数长度的末字节原样附加
+
+static int delta16_encode(const uint8_t* in, uint16_t len, uint8_t* out, uint16_t out_cap)
+{
+    uint16_t op = 0;
+    int32_t prev = 0;
+    for (uint16_t i = 0; i + 1 < len; i += 2)
+    {
+        const int32_t sample = (int16_t)pkt_load_le16(in + i);
+        const int32_t delta = sample - prev;
+        uint32_t zz = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+        prev = sample;
+        do
+        {
+            if (op >= out_cap)
+            {
+                return -1;
+            }
+            out[op++] = (uint8_t)((zz & 0x7F) | (zz > 0x7F ? 0x80 : 0));
+            zz >>= 7;
+        }
+        while (zz != 0);
+    }
+    if (len & 1)
+    {
+        if (op >= out_cap)
+        {
+            return -1;
+        }
+        out[op++] = in[len - 1];
+    }
+    return op;
+}
+
+static int delta16_decode(const uint8_t* in, uint16_t in_len, uint8_t* out, uint16_t raw_len)
+{
+    uint16_t ip = 0;
+    int32_t prev = 0;
+    for (uint16_t i = 0; i + 1 < raw_len; i += 2)
+    {
+        uint32_t zz = 0;
+        for (uint8_t shift = 0;; shift += 7)
+        {
+            if (ip >= in_len || shift > 14)
+            {
+                return -1;
+            }
+            const uint8_t b = in[ip++];
+            zz |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80))
+            {
+                break;
+            }
+        }
+        const int32_t delta = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+        const uint16_t sample = (uint16_t)(prev + delta);
+        prev = (int16_t)sample;
+        pkt_store_le16(out + i, sample);
+    }
+    if (raw_len & 1)
+    {
+        if (ip >= in_len)
+        {
+            return -1;
+        }
+        out[raw_len - 1] = in[ip++];
+    }
+    return ip == in_len ? raw_len : -1;
+}
+
+// ---------------- 公共接口 ----------------
+
+void protocol_compressor_init(protocol_compressor_t* compressor)
+{
+    memset(compressor, 0, sizeof(*compressor));
+    compressor->codec[PROTOCOL_TYPE_SENSOR] = PROTOCOL_CODEC_DELTA16;
+    compressor->codec[PROTOCOL_TYPE_LOG] = PROTOCOL_CODEC_LZ;
+}
+
+void protocol_compressor_set_codec(protocol_compressor_t* compressor, const protocol_type_t type,
+                                   const protocol_codec_t codec)
+{
+    if (type >= PROTOCOL_TYPE_MAX || codec >= PROTOCOL_CODEC_MAX)
+    {
+        return;
+    }
+    compressor->codec[type] = codec;
+}
+
+int protocol_compress(const protocol_codec_t codec, const uint8_t* in, const uint16_t in_len,
+                      uint8_t* out, const uint16_t out_cap)
+{
+    if (in_len > PROTOCOL_MAX_UNCOMPRESSED_LEN || out_cap < PROTOCOL_COMPRESS_HEADER_LEN)
+    {
+        return -1;
+    }
+    int body_len;
+    uint8_t* body = out + PROTOCOL_COMPRESS_HEADER_LEN;
+    const uint16_t body_cap = out_cap - PROTOCOL_COMPRESS_HEADER_LEN;
+    switch (codec)
+    {
+    case PROTOCOL_CODEC_LZ:
+        body_len = lz_encode(in, in_len, body, body_cap);
+        break;
+    case PROTOCOL_CODEC_DELTA16:
+        body_len = delta16_encode(in, in_len, body, body_cap);
+        break;
+    default:
+        return -1;
+    }
+    if (body_len < 0)
+    {
+        return -1;
+    }
+    pkt_store_u8(out, (uint8_t)codec);
+    pkt_store_le16(out + 1, in_len);
+    return PROTOCOL_COMPRESS_HEADER_LEN + body_len;
+}
+
+int protocol_decompress(const uint8_t* in, const uint16_t in_len, uint8_t* out, const uint16_t out_cap)
+{
+    if (in_len < PROTOCOL_COMPRESS_HEADER_LEN)
+    {
+        return -1;
+    }
+    const uint16_t raw_len = pkt_load_le16(in + 1);
+    if (raw_len > PROTOCOL_MAX_UNCOMPRESSED_LEN || raw_len > out_cap)
+    {
+        return -1;
+    }
+    const uint8_t* body = in + PROTOCOL_COMPRESS_HEADER_LEN;
+    const uint16_t body_len = in_len - PROTOCOL_COMPRESS_HEADER_LEN;
+    switch (in[0])
+    {
+    case PROTOCOL_CODEC_LZ:
+        return lz_decode(body, body_len, out, raw_len);
+    case PROTOCOL_CODEC_DELTA16:
+        return delta16_decode(body, body_len, out, raw_len);
+    default:
+        return -1;
+    }
+}
+
+uint8_t* protocol_pack_frame_compressed(protocol_compressor_t* compressor, const protocol_type_t type,
+                                        const uint8_t* data, const uint16_t data_len, uint16_t* frame_len)
+{
+    if (PROTOCOL_TYPE_ID(type) >= PROTOCOL_TYPE_MAX || (type & PROTOCOL_TYPE_FLAG_COMPRESSED))
+    {
+        protocol_diag_report(PROTOCOL_DIAG_PACK_BAD_TYPE, type);
+        return NULL;
+    }
+    if (data_len > PROTOCOL_MAX_UNCOMPRESSED_LEN)
+    {
+        protocol_diag_report(PROTOCOL_DIAG_PACK_TOO_LONG, data_len);
+        return NULL;
+    }
+
+    const protocol_codec_t codec = (protocol_codec_t)compressor->codec[PROTOCOL_TYPE_ID(type)];
+    if (codec != PROTOCOL_CODEC_NONE)
+    {
+        uint8_t packed[PROTOCOL_MAX_DATA_LEN];
+        // 压缩结果必须比原始数据短才值得发送
+        const uint16_t cap = data_len - 1 < PROTOCOL_MAX_DATA_LEN ? data_len - 1 : PROTOCOL_MAX_DATA_LEN;
+        const int packed_len = data_len > 0 ? protocol_compress(codec, data, data_len, packed, cap) : -1;
+        if (packed_len > 0)
+        {
+            compressor->stats.raw_bytes += data_len;
+            compressor->stats.wire_bytes += packed_len;
+            compressor->stats.frames_compressed++;
+            return protocol_pack_frame((protocol_type_t)(type | PROTOCOL_TYPE_FLAG_COMPRESSED), packed,
+                                       (uint16_t)packed_len, frame_len);
+        }
+    }
+
+    uint8_t* frame = protocol_pack_frame(type, data, data_len, frame_len);
+    if (frame)
+    {
+        compressor->stats.raw_bytes += data_len;
+        compressor->stats.wire_bytes += data_len;
+        compressor->stats.frames_stored++;
+    }
+    return frame;
+}
+
+int protocol_decompress_payload(protocol_compressor_t* compressor, const uint8_t* in, const uint16_t in_len,
+                                uint8_t* out, const uint16_t out_cap)
+{
+    const int n = protocol_decompress(in, in_len, out, out_cap);
+    if (n < 0)
+    {
+        compressor->stats.decode_errors++;
+        return -1;
+    }
+    compressor->stats.frames_decoded++;
+    return n;
+}
+
+double protocol_compress_ratio(const protocol_compress_stats_t* stats)
+{
+    if (stats->raw_bytes == 0)
+    {
+        return 1.0;
+    }
+    return (double)stats->wire_bytes / (double)stats->raw_bytes;
+}
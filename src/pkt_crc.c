@@ -0,0 +1,386 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pkt_crc.h"
+#include "pkt_endian.h"
+#include "pkt_protocol.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRC_X86 1
+#include <immintrin.h>
+#endif
+
+// 每次批量校验的帧数（栈上临时数组）
+#define VERIFY_BLOCK 256
+
+// CRC16-CCITT 查表（多项式 0x1021）
+static const uint16_t crc16_table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0,
+};
+
+static inline uint16_t crc16_byte(const uint16_t crc, const uint8_t byte)
+{
+    return (uint16_t)((crc << 8) ^ crc16_table[(uint8_t)((crc >> 8) ^ byte)]);
+}
+
+uint16_t protocol_crc16_update(uint16_t crc, const uint8_t* data, const size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = crc16_byte(crc, data[i]);
+    }
+    return crc;
+}
+
+// CRC32C slicing-by-8 查表（首次使用时生成）
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_table_once = PTHREAD_ONCE_INIT;
+
+static void crc32c_init_table(void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+        }
+        crc32c_table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        for (int k = 1; k < 8; k++)
+        {
+            const uint32_t prev = crc32c_table[k - 1][i];
+            crc32c_table[k][i] = (prev >> 8) ^ crc32c_table[0][prev & 0xFF];
+        }
+    }
+}
+
+uint32_t protocol_crc32c_sw(uint32_t crc, const uint8_t* data, size_t len)
+{
+    pthread_once(&crc32c_table_once, crc32c_init_table);
+    crc = ~crc;
+    while (len >= 8)
+    {
+        const uint32_t lo = pkt_load_le32(data) ^ crc;
+        const uint32_t hi = pkt_load_le32(data + 4);
+        crc = crc32c_table[7][lo & 0xFF] ^ crc32c_table[6][(lo >> 8) & 0xFF] ^
+            crc32c_table[5][(lo >> 16) & 0xFF] ^ crc32c_table[4][lo >> 24] ^
+            crc32c_table[3][hi & 0xFF] ^ crc32c_table[2][(hi >> 8) & 0xFF] ^
+            crc32c_table[1][(hi >> 16) & 0xFF] ^ crc32c_table[0][hi >> 24];
+        data += 8;
+        len -= 8;
+    }
+    while (len--)
+    {
+        crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *data++) & 0xFF];
+    }
+    return ~crc;
+}
+
+#ifdef CRC_X86
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, const uint8_t* data, size_t len)
+{
+    crc = ~crc;
+#ifdef __x86_64__
+    uint64_t crc64 = crc;
+    for (; len >= 8; data += 8, len -= 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = (uint32_t)crc64;
+#endif
+    for (; len >= 4; data += 4, len -= 4)
+    {
+        uint32_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    while (len--)
+    {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return ~crc;
+}
+
+// 并行校验与解码线程会同时首次调用，实现只选择一次
+static pthread_once_t crc32c_impl_once = PTHREAD_ONCE_INIT;
+static uint32_t (*crc32c_impl)(uint32_t crc, const uint8_t* data, size_t len);
+
+static void crc32c_select_impl(void)
+{
+    crc32c_impl = __builtin_cpu_supports("sse4.2") ? crc32c_hw : protocol_crc32c_sw;
+}
+
+uint32_t protocol_crc32c(const uint32_t crc, const uint8_t* data, const size_t len)
+{
+    pthread_once(&crc32c_impl_once, crc32c_select_impl);
+    return crc32c_impl(crc, data, len);
+}
+
+#else
+
+uint32_t protocol_crc32c(const uint32_t crc, const uint8_t* data, const size_t len)
+{
+    return protocol_crc32c_sw(crc, data, len);
+}
+
+#endif
+
+void protocol_crc16_multi(const uint8_t* const* data, const size_t* lens, uint16_t* crcs, const size_t count)
+{
+    const uint8_t* ptr[PROTOCOL_CRC_LANES];
+    size_t left[PROTOCOL_CRC_LANES];
+    size_t index[PROTOCOL_CRC_LANES];
+    uint16_t crc[PROTOCOL_CRC_LANES];
+    bool active[PROTOCOL_CRC_LANES];
+    size_t next = 0;
+    int active_count = 0;
+
+    // 装入下一个非空缓冲区，空缓冲区直接得到初值
+    for (int l = 0; l < PROTOCOL_CRC_LANES; l++)
+    {
+        active[l] = false;
+        while (next < count && lens[next] == 0)
+        {
+            crcs[next++] = 0xFFFF;
+        }
+        if (next < count)
+        {
+            ptr[l] = data[next];
+            left[l] = lens[next];
+            index[l] = next++;
+            crc[l] = 0xFFFF;
+            active[l] = true;
+            active_count++;
+        }
+    }
+
+    while (active_count > 0)
+    {
+        // 空闲通道复制一条活动通道，避免循环内判断；步长取活动通道剩余长度的最小值
+        int donor = 0;
+        while (!active[donor])
+        {
+            donor++;
+        }
+        size_t step = SIZE_MAX;
+        for (int l = 0; l < PROTOCOL_CRC_LANES; l++)
+        {
+            if (!active[l])
+            {
+                ptr[l] = ptr[donor];
+                left[l] = left[donor];
+                crc[l] = crc[donor];
+            }
+            if (left[l] < step)
+            {
+                step = left[l];
+            }
+        }
+
+        // 各通道依赖链互不相关，编译器展开后 CPU 可以同时执行
+        for (size_t i = 0; i < step; i++)
+        {
+            for (int l = 0; l < PROTOCOL_CRC_LANES; l++)
+            {
+                crc[l] = crc16_byte(crc[l], ptr[l][i]);
+            }
+        }
+
+        for (int l = 0; l < PROTOCOL_CRC_LANES; l++)
+        {
+            ptr[l] += step;
+            left[l] -= step;
+            if (!active[l] || left[l] > 0)
+            {
+                continue;
+            }
+            crcs[index[l]] = crc[l];
+            while (next < count && lens[next] == 0)
+            {
+                crcs[next++] = 0xFFFF;
+            }
+            if (next < count)
+            {
+                ptr[l] = data[next];
+                left[l] = lens[next];
+                index[l] = next++;
+                crc[l] = 0xFFFF;
+            }
+            else
+            {
+                active[l] = false;
+                active_count--;
+            }
+        }
+    }
+}
+
+size_t protocol_crc16_verify_frames(const uint8_t* const* frames, const size_t* lens, uint8_t* ok, const size_t count)
+{
+    size_t passed = 0;
+    for (size_t base = 0; base < count; base += VERIFY_BLOCK)
+    {
+        const size_t n = count - base < VERIFY_BLOCK ? count - base : VERIFY_BLOCK;
+        const uint8_t* region[VERIFY_BLOCK];
+        size_t region_len[VERIFY_BLOCK];
+        uint16_t crcs[VERIFY_BLOCK];
+        size_t slot[VERIFY_BLOCK];
+        size_t m = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            const size_t len = lens[base + i];
+            if (ok)
+            {
+                ok[base + i] = 0;
+            }
+            if (len < PROTOCOL_HEADER_SIZE + PROTOCOL_TRAILER_SIZE)
+            {
+                continue;
+            }
+            if (frames[base + i][PROTOCOL_OFFSET_TYPE] & PROTOCOL_TYPE_FLAG_CRC32C)
+            {
+                // CRC32C 帧单独校验（硬件指令本身已足够快）
+                const uint8_t* frame = frames[base + i];
+                if (len >= PROTOCOL_HEADER_SIZE + PROTOCOL_CRC32C_TRAILER_SIZE &&
+                    pkt_load_le32(frame + len - PROTOCOL_CRC32C_TRAILER_SIZE) ==
+                    protocol_crc32c(0, frame, len - PROTOCOL_CRC32C_TRAILER_SIZE))
+                {
+                    passed++;
+                    if (ok)
+                    {
+                        ok[base + i] = 1;
+                    }
+                }
+                continue;
+            }
+            // CRC 覆盖帧头 + 负载，不含 CRC 和帧尾
+            region[m] = frames[base + i];
+            region_len[m] = len - PROTOCOL_TRAILER_SIZE;
+            slot[m++] = base + i;
+        }
+        protocol_crc16_multi(region, region_len, crcs, m);
+        for (size_t j = 0; j < m; j++)
+        {
+            const uint16_t wire = pkt_load_le16(region[j] + region_len[j]);
+            if (wire == crcs[j])
+            {
+                passed++;
+                if (ok)
+                {
+                    ok[slot[j]] = 1;
+                }
+            }
+        }
+    }
+    return passed;
+}
+
+typedef struct
+{
+    const uint8_t* const* frames;
+    const size_t* lens;
+    uint8_t* ok;
+    size_t count;
+    size_t passed;
+} verify_job_t;
+
+static void* verify_worker(void* arg)
+{
+    verify_job_t* job = arg;
+    job->passed = protocol_crc16_verify_frames(job->frames, job->lens, job->ok, job->count);
+    return NULL;
+}
+
+size_t protocol_crc16_verify_frames_mt(const uint8_t* const* frames, const size_t* lens, uint8_t* ok,
+                                       const size_t count, unsigned threads)
+{
+    // 每个线程至少分到几个批次才值得创建线程
+    const size_t min_per_thread = 4 * VERIFY_BLOCK;
+    if (threads > 64)
+    {
+        threads = 64;
+    }
+    while (threads > 1 && count / threads < min_per_thread)
+    {
+        threads--;
+    }
+    if (threads <= 1)
+    {
+        return protocol_crc16_verify_frames(frames, lens, ok, count);
+    }
+
+    verify_job_t jobs[64];
+    pthread_t tids[64];
+    bool started[64];
+    const size_t chunk = (count + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        const size_t begin = t * chunk < count ? t * chunk : count;
+        const size_t end = begin + chunk < count ? begin + chunk : count;
+        jobs[t].frames = frames + begin;
+        jobs[t].lens = lens + begin;
+        jobs[t].ok = ok ? ok + begin : NULL;
+        jobs[t].count = end - begin;
+        jobs[t].passed = 0;
+        // 第 0 份留给调用线程；创建失败时也在调用线程内完成
+        started[t] = t > 0 && pthread_create(&tids[t], NULL, verify_worker, &jobs[t]) == 0;
+    }
+    size_t passed = 0;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        if (!started[t])
+        {
+            verify_worker(&jobs[t]);
+        }
+    }
+    for (unsigned t = 0; t < threads; t++)
+    {
+        if (started[t])
+        {
+            pthread_join(tids[t], NULL);
+        }
+        passed += jobs[t].passed;
+    }
+    return passed;
+}
@@ -0,0 +1,498 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pkt_decode.h"
+#include "pkt_crc.h"
+#include "pkt_endian.h"
+#include "pkt_pool.h"
+#include "pkt_protocol.h"
+#include "pkt_scan.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 没有找到帧头
+#define DECODE_NONE SIZE_MAX
+// 每块保留的前几个事件（合并时用来寻找与顺序解析重合的帧头）
+#define DECODE_HEAD_EVENTS 16
+// 线程数上限
+#define DECODE_MAX_THREADS 64
+
+typedef enum
+{
+    DECODE_FRAME, // 解析成功
+    DECODE_CRC_ERROR, // CRC 校验失败
+    DECODE_FORMAT_ERROR, // 长度越界或帧尾错误
+    DECODE_INCOMPLETE, // 数据在帧中途结束
+} decode_kind_t;
+
+/**
+ * @brief 一个候选帧的解码结果
+ */
+typedef struct
+{
+    size_t pos; // 帧头位置
+    uint16_t len; // 负载长度
+    uint8_t type; // 类型字节
+    uint8_t kind; // decode_kind_t
+} decode_event_t;
+
+/**
+ * @brief 统计
+ */
+typedef struct
+{
+    uint64_t frames;
+    uint64_t payload_bytes;
+    uint64_t crc_errors;
+    uint64_t format_errors;
+    uint64_t incomplete_bytes;
+    uint64_t type_counts[256];
+} decode_tally_t;
+
+/**
+ * @brief 动态帧数组
+ */
+typedef struct
+{
+    protocol_decoded_frame_t* items;
+    size_t count;
+    size_t cap;
+} frame_vec_t;
+
+/**
+ * @brief 一块的推测解码结果
+ */
+typedef struct
+{
+    size_t begin; // 块起始
+    size_t end; // 块结束（帧头在此之前的候选帧属于本块，帧可以越过块尾）
+    size_t resume; // 本块之后继续解析的位置
+    size_t events; // 事件总数
+    size_t head_count; // head 中的事件数
+    decode_event_t head[DECODE_HEAD_EVENTS]; // 前几个事件
+    decode_tally_t tally; // 本块统计
+    frame_vec_t frames; // 本块的帧（collect_frames 时）
+    bool oom; // 帧数组扩容失败
+} decode_chunk_t;
+
+typedef struct
+{
+    const uint8_t* data;
+    size_t size;
+    bool collect;
+    decode_chunk_t* chunks;
+    size_t count;
+    atomic_size_t next;
+} decode_ctx_t;
+
+static bool frame_vec_reserve(frame_vec_t* vec, const size_t need)
+{
+    if (need <= vec->cap)
+    {
+        return true;
+    }
+    size_t cap = vec->cap ? vec->cap : 1024;
+    while (cap < need)
+    {
+        cap *= 2;
+    }
+    protocol_decoded_frame_t* items = protocol_realloc(vec->items, cap * sizeof(*items));
+    if (!items)
+    {
+        return false;
+    }
+    vec->items = items;
+    vec->cap = cap;
+    return true;
+}
+
+static bool frame_vec_push(frame_vec_t* vec, const decode_event_t* ev)
+{
+    if (!frame_vec_reserve(vec, vec->count + 1))
+    {
+        return false;
+    }
+    protocol_decoded_frame_t* frame = &vec->items[vec->count++];
+    frame->offset = ev->pos;
+    frame->len = ev->len;
+    frame->type = ev->type;
+    return true;
+}
+
+/**
+ * 统计一个事件，sign 为 -1 时撤销
+ */
+static void tally_event(decode_tally_t* tally, const decode_event_t* ev, const size_t size, const int sign)
+{
+    const uint64_t one = sign > 0 ? 1 : UINT64_MAX;
+    switch (ev->kind)
+    {
+    case DECODE_FRAME:
+        tally->frames += one;
+        tally->payload_bytes += one * ev->len;
+        tally->type_counts[ev->type] += one;
+        break;
+    case DECODE_CRC_ERROR:
+        tally->crc_errors += one;
+        break;
+    case DECODE_FORMAT_ERROR:
+        tally->format_errors += one;
+        break;
+    default:
+        tally->incomplete_bytes += one * (uint64_t)(size - ev->pos);
+        break;
+    }
+}
+
+static void tally_merge(decode_tally_t* dst, const decode_tally_t* src)
+{
+    dst->frames += src->frames;
+    dst->payload_bytes += src->payload_bytes;
+    dst->crc_errors += src->crc_errors;
+    dst->format_errors += src->format_errors;
+    dst->incomplete_bytes += src->incomplete_bytes;
+    for (int i = 0; i < 256; i++)
+    {
+        dst->type_counts[i] += src->type_counts[i];
+    }
+}
+
+/**
+ * 查找帧头位于 [from, limit) 的第一个候选帧（与解析器等待帧头时的行为一致：第一个 0x55 0xAA 字节对）
+ * @return 帧头位置，没有时返回 DECODE_NONE
+ */
+static size_t next_header(const uint8_t* data, const size_t size, const size_t from, const size_t limit)
+{
+    if (from >= limit)
+    {
+        return DECODE_NONE;
+    }
+    // 字节对从 limit - 1 开始时需要多看一个字节
+    const size_t stop = limit < size ? limit + 1 : size;
+    const size_t pos = from + protocol_scan_header(data + from, stop - from);
+    // 末尾单独的 0x55 不是完整帧头
+    if (pos >= limit || pos + 1 >= size)
+    {
+        return DECODE_NONE;
+    }
+    return pos;
+}
+
+/**
+ * 按 protocol_parse_byte 的规则解码 pos 处的候选帧
+ * @return 解析器回到等待帧头状态的位置
+ */
+static size_t decode_one(const uint8_t* data, const size_t size, const size_t pos, decode_event_t* ev)
+{
+    ev->pos = pos;
+    ev->type = 0;
+    ev->len = 0;
+    ev->kind = DECODE_INCOMPLETE;
+    if (pos + PROTOCOL_HEADER_SIZE > size)
+    {
+        return size;
+    }
+    ev->type = data[pos + PROTOCOL_OFFSET_TYPE];
+    ev->len = pkt_load_le16(data + pos + PROTOCOL_OFFSET_LEN);
+    if (ev->len > PROTOCOL_MAX_DATA_LEN)
+    {
+        ev->kind = DECODE_FORMAT_ERROR;
+        return pos + PROTOCOL_HEADER_SIZE;
+    }
+    const bool crc32c = ev->type & PROTOCOL_TYPE_FLAG_CRC32C;
+    const size_t crc_pos = pos + PROTOCOL_HEADER_SIZE + ev->len;
+    const size_t tail_pos = crc_pos + PROTOCOL_TRAILER_SIZE_OF(ev->type) - sizeof(uint16_t);
+    if (tail_pos >= size)
+    {
+        return size;
+    }
+    if (data[tail_pos] != (FRAME_TAIL & 0xFF))
+    {
+        ev->kind = DECODE_FORMAT_ERROR;
+        return tail_pos + 1;
+    }
+    if (tail_pos + 1 >= size)
+    {
+        return size;
+    }
+    if (data[tail_pos + 1] != (FRAME_TAIL >> 8))
+    {
+        ev->kind = DECODE_FORMAT_ERROR;
+    }
+    else
+    {
+        const size_t covered = PROTOCOL_HEADER_SIZE + ev->len;
+        const bool match = crc32c
+                               ? protocol_crc32c(0, data + pos, covered) == pkt_load_le32(data + crc_pos)
+                               : protocol_crc16_update(0xFFFF, data + pos, covered) == pkt_load_le16(data + crc_pos);
+        ev->kind = match ? DECODE_FRAME : DECODE_CRC_ERROR;
+    }
+    return tail_pos + 2;
+}
+
+/**
+ * 从 start（等待帧头状态）解码一块
+ */
+static void decode_chunk(const decode_ctx_t* ctx, decode_chunk_t* chunk, size_t start)
+{
+    memset(&chunk->tally, 0, sizeof(chunk->tally));
+    chunk->events = 0;
+    chunk->head_count = 0;
+    chunk->frames.count = 0;
+    size_t pos;
+    while ((pos = next_header(ctx->data, ctx->size, start, chunk->end)) != DECODE_NONE)
+    {
+        decode_event_t ev;
+        start = decode_one(ctx->data, ctx->size, pos, &ev);
+        tally_event(&chunk->tally, &ev, ctx->size, 1);
+        if (chunk->head_count < DECODE_HEAD_EVENTS)
+        {
+            chunk->head[chunk->head_count++] = ev;
+        }
+        chunk->events++;
+        if (ev.kind == DECODE_FRAME && ctx->collect && !frame_vec_push(&chunk->frames, &ev))
+        {
+            chunk->oom = true;
+            break;
+        }
+    }
+    // 块内剩余部分没有帧头，从块尾继续扫描结果相同
+    chunk->resume = start > chunk->end ? start : chunk->end;
+}
+
+static void* decode_worker(void* arg)
+{
+    decode_ctx_t* ctx = arg;
+    for (;;)
+    {
+        const size_t i = atomic_fetch_add_explicit(&ctx->next, 1, memory_order_relaxed);
+        if (i >= ctx->count)
+        {
+            break;
+        }
+        decode_chunk(ctx, &ctx->chunks[i], ctx->chunks[i].begin);
+    }
+    return NULL;
+}
+
+/**
+ * 把一块的结果接到顺序解析之后
+ * 从真实位置 resume 开始逐个解码候选帧，直到某个帧头也是本块推测解码出的帧头，之后两者一致，直接采用本块结果。
+ * 在保留的前几个事件内没有重合时，从 resume 重新解码整块。
+ * @return 是否成功（帧数组扩容失败时返回 false）
+ */
+static bool stitch_chunk(const decode_ctx_t* ctx, decode_chunk_t* chunk, size_t* resume, decode_tally_t* tally,
+                         frame_vec_t* out)
+{
+    size_t skip = 0;
+    for (;;)
+    {
+        const size_t pos = next_header(ctx->data, ctx->size, *resume, chunk->end);
+        while (skip < chunk->head_count && chunk->head[skip].pos < pos)
+        {
+            skip++;
+        }
+        if (skip == chunk->head_count && chunk->head_count < chunk->events)
+        {
+            // 重合点超出保留的事件，整块重新解码（很少发生）
+            decode_chunk(ctx, chunk, *resume);
+            skip = 0;
+            break;
+        }
+        if (pos == DECODE_NONE)
+        {
+            // 推测解码的事件都落在真实解析已经越过的区域
+            *resume = *resume > chunk->end ? *resume : chunk->end;
+            return true;
+        }
+        if (skip < chunk->head_count && chunk->head[skip].pos == pos)
+        {
+            break;
+        }
+        decode_event_t ev;
+        *resume = decode_one(ctx->data, ctx->size, pos, &ev);
+        tally_event(tally, &ev, ctx->size, 1);
+        if (ev.kind == DECODE_FRAME && ctx->collect && !frame_vec_push(out, &ev))
+        {
+            return false;
+        }
+    }
+    if (chunk->oom)
+    {
+        return false;
+    }
+    // 撤销重合点之前的推测事件
+    size_t dropped_frames = 0;
+    for (size_t i = 0; i < skip; i++)
+    {
+        tally_event(&chunk->tally, &chunk->head[i], ctx->size, -1);
+        dropped_frames += chunk->head[i].kind == DECODE_FRAME;
+    }
+    tally_merge(tally, &chunk->tally);
+    *resume = chunk->resume;
+    if (!ctx->collect)
+    {
+        return true;
+    }
+    const size_t keep = chunk->frames.count - dropped_frames;
+    if (!frame_vec_reserve(out, out->count + keep))
+    {
+        return false;
+    }
+    memcpy(out->items + out->count, chunk->frames.items + dropped_frames, keep * sizeof(protocol_decoded_frame_t));
+    out->count += keep;
+    return true;
+}
+
+bool protocol_decode_buffer(const uint8_t* data, const size_t len, const protocol_decode_options_t* opts,
+                            protocol_decode_result_t* result)
+{
+    memset(result, 0, sizeof(*result));
+    result->base = data;
+    result->bytes = len;
+
+    size_t chunk_size = opts && opts->chunk_size ? opts->chunk_size : PROTOCOL_DECODE_DEFAULT_CHUNK;
+    if (chunk_size < PROTOCOL_DECODE_MIN_CHUNK)
+    {
+        chunk_size = PROTOCOL_DECODE_MIN_CHUNK;
+    }
+    unsigned threads = opts ? opts->threads : 0;
+    if (threads == 0)
+    {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned)cpus : 1;
+    }
+
+    decode_ctx_t ctx;
+    ctx.data = data;
+    ctx.size = len;
+    ctx.collect = opts && opts->collect_frames;
+    // 余数并入最后一块，每块都不小于 chunk_size
+    ctx.count = len / chunk_size ? len / chunk_size : 1;
+    ctx.chunks = protocol_malloc(ctx.count * sizeof(decode_chunk_t));
+    if (!ctx.chunks)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < ctx.count; i++)
+    {
+        decode_chunk_t* chunk = &ctx.chunks[i];
+        memset(chunk, 0, sizeof(*chunk));
+        chunk->begin = i * chunk_size;
+        chunk->end = i + 1 == ctx.count ? len : (i + 1) * chunk_size;
+    }
+    atomic_init(&ctx.next, 0);
+
+    if (threads > ctx.count)
+    {
+        threads = (unsigned)ctx.count;
+    }
+    if (threads > DECODE_MAX_THREADS)
+    {
+        threads = DECODE_MAX_THREADS;
+    }
+    // 调用线程也参与解码；创建线程失败时由已有线程处理剩余的块
+    pthread_t tids[DECODE_MAX_THREADS];
+    unsigned started = 0;
+    for (unsigned t = 1; t < threads; t++)
+    {
+        if (pthread_create(&tids[started], NULL, decode_worker, &ctx) == 0)
+        {
+            started++;
+        }
+    }
+    decode_worker(&ctx);
+    for (unsigned t = 0; t < started; t++)
+    {
+        pthread_join(tids[t], NULL);
+    }
+
+    // 按顺序合并
+    decode_tally_t tally;
+    memset(&tally, 0, sizeof(tally));
+    frame_vec_t out = {NULL, 0, 0};
+    size_t resume = 0;
+    bool ok = true;
+    for (size_t i = 0; i < ctx.count && ok; i++)
+    {
+        ok = stitch_chunk(&ctx, &ctx.chunks[i], &resume, &tally, &out);
+    }
+    for (size_t i = 0; i < ctx.count; i++)
+    {
+        protocol_free(ctx.chunks[i].frames.items);
+    }
+    protocol_free(ctx.chunks);
+    if (!ok)
+    {
+        protocol_free(out.items);
+        return false;
+    }
+
+    result->frames = tally.frames;
+    result->payload_bytes = tally.payload_bytes;
+    result->crc_errors = tally.crc_errors;
+    result->format_errors = tally.format_errors;
+    result->incomplete_bytes = tally.incomplete_bytes;
+    memcpy(result->type_counts, tally.type_counts, sizeof(result->type_counts));
+    result->frame_list = out.items;
+    result->frame_count = out.count;
+    return true;
+}
+
+bool protocol_decode_file(const char* path, const protocol_decode_options_t* opts, protocol_decode_result_t* result)
+{
+    memset(result, 0, sizeof(*result));
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        return false;
+    }
+    const size_t size = (size_t)st.st_size;
+    if (size == 0)
+    {
+        close(fd);
+        return protocol_decode_buffer(NULL, 0, opts, result);
+    }
+    void* base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
+    // 各线程顺序读取自己的块，提前预读
+    posix_madvise(base, size, POSIX_MADV_WILLNEED);
+    if (!protocol_decode_buffer(base, size, opts, result))
+    {
+        munmap(base, size);
+        return false;
+    }
+    result->mapped_size = size;
+    return true;
+}
+
+const uint8_t* protocol_decode_frame_data(const protocol_decode_result_t* result,
+                                          const protocol_decoded_frame_t* frame)
+{
+    return result->base + frame->offset + PROTOCOL_HEADER_SIZE;
+}
+
+void protocol_decode_result_free(protocol_decode_result_t* result)
+{
+    protocol_free(result->frame_list);
+    if (result->mapped_size)
+    {
+        munmap((void*)result->base, result->mapped_size);
+    }
+    memset(result, 0, sizeof(*result));
+}
@@ -0,0 +1,247 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pkt_demux.h"
+#include "pkt_pool.h"
+
+#include <string.h>
+#include <time.h>
+
+#define SLOT_FREE 0
+#define SLOT_READY 1
+#define SLOT_BUSY 2
+
+bool protocol_stream_init(protocol_stream_t* stream, const protocol_stream_policy_t policy, const uint16_t capacity)
+{
+    memset(stream, 0, sizeof(*stream));
+    if (capacity == 0)
+    {
+        return false;
+    }
+    stream->slots = protocol_malloc((size_t)capacity * sizeof(protocol_stream_frame_t));
+    if (!stream->slots)
+    {
+        return false;
+    }
+    memset(stream->slots, 0, (size_t)capacity * sizeof(protocol_stream_frame_t));
+    stream->policy = policy;
+    stream->capacity = capacity;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->not_empty, &attr);
+    pthread_cond_init(&stream->not_full, &attr);
+    pthread_condattr_destroy(&attr);
+    return true;
+}
+
+void protocol_stream_set_push_timeout(protocol_stream_t* stream, const int timeout_ms)
+{
+    pthread_mutex_lock(&stream->lock);
+    stream->push_timeout_ms = timeout_ms > 0 ? timeout_ms : 0;
+    pthread_mutex_unlock(&stream->lock);
+}
+
+static void deadline_after(struct timespec* deadline, const int timeout_ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += timeout_ms / 1000;
+    deadline->tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (deadline->tv_nsec >= 1000000000)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+}
+
+int protocol_stream_push(protocol_stream_t* stream, const uint8_t type, const uint8_t* data, const uint16_t len,
+                         const protocol_frame_times_t* times)
+{
+    pthread_mutex_lock(&stream->lock);
+    stream->stats.pushed++;
+    if (len > PROTOCOL_STREAM_FRAME_MAX)
+    {
+        stream->stats.dropped++;
+        pthread_mutex_unlock(&stream->lock);
+        return -1;
+    }
+    // 槽位按环形顺序复用：队尾槽位空闲才能写入
+    bool waited = false;
+    struct timespec deadline;
+    while (!stream->closed && stream->slots[stream->tail].state != SLOT_FREE)
+    {
+        if (stream->policy == PROTOCOL_STREAM_BEST_EFFORT && stream->slots[stream->tail].state == SLOT_READY)
+        {
+            // 队尾追上了最旧的未取出帧：丢弃它，腾出槽位
+            stream->stats.dropped++;
+            stream->slots[stream->head].state = SLOT_FREE;
+            stream->head = (uint16_t)((stream->head + 1) % stream->capacity);
+            stream->ready--;
+            continue;
+        }
+        if (stream->policy == PROTOCOL_STREAM_BEST_EFFORT || stream->push_timeout_ms == 0)
+        {
+            break;
+        }
+        if (!waited)
+        {
+            waited = true;
+            stream->stats.producer_waits++;
+            deadline_after(&deadline, stream->push_timeout_ms);
+        }
+        if (pthread_cond_timedwait(&stream->not_full, &stream->lock, &deadline) != 0 &&
+            stream->slots[stream->tail].state != SLOT_FREE)
+        {
+            break;
+        }
+    }
+    if (stream->closed || stream->slots[stream->tail].state != SLOT_FREE)
+    {
+        stream->stats.dropped++;
+        pthread_mutex_unlock(&stream->lock);
+        return -1;
+    }
+
+    protocol_stream_frame_t* frame = &stream->slots[stream->tail];
+    frame->type = type;
+    frame->len = len;
+    frame->seq = stream->next_seq++;
+    memcpy(frame->data, data, len);
+    if (times)
+    {
+        frame->times = *times;
+        frame->enqueue_ns = protocol_trace_now_ns();
+    }
+    else
+    {
+        memset(&frame->times, 0, sizeof(frame->times));
+        frame->enqueue_ns = 0;
+    }
+    frame->state = SLOT_READY;
+    stream->tail = (uint16_t)((stream->tail + 1) % stream->capacity);
+    stream->ready++;
+    pthread_cond_signal(&stream->not_empty);
+    pthread_mutex_unlock(&stream->lock);
+    return 0;
+}
+
+static bool can_pop(const protocol_stream_t* stream)
+{
+    return stream->ready > 0 && !(stream->policy == PROTOCOL_STREAM_ORDERED && stream->in_flight > 0);
+}
+
+protocol_stream_frame_t* protocol_stream_pop(protocol_stream_t* stream, const int timeout_ms)
+{
+    struct timespec deadline;
+    if (timeout_ms >= 0)
+    {
+        deadline_after(&deadline, timeout_ms);
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    while (!can_pop(stream))
+    {
+        if (stream->closed && stream->ready == 0)
+        {
+            pthread_mutex_unlock(&stream->lock);
+            return NULL;
+        }
+        if (timeout_ms < 0)
+        {
+            pthread_cond_wait(&stream->not_empty, &stream->lock);
+        }
+        else if (pthread_cond_timedwait(&stream->not_empty, &stream->lock, &deadline) != 0 && !can_pop(stream))
+        {
+            pthread_mutex_unlock(&stream->lock);
+            return NULL;
+        }
+    }
+    protocol_stream_frame_t* frame = &stream->slots[stream->head];
+    frame->state = SLOT_BUSY;
+    stream->head = (uint16_t)((stream->head + 1) % stream->capacity);
+    stream->ready--;
+    stream->in_flight++;
+    stream->stats.delivered++;
+    pthread_mutex_unlock(&stream->lock);
+    return frame;
+}
+
+void protocol_stream_release(protocol_stream_t* stream, protocol_stream_frame_t* frame)
+{
+    pthread_mutex_lock(&stream->lock);
+    if (frame->state == SLOT_BUSY)
+    {
+        frame->state = SLOT_FREE;
+        stream->in_flight--;
+        pthread_cond_signal(&stream->not_full);
+        if (stream->policy == PROTOCOL_STREAM_ORDERED)
+        {
+            pthread_cond_signal(&stream->not_empty);
+        }
+    }
+    pthread_mutex_unlock(&stream->lock);
+}
+
+void protocol_stream_close(protocol_stream_t* stream)
+{
+    pthread_mutex_lock(&stream->lock);
+    stream->closed = true;
+    pthread_cond_broadcast(&stream->not_empty);
+    pthread_cond_broadcast(&stream->not_full);
+    pthread_mutex_unlock(&stream->lock);
+}
+
+void protocol_stream_destroy(protocol_stream_t* stream)
+{
+    if (stream->slots)
+    {
+        pthread_cond_destroy(&stream->not_empty);
+        pthread_cond_destroy(&stream->not_full);
+        pthread_mutex_destroy(&stream->lock);
+        protocol_free(stream->slots);
+    }
+    memset(stream, 0, sizeof(*stream));
+}
+
+void protocol_demux_init(protocol_demux_t* demux)
+{
+    memset(demux, 0, sizeof(*demux));
+}
+
+void protocol_demux_route(protocol_demux_t* demux, const uint8_t type, protocol_stream_t* stream)
+{
+    demux->routes[PROTOCOL_TYPE_ID(type)] = stream;
+}
+
+void protocol_demux_set_fallback(protocol_demux_t* demux, protocol_stream_t* stream)
+{
+    demux->fallback = stream;
+}
+
+int protocol_demux_dispatch(protocol_demux_t* demux, const uint8_t type, const uint8_t* data, const uint16_t len,
+                            const protocol_frame_times_t* times)
+{
+    protocol_stream_t* stream = demux->routes[PROTOCOL_TYPE_ID(type)];
+    if (!stream)
+    {
+        stream = demux->fallback;
+    }
+    if (!stream)
+    {
+        demux->unrouted++;
+        return -1;
+    }
+    return protocol_stream_push(stream, type, data, len, times);
+}
+
+static void demux_handler(void* user, const uint8_t type, const uint8_t* data, const uint16_t len,
+                          const protocol_frame_times_t* times)
+{
+    protocol_demux_dispatch(user, type, data, len, times);
+}
+
+void protocol_demux_attach(protocol_demux_t* demux, protocol_receiver* receiver)
+{
+    protocol_receiver_set_handler(receiver, demux_handler, demux);
+}
@@ -0,0 +1,232 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pkt_diag.h"
+#include "mpmc_ring.h"
+#include "pkt_trace.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+static const char* const diag_names[PROTOCOL_DIAG_CODE_COUNT] = {
+    "pack: data length too long",
+    "pack: malloc failed",
+    "rx: new data discarded",
+    "txq: queue full",
+    "pack: invalid type",
+};
+
+// 计数与限速状态（未初始化时也可以计数）
+static atomic_uint_fast64_t diag_counts[PROTOCOL_DIAG_CODE_COUNT];
+static atomic_uint_fast64_t diag_window_start[PROTOCOL_DIAG_CODE_COUNT];
+static atomic_uint_fast32_t diag_window_count[PROTOCOL_DIAG_CODE_COUNT];
+static atomic_uint_fast64_t diag_pending_suppressed[PROTOCOL_DIAG_CODE_COUNT];
+static atomic_uint_fast64_t diag_suppressed;
+static atomic_uint_fast64_t diag_queue_dropped;
+static atomic_uint_fast64_t diag_delivered;
+
+// 事件队列
+static MpmcRing_t diag_queue;
+static bool diag_queue_allocated; // 队列分配后不再释放：关闭时可能仍有报告线程正在入队
+static atomic_bool diag_ready;
+static uint32_t diag_burst = PROTOCOL_DIAG_DEFAULT_BURST;
+static uint64_t diag_interval_ns = PROTOCOL_DIAG_DEFAULT_INTERVAL_MS * 1000000ull;
+
+// 输出（drain 串行执行）
+static pthread_mutex_t diag_drain_lock = PTHREAD_MUTEX_INITIALIZER;
+static protocol_diag_sink_fn diag_sink;
+static void* diag_sink_user;
+
+// 后台线程
+static pthread_t diag_thread;
+static atomic_bool diag_running;
+static uint32_t diag_period_ms;
+
+bool protocol_diag_init(const uint32_t queue_capacity, const uint32_t burst, const uint32_t interval_ms)
+{
+    if (atomic_load(&diag_ready))
+    {
+        return true;
+    }
+    if (!diag_queue_allocated)
+    {
+        if (!MpmcRing_Init(&diag_queue, queue_capacity, sizeof(protocol_diag_event_t)))
+        {
+            return false;
+        }
+        diag_queue_allocated = true;
+    }
+    diag_burst = burst;
+    diag_interval_ns = (uint64_t)interval_ms * 1000000ull;
+    atomic_store_explicit(&diag_ready, true, memory_order_release);
+    return true;
+}
+
+void protocol_diag_set_sink(const protocol_diag_sink_fn sink, void* user)
+{
+    pthread_mutex_lock(&diag_drain_lock);
+    diag_sink = sink;
+    diag_sink_user = user;
+    pthread_mutex_unlock(&diag_drain_lock);
+}
+
+void protocol_diag_report(const protocol_diag_code_t code, const uint64_t arg)
+{
+    if ((unsigned)code >= PROTOCOL_DIAG_CODE_COUNT)
+    {
+        return;
+    }
+    atomic_fetch_add_explicit(&diag_counts[code], 1, memory_order_relaxed);
+    if (!atomic_load_explicit(&diag_ready, memory_order_acquire))
+    {
+        return;
+    }
+
+    // 固定窗口限速：窗口过期时由一个线程开启新窗口
+    const uint64_t now = protocol_trace_now_ns();
+    uint_fast64_t start = atomic_load_explicit(&diag_window_start[code], memory_order_relaxed);
+    if (now - start >= diag_interval_ns &&
+        atomic_compare_exchange_strong_explicit(&diag_window_start[code], &start, now, memory_order_relaxed,
+                                                memory_order_relaxed))
+    {
+        atomic_store_explicit(&diag_window_count[code], 0, memory_order_relaxed);
+    }
+    if (atomic_fetch_add_explicit(&diag_window_count[code], 1, memory_order_relaxed) >= diag_burst)
+    {
+        atomic_fetch_add_explicit(&diag_pending_suppressed[code], 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&diag_suppressed, 1, memory_order_relaxed);
+        return;
+    }
+
+    protocol_diag_event_t event;
+    event.ts_ns = now;
+    event.arg = arg;
+    event.suppressed = atomic_exchange_explicit(&diag_pending_suppressed[code], 0, memory_order_relaxed);
+    event.code = (uint32_t)code;
+    if (!MpmcRing_Enqueue(&diag_queue, (const uint8_t*)&event, sizeof(event)))
+    {
+        atomic_fetch_add_explicit(&diag_queue_dropped, 1, memory_order_relaxed);
+    }
+}
+
+size_t protocol_diag_drain(void)
+{
+    if (!atomic_load_explicit(&diag_ready, memory_order_acquire))
+    {
+        return 0;
+    }
+    size_t handled = 0;
+    pthread_mutex_lock(&diag_drain_lock);
+    protocol_diag_event_t event;
+    uint16_t len;
+    while (MpmcRing_Dequeue(&diag_queue, (uint8_t*)&event, &len))
+    {
+        if (diag_sink)
+        {
+            diag_sink(diag_sink_user, &event);
+        }
+        handled++;
+    }
+    pthread_mutex_unlock(&diag_drain_lock);
+    atomic_fetch_add_explicit(&diag_delivered, handled, memory_order_relaxed);
+    return handled;
+}
+
+static void* diag_thread_main(void* arg)
+{
+    (void)arg;
+    const struct timespec period = {
+        (time_t)(diag_period_ms / 1000), (long)(diag_period_ms % 1000) * 1000000L
+    };
+    while (atomic_load_explicit(&diag_running, memory_order_acquire))
+    {
+        nanosleep(&period, NULL);
+        protocol_diag_drain();
+    }
+    return NULL;
+}
+
+bool protocol_diag_start(const uint32_t period_ms)
+{
+    if (!atomic_load(&diag_ready) || atomic_load(&diag_running))
+    {
+        return false;
+    }
+    diag_period_ms = period_ms ? period_ms : 1;
+    atomic_store(&diag_running, true);
+    if (pthread_create(&diag_thread, NULL, diag_thread_main, NULL) != 0)
+    {
+        atomic_store(&diag_running, false);
+        return false;
+    }
+    return true;
+}
+
+void protocol_diag_stop(void)
+{
+    if (atomic_exchange(&diag_running, false))
+    {
+        pthread_join(diag_thread, NULL);
+    }
+    protocol_diag_drain();
+}
+
+void protocol_diag_shutdown(void)
+{
+    protocol_diag_stop();
+    // 只停止排队，不释放队列：已经通过 diag_ready 检查的报告线程仍可能写入
+    atomic_store_explicit(&diag_ready, false, memory_order_release);
+}
+
+void protocol_diag_get_stats(protocol_diag_stats_t* stats)
+{
+    for (int i = 0; i < PROTOCOL_DIAG_CODE_COUNT; i++)
+    {
+        stats->counts[i] = atomic_load_explicit(&diag_counts[i], memory_order_relaxed);
+    }
+    stats->suppressed = atomic_load_explicit(&diag_suppressed, memory_order_relaxed);
+    stats->queue_dropped = atomic_load_explicit(&diag_queue_dropped, memory_order_relaxed);
+    stats->delivered = atomic_load_explicit(&diag_delivered, memory_order_relaxed);
+}
+
+void protocol_diag_reset_stats(void)
+{
+    for (int i = 0; i < PROTOCOL_DIAG_CODE_COUNT; i++)
+    {
+        atomic_store(&diag_counts[i], 0);
+        atomic_store(&diag_window_start[i], 0);
+        atomic_store(&diag_window_count[i], 0);
+        atomic_store(&diag_pending_suppressed[i], 0);
+    }
+    atomic_store(&diag_suppressed, 0);
+    atomic_store(&diag_queue_dropped, 0);
+    atomic_store(&diag_delivered, 0);
+}
+
+const char* protocol_diag_name(const protocol_diag_code_t code)
+{
+    return (unsigned)code < PROTOCOL_DIAG_CODE_COUNT ? diag_names[code] : "unknown";
+}
+
+int protocol_diag_format(const protocol_diag_event_t* event, char* out, const size_t cap)
+{
+    int n = snprintf(out, cap, "[%" PRIu64 ".%06" PRIu64 "] %s (%" PRIu64 ")", (uint64_t)(event->ts_ns / 1000000000u),
+                     (uint64_t)(event->ts_ns / 1000 % 1000000u), protocol_diag_name((protocol_diag_code_t)event->code),
+                     event->arg);
+    if (event->suppressed && n >= 0 && (size_t)n < cap)
+    {
+        const int more = snprintf(out + n, cap - (size_t)n, ", %" PRIu64 " similar suppressed", event->suppressed);
+        n = more < 0 ? n : n + more;
+    }
+    return n;
+}
+
+void protocol_diag_stderr_sink(void* user, const protocol_diag_event_t* event)
+{
+    (void)user;
+    char line[160];
+    protocol_diag_format(event, line, sizeof(line));
+    fprintf(stderr, "%s\n", line);
+}
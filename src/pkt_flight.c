@@ -0,0 +1,248 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pkt_flight.h"
+#include "pkt_endian.h"
+#include "pkt_pool.h"
+#include "pkt_trace.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+// 导出时使用的条目快照
+typedef struct
+{
+    uint64_t seq;
+    uint64_t ts_ns;
+    uint8_t event;
+    uint8_t type;
+    uint16_t len;
+    uint16_t caplen;
+    uint8_t data[PROTOCOL_FLIGHT_CAPTURE_LEN];
+} flight_snapshot_t;
+
+static const char* const event_names[] = {"RX", "TX", "CRC_ERROR", "FORMAT_ERROR", "DROP", "USER"};
+
+bool protocol_flight_init(protocol_flight_t* flight, const uint32_t capacity)
+{
+    uint32_t rounded = 1;
+    while (rounded < capacity && rounded < (1u << 30))
+    {
+        rounded <<= 1;
+    }
+    flight->entries = protocol_malloc((size_t)rounded * sizeof(protocol_flight_entry_t));
+    if (!flight->entries)
+    {
+        flight->capacity = 0;
+        return false;
+    }
+    for (uint32_t i = 0; i < rounded; i++)
+    {
+        atomic_init(&flight->entries[i].seq, 0);
+    }
+    flight->capacity = rounded;
+    atomic_init(&flight->next, 0);
+    return true;
+}
+
+void protocol_flight_record(protocol_flight_t* flight, const protocol_flight_event_t event, const uint8_t type,
+                            const uint8_t* data, const uint16_t len)
+{
+    const uint64_t seq = atomic_fetch_add_explicit(&flight->next, 1, memory_order_relaxed);
+    protocol_flight_entry_t* entry = &flight->entries[seq & (flight->capacity - 1)];
+    // 先标记为写入中，导出方看到序号变化就丢弃这条快照
+    atomic_store_explicit(&entry->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    entry->ts_ns = protocol_trace_now_ns();
+    entry->event = (uint8_t)event;
+    entry->type = type;
+    entry->len = len;
+    entry->caplen = len < PROTOCOL_FLIGHT_CAPTURE_LEN ? len : PROTOCOL_FLIGHT_CAPTURE_LEN;
+    memcpy(entry->data, data, entry->caplen);
+    atomic_store_explicit(&entry->seq, seq + 1, memory_order_release);
+}
+
+/**
+ * 读取一条完整的快照
+ * @return 是否成功（条目已被覆盖或正在写入时失败）
+ */
+static bool snapshot_entry(const protocol_flight_t* flight, const uint64_t seq, flight_snapshot_t* out)
+{
+    protocol_flight_entry_t* entry = &flight->entries[seq & (flight->capacity - 1)];
+    if (atomic_load_explicit(&entry->seq, memory_order_acquire) != seq + 1)
+    {
+        return false;
+    }
+    out->seq = seq;
+    out->ts_ns = entry->ts_ns;
+    out->event = entry->event;
+    out->type = entry->type;
+    out->len = entry->len;
+    out->caplen = entry->caplen <= PROTOCOL_FLIGHT_CAPTURE_LEN ? entry->caplen : PROTOCOL_FLIGHT_CAPTURE_LEN;
+    memcpy(out->data, entry->data, out->caplen);
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&entry->seq, memory_order_relaxed) == seq + 1;
+}
+
+// 只用 write(2)，可在信号处理函数中调用
+static int write_all(const int fd, const void* data, size_t len)
+{
+    const uint8_t* p = data;
+    while (len > 0)
+    {
+        const ssize_t n = write(fd, p, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static size_t put_str(char* out, const char* s)
+{
+    const size_t n = strlen(s);
+    memcpy(out, s, n);
+    return n;
+}
+
+static size_t put_dec(char* out, uint64_t v)
+{
+    char tmp[20];
+    size_t n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    }
+    while (v);
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+static size_t put_hex8(char* out, const uint8_t v)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    out[0] = digits[v >> 4];
+    out[1] = digits[v & 0xF];
+    return 2;
+}
+
+static int dump_hex(const int fd, const flight_snapshot_t* s)
+{
+    char line[96 + 3 * PROTOCOL_FLIGHT_CAPTURE_LEN];
+    size_t n = put_dec(line, s->seq);
+    line[n++] = ' ';
+    n += put_dec(line + n, s->ts_ns);
+    line[n++] = ' ';
+    n += put_str(line + n, s->event < sizeof(event_names) / sizeof(event_names[0]) ? event_names[s->event] : "?");
+    n += put_str(line + n, " type=0x");
+    n += put_hex8(line + n, s->type);
+    n += put_str(line + n, " len=");
+    n += put_dec(line + n, s->len);
+    line[n++] = ':';
+    for (uint16_t i = 0; i < s->caplen; i++)
+    {
+        line[n++] = ' ';
+        n += put_hex8(line + n, s->data[i]);
+    }
+    line[n++] = '\n';
+    return write_all(fd, line, n);
+}
+
+static int dump_binary(const int fd, const flight_snapshot_t* s)
+{
+    uint8_t rec[PROTOCOL_FLIGHT_ENTRY_HEADER_LEN + PROTOCOL_FLIGHT_CAPTURE_LEN];
+    pkt_store_le64(rec, s->seq);
+    pkt_store_le64(rec + 8, s->ts_ns);
+    pkt_store_u8(rec + 16, s->event);
+    pkt_store_u8(rec + 17, s->type);
+    pkt_store_le16(rec + 18, s->len);
+    pkt_store_le16(rec + 20, s->caplen);
+    pkt_store_le16(rec + 22, 0);
+    memcpy(rec + PROTOCOL_FLIGHT_ENTRY_HEADER_LEN, s->data, s->caplen);
+    return write_all(fd, rec, PROTOCOL_FLIGHT_ENTRY_HEADER_LEN + (size_t)s->caplen);
+}
+
+int protocol_flight_dump(protocol_flight_t* flight, const int fd, const protocol_flight_format_t format)
+{
+    if (format == PROTOCOL_FLIGHT_DUMP_BINARY)
+    {
+        uint8_t header[PROTOCOL_FLIGHT_FILE_HEADER_LEN];
+        memcpy(header, PROTOCOL_FLIGHT_MAGIC, 8);
+        pkt_store_le32(header + 8, PROTOCOL_FLIGHT_VERSION);
+        pkt_store_le32(header + 12, flight->capacity);
+        if (write_all(fd, header, sizeof(header)) != 0)
+        {
+            return -1;
+        }
+    }
+    const uint64_t end = atomic_load_explicit(&flight->next, memory_order_acquire);
+    const uint64_t begin = end > flight->capacity ? end - flight->capacity : 0;
+    int dumped = 0;
+    for (uint64_t seq = begin; seq < end; seq++)
+    {
+        flight_snapshot_t s;
+        if (!snapshot_entry(flight, seq, &s))
+        {
+            continue;
+        }
+        const int rc = format == PROTOCOL_FLIGHT_DUMP_BINARY ? dump_binary(fd, &s) : dump_hex(fd, &s);
+        if (rc != 0)
+        {
+            return -1;
+        }
+        dumped++;
+    }
+    return dumped;
+}
+
+static protocol_flight_t* signal_flight;
+static int signal_fd = -1;
+static protocol_flight_format_t signal_format;
+
+static void flight_signal_handler(const int signo)
+{
+    (void)signo;
+    const int saved_errno = errno;
+    if (signal_flight)
+    {
+        protocol_flight_dump(signal_flight, signal_fd, signal_format);
+    }
+    errno = saved_errno;
+}
+
+int protocol_flight_install_signal(protocol_flight_t* flight, const int signo, const int fd,
+                                   const protocol_flight_format_t format)
+{
+    signal_flight = flight;
+    signal_fd = fd;
+    signal_format = format;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = flight_signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    return sigaction(signo, &sa, NULL);
+}
+
+void protocol_flight_destroy(protocol_flight_t* flight)
+{
+    if (signal_flight == flight)
+    {
+        signal_flight = NULL;
+    }
+    protocol_free(flight->entries);
+    flight->entries = NULL;
+    flight->capacity = 0;
+}
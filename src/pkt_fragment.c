@@ -0,0 +1,218 @@
+#include "pkt_fragment.h"
+#include "pkt_protocol.h"
+#include "pkt_endian.h"
+#include "pkt_pool.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SLOT_FREE 0
+#define SLOT_ASSEMBLING 1
+#define SLOT_HELD 2
+
+int protocol_fragment_send(const protocol_type_t type, const uint16_t msg_id, const uint8_t* data,
+                           const uint32_t len, const fragment_emit emit, void* user)
+{
+    const uint32_t count = len == 0 ? 1 : (len + PROTOCOL_FRAGMENT_DATA_LEN - 1) / PROTOCOL_FRAGMENT_DATA_LEN;
+    if (count > UINT16_MAX || type >= PROTOCOL_TYPE_MAX)
+    {
+        return -1;
+    }
+
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    for (uint32_t index = 0; index < count; index++)
+    {
+        const uint32_t offset = index * PROTOCOL_FRAGMENT_DATA_LEN;
+        const uint16_t chunk = len - offset > PROTOCOL_FRAGMENT_DATA_LEN
+                                   ? PROTOCOL_FRAGMENT_DATA_LEN
+                                   : (uint16_t)(len - offset);
+        pkt_store_le16(payload, msg_id);
+        pkt_store_le16(payload + 2, (uint16_t)index);
+        pkt_store_le16(payload + 4, (uint16_t)count);
+        pkt_store_u8(payload + 6, (uint8_t)type);
+        memcpy(payload + PROTOCOL_FRAGMENT_HEADER_LEN, data + offset, chunk);
+
+        const uint16_t frame_len = protocol_pack_frame_into(PROTOCOL_TYPE_FRAGMENT, payload,
+                                                            PROTOCOL_FRAGMENT_HEADER_LEN + chunk, frame,
+                                                            sizeof(frame));
+        if (frame_len == 0 || emit(user, frame, frame_len) != 0)
+        {
+            return -1;
+        }
+    }
+    return (int)count;
+}
+
+bool protocol_reassembler_init(protocol_reassembler_t* reassembler, const uint16_t max_slots,
+                               const uint32_t max_message_len, const uint32_t timeout_ms,
+                               const message_callback callback)
+{
+    memset(reassembler, 0, sizeof(*reassembler));
+    if (max_slots == 0 || max_message_len == 0)
+    {
+        return false;
+    }
+    const uint32_t max_fragments = (max_message_len + PROTOCOL_FRAGMENT_DATA_LEN - 1) / PROTOCOL_FRAGMENT_DATA_LEN;
+    if (max_fragments > UINT16_MAX)
+    {
+        return false;
+    }
+    const size_t bitmap_len = (max_fragments + 7) / 8;
+    const size_t buffer_len = (size_t)max_fragments * PROTOCOL_FRAGMENT_DATA_LEN;
+
+    reassembler->slots = protocol_malloc(max_slots * sizeof(protocol_reassembly_slot_t));
+    reassembler->pool = protocol_malloc((bitmap_len + buffer_len) * max_slots);
+    if (!reassembler->slots || !reassembler->pool)
+    {
+        protocol_free(reassembler->slots);
+        protocol_free(reassembler->pool);
+        memset(reassembler, 0, sizeof(*reassembler));
+        return false;
+    }
+
+    memset(reassembler->slots, 0, max_slots * sizeof(protocol_reassembly_slot_t));
+    // 缓冲池布局: [slot0 buffer][slot1 buffer]...[slot0 bitmap][slot1 bitmap]...
+    for (uint16_t i = 0; i < max_slots; i++)
+    {
+        reassembler->slots[i].buffer = reassembler->pool + buffer_len * i;
+        reassembler->slots[i].bitmap = reassembler->pool + buffer_len * max_slots + bitmap_len * i;
+    }
+    reassembler->max_slots = max_slots;
+    reassembler->max_fragments = (uint16_t)max_fragments;
+    reassembler->timeout_ms = timeout_ms;
+    reassembler->callback = callback;
+    return true;
+}
+
+static protocol_reassembly_slot_t* find_slot(protocol_reassembler_t* reassembler, const uint8_t type,
+                                             const uint16_t msg_id, const uint16_t count, const uint32_t now_ms)
+{
+    protocol_reassembly_slot_t* free_slot = NULL;
+    for (uint16_t i = 0; i < reassembler->max_slots; i++)
+    {
+        protocol_reassembly_slot_t* slot = &reassembler->slots[i];
+        if (slot->state == SLOT_ASSEMBLING && slot->msg_id == msg_id && slot->type == type &&
+            slot->frag_count == count)
+        {
+            return slot;
+        }
+        if (slot->state == SLOT_FREE && !free_slot)
+        {
+            free_slot = slot;
+        }
+    }
+    if (free_slot)
+    {
+        free_slot->state = SLOT_ASSEMBLING;
+        free_slot->type = type;
+        free_slot->msg_id = msg_id;
+        free_slot->frag_count = count;
+        free_slot->frag_received = 0;
+        free_slot->total_len = 0;
+        free_slot->deadline_ms = now_ms + reassembler->timeout_ms;
+        memset(free_slot->bitmap, 0, (reassembler->max_fragments + 7) / 8);
+    }
+    return free_slot;
+}
+
+static void deliver(protocol_reassembler_t* reassembler, protocol_reassembly_slot_t* slot)
+{
+    const protocol_message_t msg = {
+        .type = slot->type,
+        .msg_id = slot->msg_id,
+        .data = slot->buffer,
+        .len = slot->total_len,
+        .slot = (uint16_t)(slot - reassembler->slots),
+    };
+    reassembler->stats.messages++;
+    slot->state = SLOT_HELD;
+    if (!reassembler->callback || !reassembler->callback(&msg))
+    {
+        slot->state = SLOT_FREE;
+    }
+}
+
+void protocol_reassembler_on_fragment(protocol_reassembler_t* reassembler, const uint8_t* payload,
+                                      const uint16_t len, const uint32_t now_ms)
+{
+    if (len < PROTOCOL_FRAGMENT_HEADER_LEN)
+    {
+        reassembler->stats.dropped++;
+        return;
+    }
+    const uint16_t msg_id = pkt_load_le16(payload);
+    const uint16_t index = pkt_load_le16(payload + 2);
+    const uint16_t count = pkt_load_le16(payload + 4);
+    const uint8_t type = pkt_load_u8(payload + 6);
+    const uint16_t chunk = len - PROTOCOL_FRAGMENT_HEADER_LEN;
+
+    // 除最后一片外分片必须满长，保证偏移可由序号直接计算；最后一片（可能来自解压后的帧）不能超过满长
+    const bool last = index + 1 == count;
+    if (count == 0 || index >= count || count > reassembler->max_fragments ||
+        (!last && chunk != PROTOCOL_FRAGMENT_DATA_LEN) || chunk > PROTOCOL_FRAGMENT_DATA_LEN)
+    {
+        reassembler->stats.dropped++;
+        return;
+    }
+
+    // 先回收超时的槽位，再为新消息分配
+    protocol_reassembler_poll(reassembler, now_ms);
+    protocol_reassembly_slot_t* slot = find_slot(reassembler, type, msg_id, count, now_ms);
+    if (!slot)
+    {
+        reassembler->stats.dropped++;
+        return;
+    }
+
+    const uint8_t bit = (uint8_t)(1u << (index & 7));
+    if (slot->bitmap[index >> 3] & bit)
+    {
+        reassembler->stats.duplicates++;
+        return;
+    }
+    slot->bitmap[index >> 3] |= bit;
+    slot->frag_received++;
+    reassembler->stats.fragments++;
+    memcpy(slot->buffer + (uint32_t)index * PROTOCOL_FRAGMENT_DATA_LEN,
+           payload + PROTOCOL_FRAGMENT_HEADER_LEN, chunk);
+    if (last)
+    {
+        slot->total_len = (uint32_t)index * PROTOCOL_FRAGMENT_DATA_LEN + chunk;
+    }
+
+    if (slot->frag_received == slot->frag_count)
+    {
+        deliver(reassembler, slot);
+    }
+}
+
+void protocol_reassembler_poll(protocol_reassembler_t* reassembler, const uint32_t now_ms)
+{
+    for (uint16_t i = 0; i < reassembler->max_slots; i++)
+    {
+        protocol_reassembly_slot_t* slot = &reassembler->slots[i];
+        // 使用有符号差值比较，兼容毫秒计数回绕
+        if (slot->state == SLOT_ASSEMBLING && (int32_t)(now_ms - slot->deadline_ms) >= 0)
+        {
+            slot->state = SLOT_FREE;
+            reassembler->stats.timeouts++;
+        }
+    }
+}
+
+void protocol_reassembler_release(protocol_reassembler_t* reassembler, const protocol_message_t* msg)
+{
+    if (msg->slot < reassembler->max_slots && reassembler->slots[msg->slot].state == SLOT_HELD)
+    {
+        reassembler->slots[msg->slot].state = SLOT_FREE;
+    }
+}
+
+void protocol_reassembler_destroy(protocol_reassembler_t* reassembler)
+{
+    protocol_free(reassembler->slots);
+    protocol_free(reassembler->pool);
+    memset(reassembler, 0, sizeof(*reassembler));
+}
@@ -0,0 +1,304 @@
+#include "pkt_pool.h"
+#include "pkt_protocol.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 每个块前的头部，记录大小等级，保持 16 字节对齐
+#define POOL_HEADER_SIZE 16
+#define POOL_LARGE_CLASS 0xFF
+// 每次向系统申请的块数
+#define POOL_SLAB_BLOCKS 64
+// 线程本地缓存容量及与全局链表之间的批量搬运数量
+#define POOL_CACHE_MAX 32
+#define POOL_CACHE_BATCH 16
+
+_Static_assert(PROTOCOL_MAX_FRAME_LEN <= 128, "最大帧必须落在最大大小等级内");
+
+static const uint32_t pool_class_sizes[PROTOCOL_POOL_CLASS_COUNT] = PROTOCOL_POOL_CLASS_SIZES;
+
+// 空闲块链表节点（复用块头部空间）
+typedef struct pool_node
+{
+    struct pool_node* next;
+} pool_node_t;
+
+// 全局大小等级
+typedef struct
+{
+    pthread_mutex_t lock;
+    pool_node_t* free_list;
+    atomic_uint_fast64_t allocs;
+    atomic_uint_fast64_t frees;
+    atomic_uint_fast64_t capacity;
+    atomic_uint_fast64_t refills;
+} pool_class_t;
+
+// 线程本地缓存
+typedef struct
+{
+    pool_node_t* items[POOL_CACHE_MAX];
+    uint16_t count;
+} pool_cache_t;
+
+static pool_class_t pool_classes[PROTOCOL_POOL_CLASS_COUNT] = {
+    {.lock = PTHREAD_MUTEX_INITIALIZER},
+    {.lock = PTHREAD_MUTEX_INITIALIZER},
+    {.lock = PTHREAD_MUTEX_INITIALIZER},
+};
+static atomic_uint_fast64_t pool_large_allocs;
+static atomic_uint_fast64_t pool_large_frees;
+
+static _Thread_local pool_cache_t pool_caches[PROTOCOL_POOL_CLASS_COUNT];
+static _Thread_local int pool_cache_registered;
+static pthread_key_t pool_cache_key;
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+
+// ---------------- 全局分配器钩子 ----------------
+
+static void* default_alloc(void* ctx, const size_t size)
+{
+    (void)ctx;
+    return malloc(size);
+}
+
+static void* default_realloc(void* ctx, void* ptr, const size_t size)
+{
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static void default_free(void* ctx, void* ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+static const protocol_allocator_t default_allocator = {default_alloc, default_realloc, default_free, NULL};
+static protocol_allocator_t current_allocator = {default_alloc, default_realloc, default_free, NULL};
+
+void protocol_set_allocator(const protocol_allocator_t* allocator)
+{
+    current_allocator = allocator ? *allocator : default_allocator;
+}
+
+void* protocol_malloc(const size_t size)
+{
+    return current_allocator.alloc(current_allocator.ctx, size);
+}
+
+void* protocol_realloc(void* ptr, const size_t size)
+{
+    return current_allocator.realloc(current_allocator.ctx, ptr, size);
+}
+
+void protocol_free(void* ptr)
+{
+    if (ptr)
+    {
+        current_allocator.free(current_allocator.ctx, ptr);
+    }
+}
+
+// ---------------- 帧缓冲池 ----------------
+
+static void pool_drain(pool_cache_t* cache, int class_id, uint16_t keep);
+
+// 线程退出时把本地缓存归还全局链表
+static void pool_cache_destructor(void* value)
+{
+    pool_cache_t* caches = value;
+    for (int i = 0; i < PROTOCOL_POOL_CLASS_COUNT; i++)
+    {
+        pool_drain(&caches[i], i, 0);
+    }
+}
+
+static void pool_key_create(void)
+{
+    pthread_key_create(&pool_cache_key, pool_cache_destructor);
+}
+
+static pool_cache_t* pool_thread_cache(const int class_id)
+{
+    if (!pool_cache_registered)
+    {
+        pthread_once(&pool_key_once, pool_key_create);
+        pthread_setspecific(pool_cache_key, pool_caches);
+        pool_cache_registered = 1;
+    }
+    return &pool_caches[class_id];
+}
+
+static int pool_class_of(const size_t size)
+{
+    for (int i = 0; i < PROTOCOL_POOL_CLASS_COUNT; i++)
+    {
+        if (size <= pool_class_sizes[i])
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 从全局链表批量补充本地缓存，全局链表为空时向系统申请一整块 slab
+static int pool_refill(pool_cache_t* cache, const int class_id)
+{
+    pool_class_t* cls = &pool_classes[class_id];
+    pthread_mutex_lock(&cls->lock);
+    if (!cls->free_list)
+    {
+        const size_t stride = POOL_HEADER_SIZE + pool_class_sizes[class_id];
+        uint8_t* slab = malloc(stride * POOL_SLAB_BLOCKS);
+        if (!slab)
+        {
+            pthread_mutex_unlock(&cls->lock);
+            return -1;
+        }
+        for (int i = POOL_SLAB_BLOCKS - 1; i >= 0; i--)
+        {
+            pool_node_t* node = (pool_node_t*)(slab + stride * i);
+            node->next = cls->free_list;
+            cls->free_list = node;
+        }
+        atomic_fetch_add_explicit(&cls->capacity, POOL_SLAB_BLOCKS, memory_order_relaxed);
+    }
+    while (cache->count < POOL_CACHE_BATCH && cls->free_list)
+    {
+        cache->items[cache->count++] = cls->free_list;
+        cls->free_list = cls->free_list->next;
+    }
+    pthread_mutex_unlock(&cls->lock);
+    atomic_fetch_add_explicit(&cls->refills, 1, memory_order_relaxed);
+    return 0;
+}
+
+// 把本地缓存归还全局链表，只保留 keep 个
+static void pool_drain(pool_cache_t* cache, const int class_id, const uint16_t keep)
+{
+    if (cache->count <= keep)
+    {
+        return;
+    }
+    pool_class_t* cls = &pool_classes[class_id];
+    pthread_mutex_lock(&cls->lock);
+    while (cache->count > keep)
+    {
+        pool_node_t* node = cache->items[--cache->count];
+        node->next = cls->free_list;
+        cls->free_list = node;
+    }
+    pthread_mutex_unlock(&cls->lock);
+}
+
+static void* pool_alloc(void* ctx, const size_t size)
+{
+    (void)ctx;
+    const int class_id = pool_class_of(size);
+    if (class_id < 0)
+    {
+        uint8_t* block = malloc(POOL_HEADER_SIZE + size);
+        if (!block)
+        {
+            return NULL;
+        }
+        block[0] = POOL_LARGE_CLASS;
+        atomic_fetch_add_explicit(&pool_large_allocs, 1, memory_order_relaxed);
+        return block + POOL_HEADER_SIZE;
+    }
+
+    pool_cache_t* cache = pool_thread_cache(class_id);
+    if (cache->count == 0 && pool_refill(cache, class_id) < 0)
+    {
+        return NULL;
+    }
+    uint8_t* block = (uint8_t*)cache->items[--cache->count];
+    block[0] = (uint8_t)class_id;
+    atomic_fetch_add_explicit(&pool_classes[class_id].allocs, 1, memory_order_relaxed);
+    return block + POOL_HEADER_SIZE;
+}
+
+static void pool_release(void* ctx, void* ptr)
+{
+    (void)ctx;
+    if (!ptr)
+    {
+        return;
+    }
+    uint8_t* block = (uint8_t*)ptr - POOL_HEADER_SIZE;
+    const uint8_t class_id = block[0];
+    if (class_id == POOL_LARGE_CLASS)
+    {
+        atomic_fetch_add_explicit(&pool_large_frees, 1, memory_order_relaxed);
+        free(block);
+        return;
+    }
+
+    pool_cache_t* cache = pool_thread_cache(class_id);
+    if (cache->count == POOL_CACHE_MAX)
+    {
+        pool_drain(cache, class_id, POOL_CACHE_MAX - POOL_CACHE_BATCH);
+    }
+    cache->items[cache->count++] = (pool_node_t*)block;
+    atomic_fetch_add_explicit(&pool_classes[class_id].frees, 1, memory_order_relaxed);
+}
+
+static void* pool_resize(void* ctx, void* ptr, const size_t size)
+{
+    if (!ptr)
+    {
+        return pool_alloc(ctx, size);
+    }
+    if (size == 0)
+    {
+        pool_release(ctx, ptr);
+        return NULL;
+    }
+    uint8_t* block = (uint8_t*)ptr - POOL_HEADER_SIZE;
+    const uint8_t class_id = block[0];
+    if (class_id == POOL_LARGE_CLASS)
+    {
+        uint8_t* resized = realloc(block, POOL_HEADER_SIZE + size);
+        return resized ? resized + POOL_HEADER_SIZE : NULL;
+    }
+    if (size <= pool_class_sizes[class_id])
+    {
+        return ptr;
+    }
+    void* resized = pool_alloc(ctx, size);
+    if (!resized)
+    {
+        return NULL;
+    }
+    memcpy(resized, ptr, pool_class_sizes[class_id]);
+    pool_release(ctx, ptr);
+    return resized;
+}
+
+static const protocol_allocator_t pool_allocator = {pool_alloc, pool_resize, pool_release, NULL};
+
+const protocol_allocator_t* protocol_pool_allocator(void)
+{
+    return &pool_allocator;
+}
+
+void protocol_pool_get_stats(protocol_pool_stats_t* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < PROTOCOL_POOL_CLASS_COUNT; i++)
+    {
+        protocol_pool_class_stats_t* out = &stats->classes[i];
+        out->block_size = pool_class_sizes[i];
+        out->allocs = atomic_load_explicit(&pool_classes[i].allocs, memory_order_relaxed);
+        out->frees = atomic_load_explicit(&pool_classes[i].frees, memory_order_relaxed);
+        out->in_use = out->allocs - out->frees;
+        out->capacity = atomic_load_explicit(&pool_classes[i].capacity, memory_order_relaxed);
+        out->refills = atomic_load_explicit(&pool_classes[i].refills, memory_order_relaxed);
+    }
+    stats->large_allocs = atomic_load_explicit(&pool_large_allocs, memory_order_relaxed);
+    stats->large_frees = atomic_load_explicit(&pool_large_frees, memory_order_relaxed);
+}
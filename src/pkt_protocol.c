@@ -1,4 +1,8 @@
 #include "pkt_protocol.h"
+#include "pkt_crc.h"
+#include "pkt_diag.h"
+#include "pkt_endian.h"
+#include "pkt_pool.h"
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -14,34 +18,50 @@ uint8_t* protocol_pack_frame(const protocol_type_t type, const uint8_t* data,
 {
     if (data_len > PROTOCOL_MAX_DATA_LEN)
     {
-        printf("pack: data length too long");
+        protocol_diag_report(PROTOCOL_DIAG_PACK_TOO_LONG, data_len);
         return NULL;
     }
 
-    // 计算总长度: Header(5) + Data(data_len) + CRC(2) + End(2)
-    *frame_len = sizeof(protocol_header_t) + data_len + sizeof(uint16_t) +
-        sizeof(uint16_t);
-    uint8_t* frame = malloc(*frame_len);
+    // 计算总长度: Header(5) + Data(data_len) + CRC(2，CRC32C 帧为 4) + End(2)
+    *frame_len = PROTOCOL_HEADER_SIZE + data_len + PROTOCOL_TRAILER_SIZE_OF(type);
+    uint8_t* frame = protocol_malloc(*frame_len);
     if (!frame)
     {
-        printf("pack: malloc failed");
+        protocol_diag_report(PROTOCOL_DIAG_PACK_NO_MEMORY, *frame_len);
         return NULL;
     }
 
-    protocol_header_t* header = (protocol_header_t*)frame;
-    header->header = TO_LE16(FRAME_HEADER);
-    header->type = type;
-    header->len = TO_LE16(data_len);
-    memcpy(header->data, data, data_len);
+    protocol_pack_frame_into(type, data, data_len, frame, *frame_len);
+    return frame;
+}
 
-    const uint16_t crc = crc16_ccitt(frame, sizeof(protocol_header_t) + data_len);
-    memcpy(frame + sizeof(protocol_header_t) + data_len, &crc, sizeof(crc));
+// 封装协议数据帧到调用方缓冲区
+uint16_t protocol_pack_frame_into(const protocol_type_t type, const uint8_t* data,
+                                  uint16_t data_len, uint8_t* out, uint16_t out_cap)
+{
+    const uint16_t frame_len = PROTOCOL_HEADER_SIZE + data_len + PROTOCOL_TRAILER_SIZE_OF(type);
+    if (data_len > PROTOCOL_MAX_DATA_LEN || out_cap < frame_len)
+    {
+        return 0;
+    }
 
-    const uint16_t tail = TO_LE16(FRAME_TAIL);
-    memcpy(frame + sizeof(protocol_header_t) + data_len + sizeof(crc), &tail,
-           sizeof(tail));
+    pkt_store_le16(out + PROTOCOL_OFFSET_HEADER, FRAME_HEADER);
+    pkt_store_u8(out + PROTOCOL_OFFSET_TYPE, (uint8_t)type);
+    pkt_store_le16(out + PROTOCOL_OFFSET_LEN, data_len);
+    memcpy(out + PROTOCOL_HEADER_SIZE, data, data_len);
 
-    return frame;
+    if (type & PROTOCOL_TYPE_FLAG_CRC32C)
+    {
+        const uint32_t crc = protocol_crc32c(0, out, PROTOCOL_HEADER_SIZE + data_len);
+        pkt_store_le32(out + PROTOCOL_HEADER_SIZE + data_len, crc);
+        pkt_store_le16(out + PROTOCOL_HEADER_SIZE + data_len + sizeof(crc), FRAME_TAIL);
+        return frame_len;
+    }
+    const uint16_t crc = crc16_ccitt(out, PROTOCOL_HEADER_SIZE + data_len);
+    pkt_store_le16(out + PROTOCOL_HEADER_SIZE + data_len, crc);
+    pkt_store_le16(out + PROTOCOL_HEADER_SIZE + data_len + sizeof(crc), FRAME_TAIL);
+
+    return frame_len;
 }
 
 // 解析器初始化
@@ -51,15 +71,52 @@ void protocol_parser_init(protocol_parser_t* parser)
     parser->state = STATE_WAIT_HEADER_1;
 }
 
+void protocol_parser_enable_timestamps(protocol_parser_t* parser, const bool enable)
+{
+    parser->timestamps = enable;
+}
+
 void protocol_parser_reset(protocol_parser_t* parser)
 {
+    // 先释放动态分配的数据缓冲区，再清空状态（保留统计和时间戳开关）
+    const protocol_parse_stats_t stats = parser->stats;
+    const bool timestamps = parser->timestamps;
+    protocol_free(parser->frame.data);
     protocol_parser_init(parser);
-    // 如果有动态分配的数据缓冲区需要释放：
-    if (parser->frame.data != NULL)
+    parser->stats = stats;
+    parser->timestamps = timestamps;
+}
+
+uint16_t protocol_parser_pending(const protocol_parser_t* parser)
+{
+    switch (parser->state)
     {
-        free(parser->frame.data);
-        parser->frame.data = NULL;
+    case STATE_WAIT_HEADER_1:
+        return 0;
+    case STATE_WAIT_HEADER_2:
+        return 1;
+    case STATE_WAIT_TYPE:
+        return 2;
+    case STATE_WAIT_LENGTH_1:
+        return 3;
+    case STATE_WAIT_LENGTH_2:
+        return 4;
+    case STATE_WAIT_DATA:
+        return PROTOCOL_HEADER_SIZE + parser->data_index;
+    case STATE_WAIT_CRC_1:
+        return PROTOCOL_HEADER_SIZE + parser->frame.len;
+    case STATE_WAIT_CRC_2:
+        return PROTOCOL_HEADER_SIZE + parser->frame.len + 1;
+    case STATE_WAIT_CRC_3:
+        return PROTOCOL_HEADER_SIZE + parser->frame.len + 2;
+    case STATE_WAIT_CRC_4:
+        return PROTOCOL_HEADER_SIZE + parser->frame.len + 3;
+    case STATE_WAIT_TAIL_1:
+        return PROTOCOL_HEADER_SIZE + parser->frame.len + PROTOCOL_TRAILER_SIZE_OF(parser->frame.type) - 2;
+    case STATE_WAIT_TAIL_2:
+        return PROTOCOL_HEADER_SIZE + parser->frame.len + PROTOCOL_TRAILER_SIZE_OF(parser->frame.type) - 1;
     }
+    return 0;
 }
 
 // 解析协议数据流
@@ -77,11 +134,16 @@ int protocol_parse_byte(protocol_parser_t* parser, uint8_t byte)
         // 注意 小端
         if (byte == (FRAME_HEADER >> 8))
         {
-            parser->frame.header = TO_LE16(FRAME_HEADER);
+            parser->frame.header = FRAME_HEADER;
             parser->state = STATE_WAIT_TYPE;
+            if (parser->timestamps)
+            {
+                parser->times.header_ns = protocol_trace_now_ns();
+            }
         }
-        else
+        else if (byte != (FRAME_HEADER & 0xFF))
         {
+            // 连续的 0x55 仍可能是帧头的第一个字节
             parser->state = STATE_WAIT_HEADER_1;
         }
         break;
@@ -94,17 +156,31 @@ int protocol_parse_byte(protocol_parser_t* parser, uint8_t byte)
         parser->state = STATE_WAIT_LENGTH_2;
         break;
     case STATE_WAIT_LENGTH_2:
-        parser->frame.len |= (byte << 8);
-        parser->frame.len = TO_LE16(parser->frame.len);
-        parser->frame.data = (uint8_t*)malloc(parser->frame.len);
+        parser->frame.len |= (uint16_t)(byte << 8);
+        // 超长的长度字段只可能来自噪声或错位，直接重新同步
+        if (parser->frame.len > PROTOCOL_MAX_DATA_LEN)
+        {
+            parser->stats.format_errors++;
+            parser->state = STATE_WAIT_HEADER_1;
+            break;
+        }
+        parser->frame.data = (uint8_t*)protocol_malloc(parser->frame.len);
         parser->data_index = 0;
-        parser->state = STATE_WAIT_DATA;
+        parser->state = parser->frame.len > 0 ? STATE_WAIT_DATA : STATE_WAIT_CRC_1;
+        if (parser->frame.len == 0 && parser->timestamps)
+        {
+            parser->times.payload_ns = protocol_trace_now_ns();
+        }
         break;
     case STATE_WAIT_DATA:
         parser->frame.data[parser->data_index++] = byte;
         if (parser->data_index >= parser->frame.len)
         {
             parser->state = STATE_WAIT_CRC_1;
+            if (parser->timestamps)
+            {
+                parser->times.payload_ns = protocol_trace_now_ns();
+            }
         }
         break;
     case STATE_WAIT_CRC_1:
@@ -112,8 +188,15 @@ int protocol_parse_byte(protocol_parser_t* parser, uint8_t byte)
         parser->state = STATE_WAIT_CRC_2;
         break;
     case STATE_WAIT_CRC_2:
-        parser->frame.crc |= (byte << 8);
-        parser->frame.crc = TO_LE16(parser->frame.crc);
+        parser->frame.crc |= (uint32_t)byte << 8;
+        parser->state = (parser->frame.type & PROTOCOL_TYPE_FLAG_CRC32C) ? STATE_WAIT_CRC_3 : STATE_WAIT_TAIL_1;
+        break;
+    case STATE_WAIT_CRC_3:
+        parser->frame.crc |= (uint32_t)byte << 16;
+        parser->state = STATE_WAIT_CRC_4;
+        break;
+    case STATE_WAIT_CRC_4:
+        parser->frame.crc |= (uint32_t)byte << 24;
         parser->state = STATE_WAIT_TAIL_1;
         break;
     case STATE_WAIT_TAIL_1:
@@ -123,7 +206,9 @@ int protocol_parse_byte(protocol_parser_t* parser, uint8_t byte)
         }
         else
         {
-            free(parser->frame.data);
+            parser->stats.format_errors++;
+            protocol_free(parser->frame.data);
+            parser->frame.data = NULL;
             parser->state = STATE_WAIT_HEADER_1;
         }
         break;
@@ -131,30 +216,40 @@ int protocol_parse_byte(protocol_parser_t* parser, uint8_t byte)
         if (byte == (FRAME_TAIL >> 8))
         {
             // 构造协议头和数据部分的字节流
-            uint8_t header_part[5];
-            header_part[0] =
-                (uint8_t)(parser->frame.header & 0xFF); // Header低字节
-            header_part[1] =
-                (uint8_t)((parser->frame.header >> 8) & 0xFF); // Header高字节
-            header_part[2] = parser->frame.type; // 类型
-            header_part[3] = (uint8_t)(parser->frame.len & 0xFF); // 长度低字节
-            header_part[4] =
-                (uint8_t)((parser->frame.len >> 8) & 0xFF); // 长度高字节
+            uint8_t header_part[PROTOCOL_HEADER_SIZE];
+            pkt_store_le16(header_part + PROTOCOL_OFFSET_HEADER, parser->frame.header);
+            pkt_store_u8(header_part + PROTOCOL_OFFSET_TYPE, parser->frame.type);
+            pkt_store_le16(header_part + PROTOCOL_OFFSET_LEN, parser->frame.len);
 
             // 计算CRC：协议头 + 数据
-            uint16_t crc = crc16_ccitt(header_part, sizeof(header_part));
-            if (parser->frame.len > 0)
+            uint32_t crc;
+            if (parser->frame.type & PROTOCOL_TYPE_FLAG_CRC32C)
             {
-                crc =
-                    crc16_ccitt_continue(crc, parser->frame.data, parser->frame.len);
+                crc = protocol_crc32c(0, header_part, sizeof(header_part));
+                crc = protocol_crc32c(crc, parser->frame.data, parser->frame.len);
+            }
+            else
+            {
+                crc = crc16_ccitt(header_part, sizeof(header_part));
+                if (parser->frame.len > 0)
+                {
+                    crc = crc16_ccitt_continue((uint16_t)crc, parser->frame.data, parser->frame.len);
+                }
             }
 
             if (parser->frame.crc == crc)
             {
+                parser->stats.frames++;
                 return 1; // 解析成功
             }
+            parser->stats.crc_errors++;
         }
-        free(parser->frame.data);
+        else
+        {
+            parser->stats.format_errors++;
+        }
+        protocol_free(parser->frame.data);
+        parser->frame.data = NULL;
         parser->state = STATE_WAIT_HEADER_1;
         break;
     }
@@ -206,19 +301,6 @@ static uint16_t crc16_ccitt_continue(uint16_t crc, const uint8_t* data,
     return crc;
 }
 
-uint16_t htole16(const uint16_t value)
-{
-    return ((value & 0xFF00) >> 8) | ((value & 0x00FF) << 8);
-}
-
-uint32_t htole32(const uint32_t x)
-{
-    return ((x & 0xFF000000) >> 24) |
-        ((x & 0x00FF0000) >> 8) |
-        ((x & 0x0000FF00) << 8) |
-        ((x & 0x000000FF) << 24);
-}
-
 void print_hex_data(const uint8_t* data, const uint16_t len) {
     for (uint16_t i = 0; i < len; i++) {
         printf("%02X ", data[i]);
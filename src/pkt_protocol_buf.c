@@ -3,28 +3,129 @@
 //
 #include "pkt_protocol.h"
 #include "pkt_protocol_buf.h"
+#include "pkt_pool.h"
+#include "pkt_scan.h"
+#include "pkt_diag.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
-#include <stdio.h>
 
 
 /**
- * 尝试从缓冲区解析完整帧
+ * 记录交付时间并统计延迟
+ * @return 当前帧的时间戳，未开启时间戳时为 NULL
+ */
+static const protocol_frame_times_t* stamp_dispatch(protocol_receiver* receiver)
+{
+    if (!receiver->parser.timestamps)
+    {
+        return NULL;
+    }
+    receiver->parser.times.dispatch_ns = protocol_trace_now_ns();
+    if (receiver->latency)
+    {
+        protocol_latency_record(receiver->latency,
+                                receiver->parser.times.dispatch_ns - receiver->parser.times.header_ns);
+    }
+    return &receiver->parser.times;
+}
+
+/**
+ * 交给处理函数或用户回调
+ */
+static void deliver(protocol_receiver* receiver, const uint8_t type, const uint8_t* data, const uint16_t len)
+{
+    const protocol_frame_times_t* times = stamp_dispatch(receiver);
+    if (receiver->handler)
+    {
+        receiver->handler(receiver->handler_user, type, data, len, times);
+    }
+    else if (receiver->callback)
+    {
+        receiver->callback(type, data, len);
+    }
+}
+
+/**
+ * 将解析完成的帧交给用户回调，压缩帧先解压
  * @param receiver   协议接收器结构体指针
  */
-static void try_parse_frame(protocol_receiver* receiver)
+static void dispatch_frame(protocol_receiver* receiver)
+{
+    const protocol_frame_t* frame = &receiver->parser.frame;
+    if (!receiver->callback && !receiver->handler)
+    {
+        return;
+    }
+    if ((frame->type & PROTOCOL_TYPE_FLAG_COMPRESSED) && receiver->compressor)
+    {
+        uint8_t raw[PROTOCOL_MAX_UNCOMPRESSED_LEN];
+        const int raw_len = protocol_decompress_payload(receiver->compressor, frame->data, frame->len,
+                                                        raw, sizeof(raw));
+        if (raw_len >= 0)
+        {
+            deliver(receiver, PROTOCOL_TYPE_ID(frame->type), raw, (uint16_t)raw_len);
+        }
+        return;
+    }
+    // 校验方式只与链路有关，不交给上层
+    deliver(receiver, frame->type & ~PROTOCOL_TYPE_FLAG_CRC32C, frame->data, frame->len);
+}
+
+/**
+ * 解析错误总数
+ */
+static uint32_t parse_errors(const protocol_parser_t* parser)
+{
+    return parser->stats.crc_errors + parser->stats.format_errors;
+}
+
+/**
+ * 把刚发生的解析错误连同出错前最多一帧长度的原始字节记入飞行记录器
+ * @param receiver   协议接收器结构体指针
+ * @param crc_errors 解析当前字节前的 CRC 错误数
+ */
+static void record_parse_error(const protocol_receiver* receiver, const uint32_t crc_errors)
+{
+    const size_t end = receiver->processed_pos + 1;
+    const size_t len = end < PROTOCOL_MAX_FRAME_LEN ? end : PROTOCOL_MAX_FRAME_LEN;
+    const protocol_flight_event_t event = receiver->parser.stats.crc_errors != crc_errors
+                                              ? PROTOCOL_FLIGHT_CRC_ERROR
+                                              : PROTOCOL_FLIGHT_FORMAT_ERROR;
+    protocol_flight_record(receiver->flight, event, receiver->parser.frame.type, receiver->buffer + end - len,
+                           (uint16_t)len);
+}
+
+/**
+ * 从 processed_pos 解析到下一个完整帧为止
+ * 成功时 processed_pos 已跳到帧末尾，解析器中仍保留该帧，调用方处理后须 protocol_parser_reset
+ * @param receiver     协议接收器结构体指针
+ * @param frame_start  输出帧起始位置
+ * @return 是否得到完整帧，数据用完时返回 false
+ */
+static bool parse_next_frame(protocol_receiver* receiver, size_t* frame_start)
 {
-    // 记录未处理数据的起始位置
-    size_t unprocessed_start = 0;
     while (receiver->processed_pos < receiver->write_pos)
     {
+        if (receiver->parser.state == STATE_WAIT_HEADER_1)
+        {
+            // 等待帧头时整块跳过噪声
+            receiver->processed_pos += protocol_scan_header(receiver->buffer + receiver->processed_pos,
+                                                            receiver->write_pos - receiver->processed_pos);
+            if (receiver->processed_pos == receiver->write_pos)
+            {
+                break;
+            }
+        }
         const uint8_t byte = receiver->buffer[receiver->processed_pos];
+        // 只在开启飞行记录器时比较错误计数
+        const uint32_t errors = receiver->flight ? parse_errors(&receiver->parser) : 0;
+        const uint32_t crc_errors = receiver->flight ? receiver->parser.stats.crc_errors : 0;
         if (protocol_parse_byte(&receiver->parser, byte))
         {
             // 解析成功，计算预期帧长
-            const uint16_t expect_frame_len = sizeof(protocol_header_t) + receiver->parser.frame.len + sizeof(uint16_t)
-                * 2;
+            const uint16_t expect_frame_len = PROTOCOL_HEADER_SIZE + receiver->parser.frame.len +
+                PROTOCOL_TRAILER_SIZE_OF(receiver->parser.frame.type);
 
             // 计算帧起始位置并校验合法性
             const size_t frame_start_pos = receiver->processed_pos + 1 - expect_frame_len;
@@ -34,37 +135,197 @@ static void try_parse_frame(protocol_receiver* receiver)
                 (frame_end_pos <= receiver->write_pos);
             if (valid_frame_boundary)
             {
-                if (receiver->callback)
+                if (receiver->flight)
                 {
-                    receiver->callback(receiver->parser.frame.type, receiver->parser.frame.data,
-                                       receiver->parser.frame.len);
+                    protocol_flight_record(receiver->flight, PROTOCOL_FLIGHT_RX, receiver->parser.frame.type,
+                                           receiver->buffer + frame_start_pos, expect_frame_len);
                 }
                 // 直接跳到帧末尾，跳过已处理数据
                 receiver->processed_pos = frame_end_pos;
-                // 更新未处理数据起始点
-                unprocessed_start = receiver->processed_pos;
+                *frame_start = frame_start_pos;
+                return true;
             }
-            else
-            {
-                receiver->processed_pos++;
-            }
-            // 无论是否成功，重置解析器
+            receiver->processed_pos++;
             protocol_parser_reset(&receiver->parser);
         }
         else
         {
+            if (receiver->flight && parse_errors(&receiver->parser) != errors)
+            {
+                record_parse_error(receiver, crc_errors);
+            }
             // 解析未完成，正常推进
             receiver->processed_pos++;
         }
     }
+    return false;
+}
+
+/**
+ * 尝试从缓冲区解析完整帧
+ * @param receiver   协议接收器结构体指针
+ */
+static void try_parse_frame(protocol_receiver* receiver)
+{
+    // 记录未处理数据的起始位置
+    size_t unprocessed_start = 0;
+    size_t frame_start;
+    while (parse_next_frame(receiver, &frame_start))
+    {
+        dispatch_frame(receiver);
+        protocol_parser_reset(&receiver->parser);
+        // 更新未处理数据起始点
+        unprocessed_start = receiver->processed_pos;
+    }
     // 移动未处理数据到缓冲区头部
     if (unprocessed_start > 0)
     {
         size_t remaining = receiver->write_pos - unprocessed_start;
         memmove(receiver->buffer, receiver->buffer + unprocessed_start, remaining);
         receiver->write_pos = remaining;
-        receiver->processed_pos = 0;
+        // 剩余数据已经送入解析器，不能重复解析
+        receiver->processed_pos = remaining;
+    }
+}
+
+
+/**
+ * 填充拉取的帧，负载直接指向缓冲区中的帧，压缩帧解压到 pull_scratch
+ * @param receiver     协议接收器结构体指针
+ * @param frame_start  帧起始位置
+ * @param view         输出帧
+ * @return 是否成功（解压失败时丢弃该帧）
+ */
+static bool fill_view(protocol_receiver* receiver, const size_t frame_start, protocol_frame_view_t* view)
+{
+    const protocol_frame_t* frame = &receiver->parser.frame;
+    view->type = frame->type & ~PROTOCOL_TYPE_FLAG_CRC32C;
+    view->len = frame->len;
+    view->data = receiver->buffer + frame_start + PROTOCOL_HEADER_SIZE;
+    if ((frame->type & PROTOCOL_TYPE_FLAG_COMPRESSED) && receiver->compressor)
+    {
+        if (!receiver->pull_scratch)
+        {
+            receiver->pull_scratch = protocol_malloc(PROTOCOL_MAX_UNCOMPRESSED_LEN);
+            if (!receiver->pull_scratch)
+            {
+                return false;
+            }
+        }
+        const int raw_len = protocol_decompress_payload(receiver->compressor, view->data, frame->len,
+                                                        receiver->pull_scratch, PROTOCOL_MAX_UNCOMPRESSED_LEN);
+        if (raw_len < 0)
+        {
+            return false;
+        }
+        view->type = PROTOCOL_TYPE_ID(frame->type);
+        view->len = (uint16_t)raw_len;
+        view->data = receiver->pull_scratch;
+    }
+    const protocol_frame_times_t* times = stamp_dispatch(receiver);
+    if (times)
+    {
+        view->times = *times;
+    }
+    else
+    {
+        memset(&view->times, 0, sizeof(view->times));
     }
+    return true;
+}
+
+
+/**
+ * 移动未处理数据到缓冲区头部
+ * @param receiver   协议接收器结构体指针
+ */
+static void compact_processed(protocol_receiver* receiver)
+{
+    // 计算已处理数据长度（解析器正在处理的半帧需要保留，保证帧边界仍在缓冲区内）
+    const size_t processed_len = receiver->processed_pos - protocol_parser_pending(&receiver->parser);
+    if (processed_len > 0)
+    {
+        size_t remaining = receiver->write_pos - processed_len;
+        memmove(receiver->buffer, receiver->buffer + processed_len, remaining);
+        receiver->write_pos = remaining;
+        receiver->processed_pos -= processed_len;
+    }
+}
+
+
+/**
+ * 把缓冲区调整为 new_size
+ * @return 是否成功
+ */
+static bool resize_buffer(protocol_receiver* receiver, const size_t new_size)
+{
+    uint8_t* new_buf = protocol_realloc(receiver->buffer, new_size);
+    if (!new_buf)
+    {
+        return false;
+    }
+    receiver->buffer = new_buf;
+    receiver->buffer_size = new_size;
+    return true;
+}
+
+
+/**
+ * 确保写入位置之后至少有 len 字节空间（先移动数据，再按 2 倍扩容，不超过上限）
+ * @return 实际可用空间（可能小于 len）
+ */
+static size_t ensure_space(protocol_receiver* receiver, const size_t len)
+{
+    if (receiver->buffer_size - receiver->write_pos < len)
+    {
+        compact_processed(receiver);
+    }
+    if (receiver->buffer_size - receiver->write_pos < len && receiver->buffer_size < receiver->max_size)
+    {
+        size_t new_size = receiver->buffer_size ? receiver->buffer_size : PROTOCOL_RECEIVER_MIN_SIZE;
+        while (new_size - receiver->write_pos < len && new_size < receiver->max_size)
+        {
+            new_size *= 2;
+        }
+        if (new_size > receiver->max_size)
+        {
+            new_size = receiver->max_size;
+        }
+        resize_buffer(receiver, new_size);
+    }
+    return receiver->buffer_size - receiver->write_pos;
+}
+
+
+/**
+ * 突发结束后收缩缓冲区（滞回：连续 shrink_after 次占用不超过 1/4 才收缩一半）
+ * @param receiver   协议接收器结构体指针
+ */
+static void maybe_shrink(protocol_receiver* receiver)
+{
+    if (receiver->shrink_after == 0 || receiver->buffer_size <= receiver->initial_size)
+    {
+        return;
+    }
+    // 解析完成后只有解析器中的半帧仍需保留
+    const size_t live = receiver->write_pos - receiver->processed_pos + protocol_parser_pending(&receiver->parser);
+    if (live * 4 > receiver->buffer_size)
+    {
+        receiver->low_usage_count = 0;
+        return;
+    }
+    if (++receiver->low_usage_count < receiver->shrink_after)
+    {
+        return;
+    }
+    receiver->low_usage_count = 0;
+    compact_processed(receiver);
+    size_t new_size = receiver->buffer_size / 2;
+    if (new_size < receiver->initial_size)
+    {
+        new_size = receiver->initial_size;
+    }
+    resize_buffer(receiver, new_size);
 }
 
 
@@ -74,13 +335,142 @@ static void try_parse_frame(protocol_receiver* receiver)
  * @param buf_size   缓冲区大小
  * @param callback   帧回调函数
  */
-void protocol_receiver_init(protocol_receiver* receiver, const uint16_t buf_size, const frame_callback callback)
+void protocol_receiver_init(protocol_receiver* receiver, const size_t buf_size, const frame_callback callback)
 {
-    receiver->buffer = (uint8_t*)malloc(buf_size);
-    receiver->buffer_size = buf_size;
+    receiver->buffer = (uint8_t*)protocol_malloc(buf_size);
+    receiver->buffer_size = receiver->buffer ? buf_size : 0;
     receiver->write_pos = 0;
     receiver->processed_pos = 0;
+    receiver->initial_size = buf_size;
+    receiver->max_size = buf_size > PROTOCOL_RECEIVER_DEFAULT_MAX_SIZE ? buf_size : PROTOCOL_RECEIVER_DEFAULT_MAX_SIZE;
+    receiver->shrink_after = 0;
+    receiver->low_usage_count = 0;
+    receiver->dropped_bytes = 0;
     receiver->callback = callback;
+    receiver->handler = NULL;
+    receiver->handler_user = NULL;
+    receiver->compressor = NULL;
+    receiver->latency = NULL;
+    receiver->flight = NULL;
+    receiver->pull = false;
+    receiver->pull_scratch = NULL;
+    protocol_parser_init(&receiver->parser);
+}
+
+
+/**
+ * @brief 设置缓冲区大小策略
+ * @param receiver      协议接收器结构体指针
+ * @param max_size      扩容上限
+ * @param shrink_after  收缩前需要连续低占用的追加次数，0 表示不收缩
+ */
+void protocol_receiver_set_limits(protocol_receiver* receiver, const size_t max_size, const uint32_t shrink_after)
+{
+    receiver->max_size = max_size < PROTOCOL_RECEIVER_MIN_SIZE ? PROTOCOL_RECEIVER_MIN_SIZE : max_size;
+    receiver->shrink_after = shrink_after;
+    receiver->low_usage_count = 0;
+}
+
+
+/**
+ * @brief 设置带用户上下文的帧处理函数
+ * @param receiver   协议接收器结构体指针
+ * @param handler    处理函数
+ * @param user       用户上下文
+ */
+void protocol_receiver_set_handler(protocol_receiver* receiver, const frame_handler handler, void* user)
+{
+    receiver->handler = handler;
+    receiver->handler_user = user;
+}
+
+
+/**
+ * @brief 切换拉取模式
+ * @param receiver   协议接收器结构体指针
+ * @param enable     是否开启
+ */
+void protocol_receiver_set_pull(protocol_receiver* receiver, const bool enable)
+{
+    receiver->pull = enable;
+}
+
+
+/**
+ * @brief 拉取下一帧
+ * @param receiver   协议接收器结构体指针
+ * @param view       输出帧
+ * @return 是否取到帧
+ */
+bool protocol_receiver_next_frame(protocol_receiver* receiver, protocol_frame_view_t* view)
+{
+    return protocol_receiver_next_frames(receiver, view, 1) == 1;
+}
+
+
+/**
+ * @brief 成批拉取帧
+ * @param receiver   协议接收器结构体指针
+ * @param views      输出帧数组
+ * @param max        最多取出的帧数
+ * @return 取出的帧数
+ */
+size_t protocol_receiver_next_frames(protocol_receiver* receiver, protocol_frame_view_t* views, const size_t max)
+{
+    // 取帧时不移动缓冲区，本批次的帧都保持有效；已取出的帧在下次追加需要空间时才被移走
+    size_t count = 0;
+    size_t frame_start;
+    while (count < max && parse_next_frame(receiver, &frame_start))
+    {
+        const bool ok = fill_view(receiver, frame_start, &views[count]);
+        protocol_parser_reset(&receiver->parser);
+        if (!ok)
+        {
+            continue;
+        }
+        // 解压缓冲区只有一个，解压后的帧结束本批次
+        if (views[count++].data == receiver->pull_scratch)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+
+/**
+ * @brief 开启或关闭帧时间戳
+ * @param receiver   协议接收器结构体指针
+ * @param enable     是否开启
+ * @param latency    延迟直方图，NULL 表示不统计
+ */
+void protocol_receiver_enable_timestamps(protocol_receiver* receiver, const bool enable,
+                                         protocol_latency_hist_t* latency)
+{
+    protocol_parser_enable_timestamps(&receiver->parser, enable);
+    receiver->latency = enable ? latency : NULL;
+}
+
+
+/**
+ * @brief 设置飞行记录器
+ * @param receiver   协议接收器结构体指针
+ * @param flight     飞行记录器，NULL 表示关闭
+ */
+void protocol_receiver_set_flight(protocol_receiver* receiver, protocol_flight_t* flight)
+{
+    receiver->flight = flight;
+}
+
+
+/**
+ * @brief 设置解压上下文
+ * @param receiver    协议接收器结构体指针
+ * @param compressor  解压上下文
+ */
+void protocol_receiver_set_compressor(protocol_receiver* receiver, protocol_compressor_t* compressor)
+{
+    receiver->compressor = compressor;
 }
 
 
@@ -90,70 +480,72 @@ void protocol_receiver_init(protocol_receiver* receiver, const uint16_t buf_size
  * @param data       新数据指针
  * @param len        新数据长度
  */
-void protocol_receiver_append(protocol_receiver* receiver, const uint8_t* data, uint16_t len)
+void protocol_receiver_append(protocol_receiver* receiver, const uint8_t* data, size_t len)
 {
-    // ------------------ 缓冲区溢出情况处理 ---------------------
-    // 情况1：缓冲区剩余空间不足，但可以通过移动未处理数据腾出空间
-    if (receiver->write_pos + len > receiver->buffer_size)
+    while (len > 0)
     {
-        // 计算已处理数据长度
-        const size_t processed_len = receiver->processed_pos;
-        if (processed_len > 0)
-        {
-            // 移动未处理数据到缓冲区头部
-            size_t remaining = receiver->write_pos - processed_len;
-            memmove(receiver->buffer, receiver->buffer + processed_len, remaining);
-            receiver->write_pos = remaining;
-            receiver->processed_pos = 0;
-        }
-        // 情况2：移动后剩余空间仍不足，需动态扩容或丢弃数据
-        if (receiver->write_pos + len > receiver->buffer_size)
+        // 空间不足时先移动、再扩容；到达上限后分块写入，每块解析完再写下一块
+        size_t chunk = ensure_space(receiver, len);
+        if (chunk == 0)
         {
-            // 动态扩容策略（扩容为原大小的2倍）
-            const uint16_t new_size = receiver->buffer_size * 2;
-            const uint8_t* new_buf = realloc(receiver->buffer, new_size);
-            if (!new_buf)
+            // 扩容失败且没有可用空间：丢弃剩余数据
+            receiver->dropped_bytes += len;
+            if (receiver->flight)
             {
-                // 动态扩容失败：尝试部分写入
-                const uint16_t available_space = receiver->buffer_size - receiver->write_pos;
-                if (available_space > 0)
-                {
-                    // 部分写入：将新数据追加到缓冲区末尾
-                    memcpy(receiver->buffer + receiver->write_pos, data, available_space);
-                    receiver->write_pos += available_space;
-                    printf("Error: Partial data written (%d bytes), discarded %d bytes\n",
-                           available_space, len - available_space);
-                }
-                else
-                {
-                    printf("Error: All new data discarded: %d bytes\n", len);
-                }
-                try_parse_frame(receiver);
-                return;
+                protocol_flight_record(receiver->flight, PROTOCOL_FLIGHT_DROP, 0, data,
+                                       len < UINT16_MAX ? (uint16_t)len : UINT16_MAX);
             }
-            receiver->buffer = (uint8_t*)new_buf;
-            receiver->buffer_size = new_size;
+            protocol_diag_report(PROTOCOL_DIAG_RX_DISCARDED, len);
+            break;
         }
-    }
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        memcpy(receiver->buffer + receiver->write_pos, data, chunk);
+        receiver->write_pos += chunk;
+        data += chunk;
+        len -= chunk;
 
-    // -------------------------- 二次空间检查（防御性编程）--------------------------
-    const uint16_t available_space = receiver->buffer_size - receiver->write_pos;
-    if (available_space < len)
-    {
-        // 处理空间不一致的极端情况（如并发写入）
-        printf("Error: Buffer space check failed: require=%d, available=%d\n", len, available_space);
-        len = available_space; // 强制裁剪
-        if (len == 0)
+        // 尝试解析完整帧（拉取模式由调用方取帧）
+        if (!receiver->pull)
         {
-            return;
+            try_parse_frame(receiver);
         }
     }
-    // 追加数据到缓冲区
-    memcpy(receiver->buffer + receiver->write_pos, data, len);
-    receiver->write_pos += len;
+    maybe_shrink(receiver);
+}
+
 
-    // 尝试解析完整帧
-    try_parse_frame(receiver);
+/**
+ * @brief 预留可直接写入的缓冲区空间
+ * @param receiver   协议接收器结构体指针
+ * @param len        需要的空间
+ * @return 写入位置，扩容失败返回 NULL
+ */
+uint8_t* protocol_receiver_reserve(protocol_receiver* receiver, const size_t len)
+{
+    if (ensure_space(receiver, len) < len)
+    {
+        return NULL;
+    }
+    return receiver->buffer + receiver->write_pos;
+}
+
+
+/**
+ * @brief 提交已写入预留空间的数据并尝试解析
+ * @param receiver   协议接收器结构体指针
+ * @param len        实际写入长度
+ */
+void protocol_receiver_commit(protocol_receiver* receiver, const size_t len)
+{
+    receiver->write_pos += len;
+    if (!receiver->pull)
+    {
+        try_parse_frame(receiver);
+    }
+    maybe_shrink(receiver);
 }
 
 
@@ -163,8 +555,11 @@ void protocol_receiver_append(protocol_receiver* receiver, const uint8_t* data,
  */
 void protocol_receiver_destroy(protocol_receiver* receiver)
 {
-    free(receiver->buffer);
+    protocol_parser_reset(&receiver->parser);
+    protocol_free(receiver->buffer);
     receiver->buffer = NULL;
+    protocol_free(receiver->pull_scratch);
+    receiver->pull_scratch = NULL;
     receiver->buffer_size = 0;
     receiver->processed_pos = 0;
     receiver->write_pos = 0;
@@ -0,0 +1,215 @@
+#include "pkt_reliable.h"
+#include "pkt_protocol.h"
+#include "pkt_endian.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// 16 位序号回绕比较
+#define SEQ_DIFF(a, b) ((int16_t)((uint16_t)(a) - (uint16_t)(b)))
+
+void protocol_reliable_init(protocol_reliable_t* ep, uint16_t window, const uint32_t rto_ms,
+                            const reliable_send send, const reliable_deliver deliver, void* user)
+{
+    memset(ep, 0, sizeof(*ep));
+    if (window == 0)
+    {
+        window = 1;
+    }
+    if (window > PROTOCOL_RELIABLE_MAX_WINDOW)
+    {
+        window = PROTOCOL_RELIABLE_MAX_WINDOW;
+    }
+    ep->window = window;
+    ep->rto_ms = rto_ms;
+    ep->send = send;
+    ep->deliver = deliver;
+    ep->user = user;
+}
+
+static void transmit(protocol_reliable_t* ep, protocol_reliable_tx_slot_t* slot, const uint32_t now_ms)
+{
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    pkt_store_le16(payload, slot->seq);
+    pkt_store_u8(payload + 2, slot->type);
+    memcpy(payload + PROTOCOL_RELIABLE_HEADER_LEN, slot->data, slot->len);
+    const uint16_t frame_len = protocol_pack_frame_into(PROTOCOL_TYPE_RELIABLE, payload,
+                                                        PROTOCOL_RELIABLE_HEADER_LEN + slot->len, frame,
+                                                        sizeof(frame));
+    slot->sent_ms = now_ms;
+    ep->send(ep->user, frame, frame_len);
+}
+
+static void send_ack(protocol_reliable_t* ep)
+{
+    uint32_t sack = 0;
+    for (uint16_t i = 0; i + 1 < ep->window; i++)
+    {
+        const uint16_t seq = ep->rcv_nxt + 1 + i;
+        if (ep->rx[seq % PROTOCOL_RELIABLE_MAX_WINDOW].valid)
+        {
+            sack |= 1u << i;
+        }
+    }
+    uint8_t payload[PROTOCOL_ACK_LEN];
+    pkt_store_le16(payload, ep->rcv_nxt);
+    pkt_store_le32(payload + 2, sack);
+    uint8_t frame[PROTOCOL_HEADER_SIZE + PROTOCOL_ACK_LEN + PROTOCOL_TRAILER_SIZE];
+    const uint16_t frame_len = protocol_pack_frame_into(PROTOCOL_TYPE_ACK, payload, sizeof(payload), frame,
+                                                        sizeof(frame));
+    ep->send(ep->user, frame, frame_len);
+    ep->stats.acks_sent++;
+}
+
+bool protocol_reliable_can_send(const protocol_reliable_t* ep)
+{
+    return (uint16_t)(ep->snd_nxt - ep->snd_una) < ep->window;
+}
+
+int protocol_reliable_send(protocol_reliable_t* ep, const protocol_type_t type, const uint8_t* data,
+                           const uint16_t len, const uint32_t now_ms)
+{
+    if (type >= PROTOCOL_TYPE_MAX || len > PROTOCOL_RELIABLE_DATA_LEN)
+    {
+        return -2;
+    }
+    if (!protocol_reliable_can_send(ep))
+    {
+        return -1;
+    }
+    protocol_reliable_tx_slot_t* slot = &ep->tx[ep->snd_nxt % PROTOCOL_RELIABLE_MAX_WINDOW];
+    slot->in_use = 1;
+    slot->sacked = 0;
+    slot->fast_retx = 0;
+    slot->type = (uint8_t)type;
+    slot->seq = ep->snd_nxt;
+    slot->len = len;
+    memcpy(slot->data, data, len);
+    ep->snd_nxt++;
+    ep->stats.sent++;
+    transmit(ep, slot, now_ms);
+    return 0;
+}
+
+static void on_ack(protocol_reliable_t* ep, const uint8_t* data, const uint16_t len, const uint32_t now_ms)
+{
+    if (len < PROTOCOL_ACK_LEN)
+    {
+        return;
+    }
+    ep->stats.acks_received++;
+    const uint16_t cum = pkt_load_le16(data);
+    const uint32_t sack = pkt_load_le32(data + 2);
+
+    // 累计确认：释放 [snd_una, cum) 之间的槽位
+    if (SEQ_DIFF(cum, ep->snd_una) > 0 && SEQ_DIFF(ep->snd_nxt, cum) >= 0)
+    {
+        while (ep->snd_una != cum)
+        {
+            ep->tx[ep->snd_una % PROTOCOL_RELIABLE_MAX_WINDOW].in_use = 0;
+            ep->snd_una++;
+        }
+    }
+    if (sack == 0)
+    {
+        return;
+    }
+
+    // 选择确认：标记已收到的帧，并对最高确认序号之前的空洞各快速重传一次
+    uint16_t highest = cum;
+    for (uint16_t i = 0; i < 32; i++)
+    {
+        const uint16_t seq = cum + 1 + i;
+        if ((sack & (1u << i)) && SEQ_DIFF(seq, ep->snd_una) >= 0 && SEQ_DIFF(ep->snd_nxt, seq) > 0)
+        {
+            ep->tx[seq % PROTOCOL_RELIABLE_MAX_WINDOW].sacked = 1;
+            highest = seq;
+        }
+    }
+    for (uint16_t seq = ep->snd_una; SEQ_DIFF(highest, seq) > 0; seq++)
+    {
+        protocol_reliable_tx_slot_t* slot = &ep->tx[seq % PROTOCOL_RELIABLE_MAX_WINDOW];
+        if (slot->in_use && !slot->sacked && !slot->fast_retx)
+        {
+            slot->fast_retx = 1;
+            ep->stats.retransmits++;
+            transmit(ep, slot, now_ms);
+        }
+    }
+}
+
+static void on_data(protocol_reliable_t* ep, const uint8_t* data, const uint16_t len)
+{
+    // 解压后的 RELIABLE 帧可能超过槽位大小，必须在复制前拒绝
+    if (len < PROTOCOL_RELIABLE_HEADER_LEN || len - PROTOCOL_RELIABLE_HEADER_LEN > PROTOCOL_RELIABLE_DATA_LEN)
+    {
+        ep->stats.malformed++;
+        return;
+    }
+    const uint16_t seq = pkt_load_le16(data);
+    const int16_t offset = SEQ_DIFF(seq, ep->rcv_nxt);
+    if (offset < 0)
+    {
+        // 已交付过（确认帧丢失导致的重传），重新确认即可
+        ep->stats.duplicates++;
+    }
+    else if (offset >= ep->window)
+    {
+        ep->stats.out_of_window++;
+    }
+    else
+    {
+        protocol_reliable_rx_slot_t* slot = &ep->rx[seq % PROTOCOL_RELIABLE_MAX_WINDOW];
+        if (slot->valid)
+        {
+            ep->stats.duplicates++;
+        }
+        else
+        {
+            slot->valid = 1;
+            slot->type = data[2];
+            slot->len = len - PROTOCOL_RELIABLE_HEADER_LEN;
+            memcpy(slot->data, data + PROTOCOL_RELIABLE_HEADER_LEN, slot->len);
+        }
+        // 按序交付连续的帧
+        while ((slot = &ep->rx[ep->rcv_nxt % PROTOCOL_RELIABLE_MAX_WINDOW])->valid)
+        {
+            slot->valid = 0;
+            ep->rcv_nxt++;
+            ep->stats.delivered++;
+            if (ep->deliver)
+            {
+                ep->deliver(ep->user, slot->type, slot->data, slot->len);
+            }
+        }
+    }
+    send_ack(ep);
+}
+
+void protocol_reliable_on_frame(protocol_reliable_t* ep, const uint8_t type, const uint8_t* data,
+                                const uint16_t len, const uint32_t now_ms)
+{
+    if (type == PROTOCOL_TYPE_RELIABLE)
+    {
+        on_data(ep, data, len);
+    }
+    else if (type == PROTOCOL_TYPE_ACK)
+    {
+        on_ack(ep, data, len, now_ms);
+    }
+}
+
+void protocol_reliable_poll(protocol_reliable_t* ep, const uint32_t now_ms)
+{
+    for (uint16_t seq = ep->snd_una; seq != ep->snd_nxt; seq++)
+    {
+        protocol_reliable_tx_slot_t* slot = &ep->tx[seq % PROTOCOL_RELIABLE_MAX_WINDOW];
+        if (slot->in_use && !slot->sacked && now_ms - slot->sent_ms >= ep->rto_ms)
+        {
+            ep->stats.retransmits++;
+            transmit(ep, slot, now_ms);
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#include "pkt_scan.h"
+#include "pkt_protocol.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+#define HEADER_FIRST (FRAME_HEADER & 0xFF)
+#define HEADER_SECOND (FRAME_HEADER >> 8)
+
+size_t protocol_scan_header_scalar(const uint8_t* data, const size_t len)
+{
+    size_t pos = 0;
+    while (pos < len)
+    {
+        // memchr 由 libc 实现，通常本身已向量化
+        const uint8_t* hit = memchr(data + pos, HEADER_FIRST, len - pos);
+        if (!hit)
+        {
+            return len;
+        }
+        pos = (size_t)(hit - data);
+        if (pos + 1 == len || data[pos + 1] == HEADER_SECOND)
+        {
+            return pos;
+        }
+        pos++;
+    }
+    return len;
+}
+
+#ifdef SCAN_X86
+
+static size_t scan_sse2(const uint8_t* data, const size_t len)
+{
+    const __m128i first = _mm_set1_epi8((char)HEADER_FIRST);
+    const __m128i second = _mm_set1_epi8((char)HEADER_SECOND);
+    size_t pos = 0;
+    // 每次比较 data[pos..pos+15] 与 data[pos+1..pos+16]，需要多读 1 字节
+    for (; pos + 17 <= len; pos += 16)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(data + pos));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(data + pos + 1));
+        const unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, second)));
+        if (mask)
+        {
+            return pos + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return pos + protocol_scan_header_scalar(data + pos, len - pos);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const uint8_t* data, const size_t len)
+{
+    const __m256i first = _mm256_set1_epi8((char)HEADER_FIRST);
+    const __m256i second = _mm256_set1_epi8((char)HEADER_SECOND);
+    size_t pos = 0;
+    for (; pos + 33 <= len; pos += 32)
+    {
+        const __m256i a = _mm256_loadu_si256((const __m256i*)(data + pos));
+        const __m256i b = _mm256_loadu_si256((const __m256i*)(data + pos + 1));
+        const unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, second)));
+        if (mask)
+        {
+            return pos + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return pos + scan_sse2(data + pos, len - pos);
+}
+
+size_t protocol_scan_header(const uint8_t* data, const size_t len)
+{
+    // 解码线程可能同时首次调用：检测结果相同，用原子变量避免数据竞争，之后每次只是一次普通读取
+    static atomic_int has_avx2 = -1;
+    int avx2 = atomic_load_explicit(&has_avx2, memory_order_relaxed);
+    if (avx2 < 0)
+    {
+        avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+        atomic_store_explicit(&has_avx2, avx2, memory_order_relaxed);
+    }
+    return avx2 ? scan_avx2(data, len) : scan_sse2(data, len);
+}
+
+#else
+
+size_t protocol_scan_header(const uint8_t* data, const size_t len)
+{
+    return protocol_scan_header_scalar(data, len);
+}
+
+#endif
@@ -0,0 +1,519 @@
+#define _GNU_SOURCE
+
+#include "pkt_serial_io.h"
+#include "pkt_pool.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef PKT_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#define OP_READ 0
+#define OP_WRITE 1
+#define USER_DATA(port, op) (((uint64_t)(port) << 1) | (op))
+#define USER_DATA_TIMEOUT UINT64_MAX
+
+/*
+ * 预留一次读取的接收空间：优先 SERIAL_IO_READ_CHUNK，扩容上限更小时退而使用剩余空间
+ * （protocol_receiver_set_limits 允许上限低于读取块大小）
+ */
+static uint8_t* reserve_read(protocol_receiver* receiver, size_t* len)
+{
+    uint8_t* dst = protocol_receiver_reserve(receiver, SERIAL_IO_READ_CHUNK);
+    *len = SERIAL_IO_READ_CHUNK;
+    if (!dst)
+    {
+        // 失败的预留已经移动过数据并扩容到上限，剩余空间即本次最多可读的长度
+        *len = receiver->buffer_size - receiver->write_pos;
+        dst = *len > 0 ? protocol_receiver_reserve(receiver, *len) : NULL;
+    }
+    return dst;
+}
+
+#ifdef PKT_HAVE_IO_URING
+
+/*
+ * 直接使用系统调用访问 io_uring，避免依赖 liburing
+ */
+struct serial_uring
+{
+    int fd;
+    void* sq_map;
+    size_t sq_map_len;
+    void* cq_map;
+    size_t cq_map_len;
+    struct io_uring_sqe* sqes;
+    size_t sqes_len;
+    uint32_t* sq_head;
+    uint32_t* sq_tail;
+    uint32_t* sq_mask;
+    uint32_t* sq_array;
+    uint32_t* cq_head;
+    uint32_t* cq_tail;
+    uint32_t* cq_mask;
+    struct io_uring_cqe* cqes;
+    uint32_t pending; // 已填写尚未提交的 SQE 数
+    bool timeout_armed; // 是否有超时请求在途
+    struct __kernel_timespec timeout; // 超时请求引用的时间（需在请求完成前保持有效）
+};
+
+static int uring_setup(const unsigned entries, struct io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(const int fd, const unsigned to_submit, const unsigned min_complete, const unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_register(const int fd, const unsigned opcode, const void* arg, const unsigned nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void uring_close(serial_uring_t* ring)
+{
+    if (ring->sqes && ring->sqes != MAP_FAILED)
+    {
+        munmap(ring->sqes, ring->sqes_len);
+    }
+    if (ring->cq_map && ring->cq_map != MAP_FAILED && ring->cq_map != ring->sq_map)
+    {
+        munmap(ring->cq_map, ring->cq_map_len);
+    }
+    if (ring->sq_map && ring->sq_map != MAP_FAILED)
+    {
+        munmap(ring->sq_map, ring->sq_map_len);
+    }
+    if (ring->fd >= 0)
+    {
+        close(ring->fd);
+    }
+    protocol_free(ring);
+}
+
+static serial_uring_t* uring_open(const unsigned entries)
+{
+    serial_uring_t* ring = protocol_malloc(sizeof(*ring));
+    if (!ring)
+    {
+        return NULL;
+    }
+    memset(ring, 0, sizeof(*ring));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = uring_setup(entries, &params);
+    if (ring->fd < 0)
+    {
+        uring_close(ring);
+        return NULL;
+    }
+
+    ring->sq_map_len = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cq_map_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cq_map_len > ring->sq_map_len)
+        {
+            ring->sq_map_len = ring->cq_map_len;
+        }
+        ring->cq_map_len = ring->sq_map_len;
+    }
+    ring->sq_map = mmap(NULL, ring->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                        IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED)
+    {
+        uring_close(ring);
+        return NULL;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        ring->cq_map = ring->sq_map;
+    }
+    else
+    {
+        ring->cq_map = mmap(NULL, ring->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                            IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED)
+        {
+            uring_close(ring);
+            return NULL;
+        }
+    }
+    ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                      IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+    {
+        uring_close(ring);
+        return NULL;
+    }
+
+    uint8_t* sq = ring->sq_map;
+    uint8_t* cq = ring->cq_map;
+    ring->sq_head = (uint32_t*)(sq + params.sq_off.head);
+    ring->sq_tail = (uint32_t*)(sq + params.sq_off.tail);
+    ring->sq_mask = (uint32_t*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (uint32_t*)(sq + params.sq_off.array);
+    ring->cq_head = (uint32_t*)(cq + params.cq_off.head);
+    ring->cq_tail = (uint32_t*)(cq + params.cq_off.tail);
+    ring->cq_mask = (uint32_t*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return ring;
+}
+
+// 取一个空闲 SQE，调用者填写后计入 pending
+static struct io_uring_sqe* uring_get_sqe(serial_uring_t* ring)
+{
+    const uint32_t head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    const uint32_t tail = *ring->sq_tail;
+    if (tail - head > *ring->sq_mask)
+    {
+        return NULL;
+    }
+    const uint32_t index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->pending++;
+    return sqe;
+}
+
+static void arm_read(serial_io_t* io, const uint16_t port_index)
+{
+    serial_io_port_t* port = &io->ports[port_index];
+    size_t len;
+    uint8_t* dst = reserve_read(port->receiver, &len);
+    if (!dst)
+    {
+        port->rx_stalls++;
+        return;
+    }
+    struct io_uring_sqe* sqe = uring_get_sqe(io->uring);
+    if (!sqe)
+    {
+        return;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = port->fd;
+    sqe->addr = (uint64_t)(uintptr_t)dst;
+    sqe->len = (uint32_t)len;
+    sqe->off = (uint64_t)-1; // 不可定位设备，使用当前文件位置
+    sqe->user_data = USER_DATA(port_index, OP_READ);
+    port->read_armed = true;
+}
+
+static void arm_write(serial_io_t* io, const uint16_t port_index)
+{
+    serial_io_port_t* port = &io->ports[port_index];
+    struct io_uring_sqe* sqe = uring_get_sqe(io->uring);
+    if (!sqe)
+    {
+        return;
+    }
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = port->fd;
+    sqe->addr = (uint64_t)(uintptr_t)port->tx_buf;
+    sqe->len = (uint32_t)port->tx_len;
+    sqe->off = (uint64_t)-1;
+    sqe->buf_index = 0; // 整个发送池注册为一个固定缓冲区
+    sqe->user_data = USER_DATA(port_index, OP_WRITE);
+    port->tx_inflight = port->tx_len;
+}
+
+static void complete(serial_io_t* io, const uint64_t user_data, const int32_t res)
+{
+    const uint16_t port_index = (uint16_t)(user_data >> 1);
+    serial_io_port_t* port = &io->ports[port_index];
+    if ((user_data & 1) == OP_READ)
+    {
+        port->read_armed = false;
+        if (res > 0)
+        {
+            port->rx_bytes += (uint64_t)res;
+            protocol_receiver_commit(port->receiver, (size_t)res);
+        }
+        else if (res != -EAGAIN && res != -EINTR)
+        {
+            port->closed = true;
+        }
+        return;
+    }
+
+    const size_t written = res > 0 ? (size_t)res : 0;
+    if (res < 0 && res != -EAGAIN && res != -EINTR)
+    {
+        port->closed = true;
+    }
+    // 部分写入时剩余数据（含在途期间新暂存的）前移，下一轮继续提交
+    memmove(port->tx_buf, port->tx_buf + written, port->tx_len - written);
+    port->tx_len -= written;
+    port->tx_bytes += written;
+    port->tx_inflight = 0;
+}
+
+static int uring_poll(serial_io_t* io, const int timeout_ms)
+{
+    serial_uring_t* ring = io->uring;
+    bool inflight = false;
+    for (uint16_t i = 0; i < io->port_count; i++)
+    {
+        serial_io_port_t* port = &io->ports[i];
+        if (port->closed)
+        {
+            continue;
+        }
+        if (!port->read_armed)
+        {
+            arm_read(io, i);
+        }
+        if (port->tx_len > 0 && port->tx_inflight == 0)
+        {
+            arm_write(io, i);
+        }
+        inflight = inflight || port->read_armed || port->tx_inflight > 0;
+    }
+
+    // 没有任何读写在途（例如接收缓冲区已满）时不能无限等待，只允许由超时请求结束等待
+    unsigned min_complete = 0;
+    if (timeout_ms != 0 && (inflight || timeout_ms > 0) && __atomic_load_n(ring->cq_head, __ATOMIC_RELAXED) ==
+        __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        min_complete = 1;
+        // 超时请求在第一个其他完成事件到达时也会结束，因此同一时刻最多一个在途
+        if (timeout_ms > 0 && !ring->timeout_armed)
+        {
+            struct io_uring_sqe* sqe = uring_get_sqe(ring);
+            if (sqe)
+            {
+                ring->timeout.tv_sec = timeout_ms / 1000;
+                ring->timeout.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+                sqe->opcode = IORING_OP_TIMEOUT;
+                sqe->addr = (uint64_t)(uintptr_t)&ring->timeout;
+                sqe->len = 1;
+                sqe->off = 1;
+                sqe->user_data = USER_DATA_TIMEOUT;
+                ring->timeout_armed = true;
+            }
+        }
+    }
+
+    if (ring->pending > 0 || min_complete > 0)
+    {
+        const int ret = uring_enter(ring->fd, ring->pending, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0);
+        io->syscalls++;
+        if (ret < 0 && errno != EINTR && errno != EBUSY && errno != ETIME)
+        {
+            return -1;
+        }
+        if (ret > 0)
+        {
+            ring->pending -= (uint32_t)ret;
+        }
+    }
+
+    int events = 0;
+    uint32_t head = *ring->cq_head;
+    const uint32_t tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail)
+    {
+        const struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        if (cqe->user_data == USER_DATA_TIMEOUT)
+        {
+            ring->timeout_armed = false;
+        }
+        else
+        {
+            complete(io, cqe->user_data, cqe->res);
+            events++;
+        }
+        head++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return events;
+}
+
+#endif
+
+static int fallback_poll(serial_io_t* io, const int timeout_ms)
+{
+    struct pollfd pfds[io->port_count ? io->port_count : 1];
+    for (uint16_t i = 0; i < io->port_count; i++)
+    {
+        const serial_io_port_t* port = &io->ports[i];
+        pfds[i].fd = port->closed ? -1 : port->fd;
+        pfds[i].events = (short)(POLLIN | (port->tx_len > 0 ? POLLOUT : 0));
+        pfds[i].revents = 0;
+    }
+    const int ready = poll(pfds, io->port_count, timeout_ms);
+    io->syscalls++;
+    if (ready < 0)
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    int events = 0;
+    for (uint16_t i = 0; i < io->port_count && ready > 0; i++)
+    {
+        serial_io_port_t* port = &io->ports[i];
+        if (pfds[i].revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            size_t len;
+            uint8_t* dst = reserve_read(port->receiver, &len);
+            if (!dst)
+            {
+                port->rx_stalls++;
+            }
+            else
+            {
+                const ssize_t n = read(port->fd, dst, len);
+                io->syscalls++;
+                if (n > 0)
+                {
+                    port->rx_bytes += (uint64_t)n;
+                    protocol_receiver_commit(port->receiver, (size_t)n);
+                    events++;
+                }
+                else if (n == 0 || (errno != EAGAIN && errno != EINTR))
+                {
+                    port->closed = true;
+                }
+            }
+        }
+        if ((pfds[i].revents & POLLOUT) && port->tx_len > 0)
+        {
+            const ssize_t n = write(port->fd, port->tx_buf, port->tx_len);
+            io->syscalls++;
+            if (n > 0)
+            {
+                memmove(port->tx_buf, port->tx_buf + n, port->tx_len - (size_t)n);
+                port->tx_len -= (size_t)n;
+                port->tx_bytes += (uint64_t)n;
+                events++;
+            }
+            else if (n < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                port->closed = true;
+            }
+        }
+    }
+    return events;
+}
+
+bool serial_io_init(serial_io_t* io, const uint16_t max_ports, const bool prefer_uring)
+{
+    memset(io, 0, sizeof(*io));
+    if (max_ports == 0)
+    {
+        return false;
+    }
+    io->ports = protocol_malloc(max_ports * sizeof(serial_io_port_t));
+    io->tx_pool = protocol_malloc((size_t)max_ports * SERIAL_IO_TX_BUFFER);
+    if (!io->ports || !io->tx_pool)
+    {
+        serial_io_destroy(io);
+        return false;
+    }
+    memset(io->ports, 0, max_ports * sizeof(serial_io_port_t));
+    io->max_ports = max_ports;
+    io->backend = SERIAL_IO_BACKEND_POLL;
+
+#ifdef PKT_HAVE_IO_URING
+    if (prefer_uring)
+    {
+        // 每个端口最多一个读、一个写在途，另加一个超时请求
+        io->uring = uring_open(2u * max_ports + 1);
+        if (io->uring)
+        {
+            const struct iovec iov = {io->tx_pool, (size_t)max_ports * SERIAL_IO_TX_BUFFER};
+            if (uring_register(io->uring->fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0)
+            {
+                io->backend = SERIAL_IO_BACKEND_URING;
+            }
+            else
+            {
+                uring_close(io->uring);
+                io->uring = NULL;
+            }
+        }
+    }
+#else
+    (void)prefer_uring;
+#endif
+    return true;
+}
+
+int serial_io_add_port(serial_io_t* io, const int fd, protocol_receiver* receiver)
+{
+    if (io->port_count >= io->max_ports || fd < 0 || !receiver)
+    {
+        return -1;
+    }
+    if (io->backend == SERIAL_IO_BACKEND_POLL)
+    {
+        const int flags = fcntl(fd, F_GETFL);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        {
+            return -1;
+        }
+    }
+    serial_io_port_t* port = &io->ports[io->port_count];
+    memset(port, 0, sizeof(*port));
+    port->fd = fd;
+    port->receiver = receiver;
+    port->tx_buf = io->tx_pool + (size_t)io->port_count * SERIAL_IO_TX_BUFFER;
+    return io->port_count++;
+}
+
+int serial_io_send(serial_io_t* io, const int port, const uint8_t* data, const size_t len)
+{
+    if (port < 0 || port >= io->port_count)
+    {
+        return -1;
+    }
+    serial_io_port_t* p = &io->ports[port];
+    if (p->closed || len > SERIAL_IO_TX_BUFFER - p->tx_len)
+    {
+        return -1;
+    }
+    memcpy(p->tx_buf + p->tx_len, data, len);
+    p->tx_len += len;
+    return 0;
+}
+
+int serial_io_poll(serial_io_t* io, const int timeout_ms)
+{
+#ifdef PKT_HAVE_IO_URING
+    if (io->backend == SERIAL_IO_BACKEND_URING)
+    {
+        return uring_poll(io, timeout_ms);
+    }
+#endif
+    return fallback_poll(io, timeout_ms);
+}
+
+void serial_io_destroy(serial_io_t* io)
+{
+#ifdef PKT_HAVE_IO_URING
+    if (io->uring)
+    {
+        // 关闭 ring 会取消在途请求，之后才能释放它们引用的缓冲区
+        uring_close(io->uring);
+    }
+#endif
+    protocol_free(io->ports);
+    protocol_free(io->tx_pool);
+    memset(io, 0, sizeof(*io));
+}
@@ -0,0 +1,322 @@
+#define _GNU_SOURCE
+
+#include "pkt_shm.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHM_MAGIC "SPKTSHM1"
+#define SHM_VERSION 1
+
+// 原子变量跨进程共享，必须是无锁实现
+_Static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "64 位原子操作必须无锁");
+_Static_assert(sizeof(atomic_uint) == sizeof(uint32_t), "futex 字必须为 32 位");
+
+/**
+ * @brief 共享内存头
+ */
+typedef struct
+{
+    char magic[8]; // SHM_MAGIC
+    uint32_t version; // SHM_VERSION
+    uint32_t slots; // 槽位数（2 的幂）
+    uint32_t slot_size; // 槽位大小（双方结构一致性检查）
+    uint32_t reserved;
+    _Alignas(64) atomic_ullong published; // 已发布的帧数
+    _Alignas(64) atomic_uint futex_word; // 有订阅者睡眠时每次发布加一
+    atomic_uint waiters; // 正在睡眠的订阅者数
+} shm_header_t;
+
+/**
+ * @brief 槽位
+ */
+typedef struct
+{
+    _Alignas(64) atomic_ullong seq; // 帧序号 + 1，0 表示正在写入
+    uint16_t len; // 负载长度
+    uint8_t type; // 协议类型
+    uint8_t data[PROTOCOL_SHM_MAX_PAYLOAD]; // 负载
+} shm_slot_t;
+
+static shm_header_t* shm_header(void* base)
+{
+    return base;
+}
+
+static shm_slot_t* shm_slot(void* base, const uint64_t seq, const uint32_t mask)
+{
+    return (shm_slot_t*)((uint8_t*)base + sizeof(shm_header_t)) + (seq & mask);
+}
+
+static long futex(atomic_uint* word, const int op, const unsigned value, const struct timespec* timeout)
+{
+    // 跨进程使用，不能带 FUTEX_PRIVATE_FLAG
+    return syscall(SYS_futex, (unsigned*)word, op, value, timeout, NULL, 0);
+}
+
+bool protocol_shm_create(protocol_shm_pub_t* pub, const char* name, uint32_t slots)
+{
+    memset(pub, 0, sizeof(*pub));
+    pub->fd = -1;
+    uint32_t rounded = 1;
+    slots = slots ? slots : PROTOCOL_SHM_DEFAULT_SLOTS;
+    while (rounded < slots && rounded < (1u << 24))
+    {
+        rounded <<= 1;
+    }
+    pub->size = sizeof(shm_header_t) + (size_t)rounded * sizeof(shm_slot_t);
+
+    if (name)
+    {
+        if (strlen(name) >= sizeof(pub->name))
+        {
+            return false;
+        }
+        // 不截断旧对象（仍映射着它的订阅者会收到 SIGBUS）：删除名字后重新创建，旧订阅者保留旧映射
+        shm_unlink(name);
+        pub->fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    else
+    {
+        pub->fd = memfd_create("spkt_shm", 0);
+    }
+    if (pub->fd < 0)
+    {
+        return false;
+    }
+    if (ftruncate(pub->fd, (off_t)pub->size) != 0)
+    {
+        goto fail;
+    }
+    pub->base = mmap(NULL, pub->size, PROT_READ | PROT_WRITE, MAP_SHARED, pub->fd, 0);
+    if (pub->base == MAP_FAILED)
+    {
+        pub->base = NULL;
+        goto fail;
+    }
+
+    // ftruncate 后内容全为 0：槽位序号为 0 表示尚未写入；最后写 magic，订阅者看到 magic 时头部已完整
+    shm_header_t* header = shm_header(pub->base);
+    header->version = SHM_VERSION;
+    header->slots = rounded;
+    header->slot_size = sizeof(shm_slot_t);
+    atomic_store(&header->published, 0);
+    atomic_store(&header->futex_word, 0);
+    atomic_store(&header->waiters, 0);
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, SHM_MAGIC, sizeof(header->magic));
+
+    pub->mask = rounded - 1;
+    pub->next = 0;
+    if (name)
+    {
+        strcpy(pub->name, name);
+    }
+    return true;
+
+fail:
+    close(pub->fd);
+    if (name)
+    {
+        shm_unlink(name);
+    }
+    pub->fd = -1;
+    return false;
+}
+
+bool protocol_shm_publish(protocol_shm_pub_t* pub, const uint8_t type, const uint8_t* data, const uint16_t len)
+{
+    if (len > PROTOCOL_SHM_MAX_PAYLOAD)
+    {
+        return false;
+    }
+    shm_header_t* header = shm_header(pub->base);
+    shm_slot_t* slot = shm_slot(pub->base, pub->next, pub->mask);
+    // 先标记为写入中，订阅者看到序号变化就知道这一圈的旧帧已被覆盖
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->type = type;
+    slot->len = len;
+    memcpy(slot->data, data, len);
+    atomic_store_explicit(&slot->seq, pub->next + 1, memory_order_release);
+    pub->next++;
+
+    // 与订阅者登记睡眠之间需要全序：要么这里看到 waiters，要么订阅者看到新的 published
+    atomic_store_explicit(&header->published, pub->next, memory_order_seq_cst);
+    if (atomic_load_explicit(&header->waiters, memory_order_seq_cst) > 0)
+    {
+        atomic_fetch_add_explicit(&header->futex_word, 1, memory_order_seq_cst);
+        futex(&header->futex_word, FUTEX_WAKE, INT_MAX, NULL);
+    }
+    return true;
+}
+
+static void shm_handler(void* user, const uint8_t type, const uint8_t* data, const uint16_t len,
+                        const protocol_frame_times_t* times)
+{
+    (void)times;
+    protocol_shm_publish(user, type, data, len);
+}
+
+void protocol_shm_attach(protocol_shm_pub_t* pub, protocol_receiver* receiver)
+{
+    protocol_receiver_set_handler(receiver, shm_handler, pub);
+}
+
+// 名字是否仍指向本发布方的对象（重启时新发布方可能已用同名重建）
+static bool shm_name_is_ours(const protocol_shm_pub_t* pub)
+{
+    struct stat ours;
+    struct stat named;
+    const int fd = shm_open(pub->name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    const bool same = fstat(pub->fd, &ours) == 0 && fstat(fd, &named) == 0 && ours.st_dev == named.st_dev &&
+        ours.st_ino == named.st_ino;
+    close(fd);
+    return same;
+}
+
+void protocol_shm_destroy(protocol_shm_pub_t* pub)
+{
+    if (pub->base)
+    {
+        munmap(pub->base, pub->size);
+    }
+    if (pub->name[0] && pub->fd >= 0 && shm_name_is_ours(pub))
+    {
+        shm_unlink(pub->name);
+    }
+    if (pub->fd >= 0)
+    {
+        close(pub->fd);
+    }
+    memset(pub, 0, sizeof(*pub));
+    pub->fd = -1;
+}
+
+bool protocol_shm_open_fd(protocol_shm_sub_t* sub, const int fd)
+{
+    memset(sub, 0, sizeof(*sub));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(shm_header_t))
+    {
+        return false;
+    }
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
+    const shm_header_t* header = shm_header(base);
+    const bool valid = memcmp(header->magic, SHM_MAGIC, sizeof(header->magic)) == 0 &&
+        header->version == SHM_VERSION && header->slot_size == sizeof(shm_slot_t) && header->slots > 0 &&
+        (header->slots & (header->slots - 1)) == 0 &&
+        sizeof(shm_header_t) + (size_t)header->slots * sizeof(shm_slot_t) <= (size_t)st.st_size;
+    if (!valid)
+    {
+        munmap(base, (size_t)st.st_size);
+        return false;
+    }
+    sub->base = base;
+    sub->size = (size_t)st.st_size;
+    sub->mask = header->slots - 1;
+    sub->next = atomic_load_explicit(&shm_header(base)->published, memory_order_acquire);
+    return true;
+}
+
+bool protocol_shm_open(protocol_shm_sub_t* sub, const char* name)
+{
+    memset(sub, 0, sizeof(*sub));
+    const int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    const bool ok = protocol_shm_open_fd(sub, fd);
+    close(fd);
+    return ok;
+}
+
+size_t protocol_shm_poll(protocol_shm_sub_t* sub, const frame_callback callback, const size_t max)
+{
+    shm_header_t* header = shm_header(sub->base);
+    const uint64_t published = atomic_load_explicit(&header->published, memory_order_acquire);
+    // 落后超过一圈：跳到仍可能有效的最旧一帧
+    if (published - sub->next > (uint64_t)sub->mask + 1)
+    {
+        const uint64_t oldest = published - sub->mask - 1;
+        sub->lost += oldest - sub->next;
+        sub->next = oldest;
+    }
+    size_t handled = 0;
+    while (sub->next < published && handled < max)
+    {
+        const uint64_t seq = sub->next++;
+        shm_slot_t* slot = shm_slot(sub->base, seq, sub->mask);
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != seq + 1)
+        {
+            // 读取前已被下一圈覆盖
+            sub->lost++;
+            continue;
+        }
+        // 先复制到本地再确认序号未变，回调只会看到完整的帧
+        uint8_t data[PROTOCOL_SHM_MAX_PAYLOAD];
+        const uint8_t type = slot->type;
+        const uint16_t len = slot->len <= PROTOCOL_SHM_MAX_PAYLOAD ? slot->len : PROTOCOL_SHM_MAX_PAYLOAD;
+        memcpy(data, slot->data, len);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq + 1)
+        {
+            sub->torn++;
+            continue;
+        }
+        callback(type, data, len);
+        sub->delivered++;
+        handled++;
+    }
+    return handled;
+}
+
+bool protocol_shm_wait(protocol_shm_sub_t* sub, const int timeout_ms)
+{
+    shm_header_t* header = shm_header(sub->base);
+    if (atomic_load_explicit(&header->published, memory_order_acquire) != sub->next)
+    {
+        return true;
+    }
+    struct timespec timeout;
+    if (timeout_ms >= 0)
+    {
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+    }
+    // 先登记并读取 futex 字，再检查一次是否有新帧，避免错过唤醒
+    atomic_fetch_add_explicit(&header->waiters, 1, memory_order_seq_cst);
+    const unsigned word = atomic_load_explicit(&header->futex_word, memory_order_seq_cst);
+    if (atomic_load_explicit(&header->published, memory_order_seq_cst) == sub->next)
+    {
+        futex(&header->futex_word, FUTEX_WAIT, word, timeout_ms >= 0 ? &timeout : NULL);
+    }
+    atomic_fetch_sub_explicit(&header->waiters, 1, memory_order_seq_cst);
+    return atomic_load_explicit(&header->published, memory_order_acquire) != sub->next;
+}
+
+void protocol_shm_close(protocol_shm_sub_t* sub)
+{
+    if (sub->base)
+    {
+        munmap(sub->base, sub->size);
+    }
+    memset(sub, 0, sizeof(*sub));
+}
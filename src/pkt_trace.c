@@ -0,0 +1,93 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pkt_trace.h"
+
+#include <string.h>
+#include <time.h>
+
+uint64_t protocol_trace_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * 样本所在桶：小于 SUB_BUCKETS 的值各占一桶，其余按最高位所在的 2 的幂区间再细分
+ */
+static uint32_t bucket_index(const uint64_t ns)
+{
+    if (ns < PROTOCOL_LATENCY_SUB_BUCKETS)
+    {
+        return (uint32_t)ns;
+    }
+    const uint32_t msb = 63u - (uint32_t)__builtin_clzll(ns);
+    const uint32_t shift = msb - PROTOCOL_LATENCY_SUB_BITS;
+    const uint32_t sub = (uint32_t)(ns >> shift) & (PROTOCOL_LATENCY_SUB_BUCKETS - 1);
+    return (shift + 1) * PROTOCOL_LATENCY_SUB_BUCKETS + sub;
+}
+
+/**
+ * 桶的下界（bucket_index 的逆运算）
+ */
+static uint64_t bucket_lower(const uint32_t index)
+{
+    if (index < PROTOCOL_LATENCY_SUB_BUCKETS)
+    {
+        return index;
+    }
+    const uint32_t shift = index / PROTOCOL_LATENCY_SUB_BUCKETS - 1;
+    const uint64_t sub = index % PROTOCOL_LATENCY_SUB_BUCKETS;
+    return (PROTOCOL_LATENCY_SUB_BUCKETS + sub) << shift;
+}
+
+void protocol_latency_reset(protocol_latency_hist_t* hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min_ns = UINT64_MAX;
+}
+
+void protocol_latency_record(protocol_latency_hist_t* hist, const uint64_t ns)
+{
+    hist->buckets[bucket_index(ns)]++;
+    hist->count++;
+    hist->sum_ns += ns;
+    if (ns < hist->min_ns)
+    {
+        hist->min_ns = ns;
+    }
+    if (ns > hist->max_ns)
+    {
+        hist->max_ns = ns;
+    }
+}
+
+uint64_t protocol_latency_quantile(const protocol_latency_hist_t* hist, const double quantile)
+{
+    if (hist->count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(quantile * (double)hist->count + 0.5);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < PROTOCOL_LATENCY_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+        if (seen >= rank)
+        {
+            // 桶上界不超过实际最大值
+            const uint64_t upper = i + 1 < PROTOCOL_LATENCY_BUCKETS ? bucket_lower(i + 1) - 1 : UINT64_MAX;
+            return upper < hist->max_ns ? upper : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
+
+uint64_t protocol_latency_mean(const protocol_latency_hist_t* hist)
+{
+    return hist->count ? hist->sum_ns / hist->count : 0;
+}
@@ -0,0 +1,208 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pkt_txq.h"
+#include "pkt_diag.h"
+#include "pkt_pool.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+bool protocol_txq_init(protocol_txq_t* txq, const int fd, const uint16_t capacity, size_t high_watermark,
+                       const size_t low_watermark, const txq_backpressure backpressure, void* user)
+{
+    memset(txq, 0, sizeof(*txq));
+    if (capacity == 0)
+    {
+        return false;
+    }
+    if (high_watermark == 0)
+    {
+        high_watermark = (size_t)capacity * PROTOCOL_MAX_FRAME_LEN * 3 / 4;
+    }
+    if (low_watermark >= high_watermark)
+    {
+        return false;
+    }
+    const int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        return false;
+    }
+    txq->frames = protocol_malloc((size_t)capacity * sizeof(protocol_txq_frame_t));
+    if (!txq->frames)
+    {
+        return false;
+    }
+    pthread_mutex_init(&txq->lock, NULL);
+    txq->fd = fd;
+    txq->capacity = capacity;
+    txq->high_watermark = high_watermark;
+    txq->low_watermark = low_watermark;
+    // 队列按帧数拒绝，帧较小时字节水位可能永远达不到，因此帧数也设高低水位
+    txq->high_frames = capacity * 3 / 4 > 0 ? (uint16_t)(capacity * 3 / 4) : 1;
+    txq->low_frames = (uint16_t)(capacity / 4);
+    txq->backpressure = backpressure;
+    txq->user = user;
+    return true;
+}
+
+// 取队尾空闲槽位，调用者持有锁；队列满返回 NULL
+static protocol_txq_frame_t* tail_slot(protocol_txq_t* txq)
+{
+    if (txq->count == txq->capacity)
+    {
+        txq->stats.rejected++;
+        protocol_diag_report(PROTOCOL_DIAG_TXQ_REJECTED, txq->count);
+        return NULL;
+    }
+    return &txq->frames[(txq->head + txq->count) % txq->capacity];
+}
+
+// 入队完成，调用者持有锁；返回是否刚进入背压状态
+static bool commit_tail(protocol_txq_t* txq, const uint16_t len)
+{
+    txq->frames[(txq->head + txq->count) % txq->capacity].len = len;
+    txq->count++;
+    txq->queued_bytes += len;
+    if (!txq->throttled && (txq->queued_bytes >= txq->high_watermark || txq->count >= txq->high_frames))
+    {
+        txq->throttled = true;
+        return true;
+    }
+    return false;
+}
+
+int protocol_txq_push(protocol_txq_t* txq, const uint8_t* frame, const uint16_t len)
+{
+    if (len == 0 || len > PROTOCOL_MAX_FRAME_LEN)
+    {
+        return -1;
+    }
+    pthread_mutex_lock(&txq->lock);
+    protocol_txq_frame_t* slot = tail_slot(txq);
+    if (!slot)
+    {
+        pthread_mutex_unlock(&txq->lock);
+        return -1;
+    }
+    memcpy(slot->data, frame, len);
+    const bool notify = commit_tail(txq, len);
+    pthread_mutex_unlock(&txq->lock);
+    // 回调在锁外调用，允许回调内再次访问队列
+    if (notify && txq->backpressure)
+    {
+        txq->backpressure(txq->user, true);
+    }
+    return 0;
+}
+
+int protocol_txq_pack(protocol_txq_t* txq, const protocol_type_t type, const uint8_t* data,
+                      const uint16_t data_len)
+{
+    pthread_mutex_lock(&txq->lock);
+    protocol_txq_frame_t* slot = tail_slot(txq);
+    const uint16_t len = slot ? protocol_pack_frame_into(type, data, data_len, slot->data, sizeof(slot->data)) : 0;
+    if (len == 0)
+    {
+        pthread_mutex_unlock(&txq->lock);
+        return -1;
+    }
+    const bool notify = commit_tail(txq, len);
+    pthread_mutex_unlock(&txq->lock);
+    if (notify && txq->backpressure)
+    {
+        txq->backpressure(txq->user, true);
+    }
+    return 0;
+}
+
+long protocol_txq_flush(protocol_txq_t* txq)
+{
+    long total = 0;
+    for (;;)
+    {
+        struct iovec iov[PROTOCOL_TXQ_MAX_IOV];
+        int iov_count = 0;
+
+        // 只有 I/O 线程移动队首，生产者只写队尾之后的槽位，因此快照在锁外仍然有效
+        pthread_mutex_lock(&txq->lock);
+        for (uint16_t i = 0; i < txq->count && iov_count < PROTOCOL_TXQ_MAX_IOV; i++)
+        {
+            protocol_txq_frame_t* frame = &txq->frames[(txq->head + i) % txq->capacity];
+            const uint16_t skip = i == 0 ? txq->head_offset : 0;
+            iov[iov_count].iov_base = frame->data + skip;
+            iov[iov_count].iov_len = frame->len - skip;
+            iov_count++;
+        }
+        pthread_mutex_unlock(&txq->lock);
+        if (iov_count == 0)
+        {
+            return total;
+        }
+
+        const ssize_t n = writev(txq->fd, iov, iov_count);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK ? total : -1;
+        }
+        txq->stats.writev_calls++;
+        total += n;
+
+        size_t left = (size_t)n;
+        bool notify = false;
+        pthread_mutex_lock(&txq->lock);
+        txq->queued_bytes -= (size_t)n;
+        txq->stats.bytes += (uint64_t)n;
+        while (left > 0)
+        {
+            const protocol_txq_frame_t* frame = &txq->frames[txq->head];
+            const size_t rest = frame->len - txq->head_offset;
+            if (left < rest)
+            {
+                txq->head_offset += (uint16_t)left;
+                txq->stats.partial_writes++;
+                break;
+            }
+            left -= rest;
+            txq->head_offset = 0;
+            txq->head = (uint16_t)((txq->head + 1) % txq->capacity);
+            txq->count--;
+            txq->stats.frames++;
+        }
+        if (txq->throttled && txq->queued_bytes <= txq->low_watermark && txq->count <= txq->low_frames)
+        {
+            txq->throttled = false;
+            notify = true;
+        }
+        pthread_mutex_unlock(&txq->lock);
+        if (notify && txq->backpressure)
+        {
+            txq->backpressure(txq->user, false);
+        }
+    }
+}
+
+bool protocol_txq_pending(protocol_txq_t* txq)
+{
+    pthread_mutex_lock(&txq->lock);
+    const bool pending = txq->count > 0;
+    pthread_mutex_unlock(&txq->lock);
+    return pending;
+}
+
+void protocol_txq_destroy(protocol_txq_t* txq)
+{
+    if (txq->frames)
+    {
+        pthread_mutex_destroy(&txq->lock);
+        protocol_free(txq->frames);
+    }
+    memset(txq, 0, sizeof(*txq));
+}
@@ -0,0 +1,153 @@
+//
+// 变长记录环形缓冲区
+//
+#include <stdlib.h>
+#include <string.h>
+#include "record_ring.h"
+
+// 填充记录的长度标记（读到后直接跳到缓冲区开头）
+#define RECORD_RING_PADDING UINT32_MAX
+// 最小容量
+#define RECORD_RING_MIN_CAPACITY 64
+
+// 记录总长度（记录头 + 数据，8 字节对齐）
+static inline size_t recordSize(uint32_t length) {
+    return ((size_t) RECORD_RING_HEADER_SIZE + length + 7) & ~(size_t) 7;
+}
+
+static inline void storeLength(RecordRing_t *rr, size_t pos, uint32_t length) {
+    memcpy(rr->buffer + pos % rr->capacity, &length, sizeof(length));
+}
+
+static inline uint32_t loadLength(const RecordRing_t *rr, size_t pos) {
+    uint32_t length;
+    memcpy(&length, rr->buffer + pos % rr->capacity, sizeof(length));
+    return length;
+}
+
+// 初始化记录环
+bool RecordRing_Init(RecordRing_t *rr, uint32_t capacity) {
+    memset(rr, 0, sizeof(*rr));
+    if (capacity < RECORD_RING_MIN_CAPACITY) {
+        capacity = RECORD_RING_MIN_CAPACITY;
+    }
+    capacity = (capacity + 7) & ~(uint32_t) 7;
+    rr->buffer = (uint8_t *) malloc(capacity);
+    if (rr->buffer == NULL) {
+        return false;
+    }
+    rr->capacity = capacity;
+    // 环为空时任意位置都能放下不超过一半容量的记录（必要时先填充到结尾）
+    rr->maxRecord = capacity / 2 - RECORD_RING_HEADER_SIZE;
+    atomic_init(&rr->head, 0);
+    atomic_init(&rr->tail, 0);
+    return true;
+}
+
+// 释放记录环
+void RecordRing_Free(RecordRing_t *rr) {
+    if (rr && rr->buffer) {
+        free(rr->buffer);
+        rr->buffer = NULL;
+        rr->capacity = 0;
+    }
+}
+
+// 预留一条记录
+uint8_t *RecordRing_Reserve(RecordRing_t *rr, uint32_t length) {
+    if (length > rr->maxRecord) {
+        return NULL;
+    }
+    const size_t head = atomic_load_explicit(&rr->head, memory_order_relaxed);
+    const size_t tail = atomic_load_explicit(&rr->tail, memory_order_acquire);
+    const size_t need = recordSize(length);
+    const size_t offset = head % rr->capacity;
+    // 尾部放不下时用填充记录占满尾部，记录从缓冲区开头开始
+    const size_t pad = rr->capacity - offset < need ? rr->capacity - offset : 0;
+    if (rr->capacity - (head - tail) < pad + need) {
+        return NULL;
+    }
+    if (pad > 0) {
+        storeLength(rr, head, RECORD_RING_PADDING);
+    }
+    rr->reserveOffset = head + pad;
+    rr->reserveLength = length;
+    rr->reserved = true;
+    return rr->buffer + rr->reserveOffset % rr->capacity + RECORD_RING_HEADER_SIZE;
+}
+
+// 提交预留的记录
+void RecordRing_Commit(RecordRing_t *rr, uint32_t length) {
+    if (!rr->reserved) {
+        return;
+    }
+    if (length > rr->reserveLength) {
+        length = rr->reserveLength;
+    }
+    storeLength(rr, rr->reserveOffset, length);
+    rr->reserved = false;
+    // release：记录内容先于新的写位置对消费者可见
+    atomic_store_explicit(&rr->head, rr->reserveOffset + recordSize(length), memory_order_release);
+}
+
+// 放弃当前预留（已写入的填充记录在 head 之后，对消费者不可见，下次预留会重新写入）
+void RecordRing_Abort(RecordRing_t *rr) {
+    rr->reserved = false;
+}
+
+// 拷贝写入一条记录
+bool RecordRing_Write(RecordRing_t *rr, const uint8_t *data, uint32_t length) {
+    uint8_t *dst = RecordRing_Reserve(rr, length);
+    if (dst == NULL) {
+        return false;
+    }
+    memcpy(dst, data, length);
+    RecordRing_Commit(rr, length);
+    return true;
+}
+
+// 查看最旧的一条记录
+uint8_t *RecordRing_Peek(RecordRing_t *rr, uint32_t *length) {
+    size_t tail = atomic_load_explicit(&rr->tail, memory_order_relaxed);
+    const size_t head = atomic_load_explicit(&rr->head, memory_order_acquire);
+    while (tail != head) {
+        const uint32_t len = loadLength(rr, tail);
+        if (len != RECORD_RING_PADDING) {
+            *length = len;
+            return rr->buffer + tail % rr->capacity + RECORD_RING_HEADER_SIZE;
+        }
+        // 跳过填充，立即归还给生产者
+        tail += rr->capacity - tail % rr->capacity;
+        atomic_store_explicit(&rr->tail, tail, memory_order_release);
+    }
+    return NULL;
+}
+
+// 释放最旧的一条记录
+void RecordRing_Release(RecordRing_t *rr) {
+    size_t tail = atomic_load_explicit(&rr->tail, memory_order_relaxed);
+    const size_t head = atomic_load_explicit(&rr->head, memory_order_acquire);
+    // 未经 Peek 时队首可能是填充记录，与 Peek 一样跳到缓冲区开头
+    if (tail != head && loadLength(rr, tail) == RECORD_RING_PADDING) {
+        tail += rr->capacity - tail % rr->capacity;
+    }
+    if (tail == head) {
+        atomic_store_explicit(&rr->tail, tail, memory_order_release);
+        return;
+    }
+    // release：消费者读完记录后生产者才能覆盖
+    atomic_store_explicit(&rr->tail, tail + recordSize(loadLength(rr, tail)), memory_order_release);
+}
+
+// 检查记录环是否为空
+bool RecordRing_IsEmpty(RecordRing_t *rr) {
+    return atomic_load_explicit(&rr->tail, memory_order_relaxed) ==
+           atomic_load_explicit(&rr->head, memory_order_acquire);
+}
+
+// 获取已用空间
+uint32_t RecordRing_GetUsedSpace(RecordRing_t *rr) {
+    const size_t tail = atomic_load_explicit(&rr->tail, memory_order_acquire);
+    const size_t head = atomic_load_explicit(&rr->head, memory_order_acquire);
+    return (uint32_t) (head - tail);
+}
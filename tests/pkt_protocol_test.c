@@ -1,14 +1,51 @@
 //
 // Created by marvin on 2025/2/15.
 //
+#define _XOPEN_SOURCE 700
+
 #include "unity.h"
 #include "pkt_protocol.h"
+#include "pkt_endian.h"
 #include "pkt_protocol_buf.h"
 #include "mqtt_utils.h"
 #include "ctrl_protocol.h"
+#include "pkt_compress.h"
+#include "pkt_fragment.h"
+#include "pkt_reliable.h"
+#include "pkt_pool.h"
+#include "pkt_capture.h"
+#include "pkt_serial_io.h"
+#include "pkt_txq.h"
+#include "pkt_scan.h"
+#include "pkt_demux.h"
+#include "pkt_trace.h"
+#include "mpmc_ring.h"
+#include "record_ring.h"
+#include "mirror_ring.h"
+#include "pkt_flight.h"
+#include "pkt_diag.h"
+#include "pkt_crc.h"
+#include "pkt_decode.h"
+#include "pkt_shm.h"
+// 只接受已定义的协议类型
+#define PKT_STATIC_TYPE_VALID(t) (PROTOCOL_TYPE_ID(t) > PROTOCOL_TYPE_MIN && PROTOCOL_TYPE_ID(t) < PROTOCOL_TYPE_MAX)
+#include "pkt_protocol_static.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
 
 static int callback_triggered = 0;
+static uint8_t last_type;
+static uint8_t last_data[PROTOCOL_MAX_UNCOMPRESSED_LEN];
+static uint16_t last_len;
 
 static void mock_callback(protocol_type_t type, uint8_t* data, uint16_t len)
 {
@@ -18,6 +55,14 @@ static void mock_callback(protocol_type_t type, uint8_t* data, uint16_t len)
     // print_hex_data(data, sizeof(control_cmd_t));
 }
 
+static void capture_callback(uint8_t type, const uint8_t* data, uint16_t len)
+{
+    callback_triggered++;
+    last_type = type;
+    last_len = len;
+    memcpy(last_data, data, len);
+}
+
 // 测试上下文
 protocol_receiver receiver;
 
@@ -65,7 +110,8 @@ void test_ctrl_protocol(void)
     memcpy(cmd->ping_text.msg, message, message_len);  // 注意不拷贝终止符
 
     // 转换为字节流 ----------
-    uint8_t *byte_stream = (uint8_t*)cmd;
+    uint8_t byte_stream[PROTOCOL_MAX_DATA_LEN];
+    TEST_ASSERT_EQUAL(total_size, control_cmd_encode(cmd, byte_stream, sizeof(byte_stream)));
 
 
     uint16_t frame_len;
@@ -249,14 +295,64 @@ void test_append_full_discard_on_realloc_fail(void)
     TEST_ASSERT_EQUAL(50, receiver.write_pos); // 无新数据写入
 }
 
-void test_htole16()
+void test_le_codec(void)
+{
+    // 非对齐地址上的小端读写
+    uint8_t buf[16] = {0};
+    pkt_store_le16(buf + 1, 0x1234);
+    pkt_store_le32(buf + 3, 0x89ABCDEF);
+    pkt_store_le64(buf + 7, 0x0102030405060708ull);
+    const uint8_t expect[] = {0x00, 0x34, 0x12, 0xEF, 0xCD, 0xAB, 0x89, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, buf, sizeof(expect));
+    TEST_ASSERT_EQUAL_HEX16(0x1234, pkt_load_le16(buf + 1));
+    TEST_ASSERT_EQUAL_HEX32(0x89ABCDEF, pkt_load_le32(buf + 3));
+    TEST_ASSERT_TRUE(pkt_load_le64(buf + 7) == 0x0102030405060708ull);
+
+    // 帧头、长度、CRC、帧尾均为小端
+    const uint8_t data[] = {'h', 'e', 'l', 'l', 'o', 'w', 'o', 'r', 'l', 'd'};
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    const uint16_t len = protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, data, sizeof(data), frame, sizeof(frame));
+    const uint8_t head[] = {0x55, 0xAA, 0x01, 0x0A, 0x00};
+    const uint8_t tail[] = {0x84, 0xDA, 0xAA, 0x55};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(head, frame, sizeof(head));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(tail, frame + len - sizeof(tail), sizeof(tail));
+}
+
+void test_ctrl_cmd_codec(void)
 {
-    printf("byte mode=%d\n",IS_LITTLE_ENDIAN);
-    const uint16_t big_endian_value = 0x1234;
-    const uint16_t little_endian_value = htole16(big_endian_value);
-    printf("Big-Endian:    0x%04X\n", big_endian_value);
-    printf("Little-Endian: 0x%04X\n", little_endian_value);
-    TEST_ASSERT_EQUAL_HEX16(0x3412, little_endian_value);
+    uint8_t storage[sizeof(control_cmd_t) + 5];
+    control_cmd_t* cmd = (control_cmd_t*)storage;
+    memset(storage, 0, sizeof(storage));
+    cmd->ctrl_id = 7;
+    cmd->ctrl_fields = CTRL_FIELD_MOTOR | CTRL_FIELD_SERVO | CTRL_FIELD_TEXT;
+    cmd->servo.angle = 90;
+    cmd->servo.speed = 50;
+    cmd->motor.mode = CTRL_MODE_DIFFERENTIAL;
+    cmd->motor.motion.diff.linear_vel = -1500;
+    cmd->motor.motion.diff.angular_vel = 900;
+    cmd->motor.motion.diff.accel = 80;
+    cmd->ping_text.len = 5;
+    memcpy(cmd->ping_text.msg, "hello", 5);
+
+    uint8_t wire[64];
+    const size_t len = control_cmd_encode(cmd, wire, sizeof(wire));
+    TEST_ASSERT_EQUAL(sizeof(control_cmd_t) + 5, len);
+    TEST_ASSERT_EQUAL(0, control_cmd_encode(cmd, wire, len - 1));
+    // 小端平台上与直接拷贝 pack(1) 结构体的结果一致
+    if (!PKT_BIG_ENDIAN)
+    {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(storage, wire, len);
+    }
+
+    control_cmd_t out;
+    const uint8_t* text;
+    TEST_ASSERT_EQUAL(0, control_cmd_decode(&out, &text, wire, len));
+    TEST_ASSERT_EQUAL(90, out.servo.angle);
+    TEST_ASSERT_EQUAL(CTRL_MODE_DIFFERENTIAL, out.motor.mode);
+    TEST_ASSERT_EQUAL(-1500, out.motor.motion.diff.linear_vel);
+    TEST_ASSERT_EQUAL(900, out.motor.motion.diff.angular_vel);
+    TEST_ASSERT_EQUAL_MEMORY("hello", text, out.ping_text.len);
+    TEST_ASSERT_EQUAL(-1, control_cmd_decode(&out, &text, wire, len - 1));
 }
 
 
@@ -281,7 +377,7 @@ void test_pack_and_parse()
         {
             result = 1;
             print_hex_data(parser.frame.data, parser.frame.len);
-            free(parser.frame.data);
+            protocol_free(parser.frame.data);
             protocol_parser_init(&parser);
         }
     }
@@ -299,14 +395,1961 @@ void test_mqtt_topic_match()
     TEST_ASSERT_FALSE(res);
 }
 
+void test_compress_lz_roundtrip(void)
+{
+    const char* log = "motor: speed=100 ok; motor: speed=100 ok; motor: speed=100 ok; motor: speed=101 ok";
+    const uint16_t log_len = strlen(log);
+    uint8_t packed[PROTOCOL_MAX_UNCOMPRESSED_LEN];
+    uint8_t raw[PROTOCOL_MAX_UNCOMPRESSED_LEN];
+
+    const int packed_len = protocol_compress(PROTOCOL_CODEC_LZ, (const uint8_t*)log, log_len, packed,
+                                             sizeof(packed));
+    TEST_ASSERT_TRUE(packed_len > 0);
+    TEST_ASSERT_TRUE(packed_len < log_len);
+    TEST_ASSERT_EQUAL(log_len, protocol_decompress(packed, packed_len, raw, sizeof(raw)));
+    TEST_ASSERT_EQUAL_MEMORY(log, raw, log_len);
+
+    // 截断的压缩数据必须被拒绝
+    TEST_ASSERT_EQUAL(-1, protocol_decompress(packed, packed_len - 1, raw, sizeof(raw)));
+}
+
+void test_compress_delta16_roundtrip(void)
+{
+    uint8_t samples[201];
+    for (int i = 0; i < 100; i++)
+    {
+        const int16_t v = (int16_t)(1000 + i * 3 - (i % 7));
+        samples[i * 2] = (uint8_t)(v & 0xFF);
+        samples[i * 2 + 1] = (uint8_t)((uint16_t)v >> 8);
+    }
+    samples[200] = 0x5A;
+    uint8_t packed[PROTOCOL_MAX_UNCOMPRESSED_LEN];
+    uint8_t raw[PROTOCOL_MAX_UNCOMPRESSED_LEN];
+
+    const int packed_len = protocol_compress(PROTOCOL_CODEC_DELTA16, samples, sizeof(samples), packed,
+                                             sizeof(packed));
+    TEST_ASSERT_TRUE(packed_len > 0);
+    TEST_ASSERT_TRUE(packed_len <= PROTOCOL_MAX_DATA_LEN);
+    TEST_ASSERT_EQUAL(sizeof(samples), protocol_decompress(packed, packed_len, raw, sizeof(raw)));
+    TEST_ASSERT_EQUAL_MEMORY(samples, raw, sizeof(samples));
+}
+
+void test_compressed_frame_receive(void)
+{
+    protocol_compressor_t compressor;
+    protocol_compressor_init(&compressor);
+    protocol_receiver_set_compressor(&receiver, &compressor);
+    receiver.callback = capture_callback;
+
+    // 超过单帧上限的日志，压缩后可以放进一帧
+    char log[300];
+    for (int i = 0; i < (int)sizeof(log); i++)
+    {
+        log[i] = "sensor link ok\n"[i % 15];
+    }
+    uint16_t frame_len;
+    uint8_t* frame = protocol_pack_frame_compressed(&compressor, PROTOCOL_TYPE_LOG, (const uint8_t*)log,
+                                                    sizeof(log), &frame_len);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_HEX8(PROTOCOL_TYPE_LOG | PROTOCOL_TYPE_FLAG_COMPRESSED, frame[2]);
+
+    protocol_receiver_append(&receiver, frame, frame_len);
+    protocol_free(frame);
+    TEST_ASSERT_EQUAL(1, callback_triggered);
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_LOG, last_type);
+    TEST_ASSERT_EQUAL(sizeof(log), last_len);
+    TEST_ASSERT_EQUAL_MEMORY(log, last_data, sizeof(log));
+    TEST_ASSERT_EQUAL(1, compressor.stats.frames_decoded);
+    TEST_ASSERT_TRUE(protocol_compress_ratio(&compressor.stats) < 0.5);
+
+    // 控制帧默认不压缩
+    const uint8_t cmd[] = {0x01, 0x02, 0x03};
+    frame = protocol_pack_frame_compressed(&compressor, PROTOCOL_TYPE_CONTROL, cmd, sizeof(cmd), &frame_len);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_HEX8(PROTOCOL_TYPE_CONTROL, frame[2]);
+    protocol_free(frame);
+
+    // 压缩与 CRC32C 帧尾可以同时使用
+    frame = protocol_pack_frame_compressed(&compressor, PROTOCOL_TYPE_LOG | PROTOCOL_TYPE_FLAG_CRC32C,
+                                           (const uint8_t*)log, sizeof(log), &frame_len);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_HEX8(PROTOCOL_TYPE_LOG | PROTOCOL_TYPE_FLAG_COMPRESSED | PROTOCOL_TYPE_FLAG_CRC32C, frame[2]);
+    protocol_receiver_append(&receiver, frame, frame_len);
+    protocol_free(frame);
+    TEST_ASSERT_EQUAL(2, callback_triggered);
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_LOG, last_type);
+    TEST_ASSERT_EQUAL_MEMORY(log, last_data, sizeof(log));
+}
+
+static protocol_reassembler_t reassembler;
+static protocol_message_t last_message;
+static uint8_t message_data[2048];
+static bool keep_message;
+
+static bool capture_message(const protocol_message_t* msg)
+{
+    last_message = *msg;
+    memcpy(message_data, msg->data, msg->len);
+    return keep_message;
+}
+
+static void fragment_callback(uint8_t type, const uint8_t* data, uint16_t len)
+{
+    callback_triggered++;
+    if (type == PROTOCOL_TYPE_FRAGMENT)
+    {
+        protocol_reassembler_on_fragment(&reassembler, data, len, 0);
+    }
+}
+
+static int emit_to_receiver(void* user, const uint8_t* frame, uint16_t frame_len)
+{
+    protocol_receiver_append((protocol_receiver*)user, frame, frame_len);
+    return 0;
+}
+
+void test_fragment_reassemble(void)
+{
+    uint8_t blob[1500];
+    for (int i = 0; i < (int)sizeof(blob); i++)
+    {
+        blob[i] = (uint8_t)(i * 7);
+    }
+    keep_message = false;
+    TEST_ASSERT_TRUE(protocol_reassembler_init(&reassembler, 2, sizeof(blob), 1000, capture_message));
+    receiver.callback = fragment_callback;
+
+    const int count = protocol_fragment_send(PROTOCOL_TYPE_SENSOR, 42, blob, sizeof(blob), emit_to_receiver,
+                                             &receiver);
+    TEST_ASSERT_EQUAL((sizeof(blob) + PROTOCOL_FRAGMENT_DATA_LEN - 1) / PROTOCOL_FRAGMENT_DATA_LEN, count);
+    TEST_ASSERT_EQUAL(count, callback_triggered);
+    TEST_ASSERT_EQUAL(1, reassembler.stats.messages);
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_SENSOR, last_message.type);
+    TEST_ASSERT_EQUAL(42, last_message.msg_id);
+    TEST_ASSERT_EQUAL(sizeof(blob), last_message.len);
+    TEST_ASSERT_EQUAL_MEMORY(blob, message_data, sizeof(blob));
+    protocol_reassembler_destroy(&reassembler);
+}
+
+typedef struct
+{
+    int count;
+    uint16_t len[8];
+    uint8_t payload[8][PROTOCOL_MAX_DATA_LEN];
+} fragment_collector_t;
+
+// 只保留分片帧负载，便于乱序投递
+static int emit_collect(void* user, const uint8_t* frame, uint16_t frame_len)
+{
+    fragment_collector_t* collector = user;
+    const uint16_t len = frame_len - PROTOCOL_HEADER_SIZE - PROTOCOL_TRAILER_SIZE;
+    collector->len[collector->count] = len;
+    memcpy(collector->payload[collector->count], frame + PROTOCOL_HEADER_SIZE, len);
+    collector->count++;
+    return 0;
+}
+
+void test_fragment_out_of_order_timeout_and_hold(void)
+{
+    fragment_collector_t frags = {0};
+    uint8_t blob[300];
+    memset(blob, 0xA5, sizeof(blob));
+    TEST_ASSERT_EQUAL(3, protocol_fragment_send(PROTOCOL_TYPE_LOG, 7, blob, sizeof(blob), emit_collect,
+                                                &frags));
+
+    keep_message = true;
+    TEST_ASSERT_TRUE(protocol_reassembler_init(&reassembler, 1, 512, 100, capture_message));
+
+    // 乱序 + 重复
+    protocol_reassembler_on_fragment(&reassembler, frags.payload[2], frags.len[2], 0);
+    protocol_reassembler_on_fragment(&reassembler, frags.payload[0], frags.len[0], 10);
+    protocol_reassembler_on_fragment(&reassembler, frags.payload[0], frags.len[0], 10);
+    TEST_ASSERT_EQUAL(1, reassembler.stats.duplicates);
+    protocol_reassembler_on_fragment(&reassembler, frags.payload[1], frags.len[1], 20);
+    TEST_ASSERT_EQUAL(1, reassembler.stats.messages);
+    TEST_ASSERT_EQUAL(sizeof(blob), last_message.len);
+
+    // 消息被保留期间占用唯一槽位，新消息无法开始重组
+    protocol_reassembler_on_fragment(&reassembler, frags.payload[0], frags.len[0], 30);
+    TEST_ASSERT_EQUAL(1, reassembler.stats.dropped);
+    protocol_reassembler_release(&reassembler, &last_message);
+
+    // 不完整的消息超时后被丢弃
+    protocol_reassembler_on_fragment(&reassembler, frags.payload[0], frags.len[0], 40);
+    protocol_reassembler_poll(&reassembler, 200);
+    TEST_ASSERT_EQUAL(1, reassembler.stats.timeouts);
+
+    // 超过满长的最后一片（解压后的 FRAGMENT 帧可达 512 字节）直接丢弃
+    static uint8_t oversized[PROTOCOL_FRAGMENT_HEADER_LEN + 500];
+    memset(oversized, 0x5A, sizeof(oversized));
+    pkt_store_le16(oversized, 9);
+    pkt_store_le16(oversized + 2, 0);
+    pkt_store_le16(oversized + 4, 1);
+    oversized[6] = PROTOCOL_TYPE_LOG;
+    protocol_reassembler_on_fragment(&reassembler, oversized, sizeof(oversized), 300);
+    TEST_ASSERT_EQUAL(2, reassembler.stats.dropped);
+    TEST_ASSERT_EQUAL(1, reassembler.stats.messages);
+    protocol_reassembler_destroy(&reassembler);
+}
+
+// ---------- 有损回环链路 ----------
+typedef struct
+{
+    uint8_t frames[64][PROTOCOL_MAX_FRAME_LEN];
+    uint16_t lens[64];
+    int head;
+    int tail;
+    int sent;
+    int drop_every; // 每 N 帧丢一帧
+} lossy_link_t;
+
+static int lossy_link_send(void* user, const uint8_t* frame, uint16_t frame_len)
+{
+    lossy_link_t* link = user;
+    link->sent++;
+    if (link->sent % link->drop_every == 0 || (link->head + 1) % 64 == link->tail)
+    {
+        return 0; // 丢弃
+    }
+    memcpy(link->frames[link->head], frame, frame_len);
+    link->lens[link->head] = frame_len;
+    link->head = (link->head + 1) % 64;
+    return 0;
+}
+
+static protocol_reliable_t* reliable_target;
+static uint32_t reliable_now;
+static uint8_t reliable_received[512];
+static int reliable_received_count;
+
+static void reliable_frame_callback(uint8_t type, const uint8_t* data, uint16_t len)
+{
+    protocol_reliable_on_frame(reliable_target, type, data, len, reliable_now);
+}
+
+static void reliable_deliver_cb(void* user, uint8_t type, const uint8_t* data, uint16_t len)
+{
+    (void)user;
+    (void)type;
+    (void)len;
+    reliable_received[reliable_received_count++] = data[0];
+}
+
+static void lossy_link_pump(lossy_link_t* link, protocol_receiver* rx, protocol_reliable_t* ep)
+{
+    reliable_target = ep;
+    while (link->tail != link->head)
+    {
+        const int i = link->tail;
+        link->tail = (link->tail + 1) % 64;
+        protocol_receiver_append(rx, link->frames[i], link->lens[i]);
+    }
+}
+
+void test_reliable_lossy_loopback(void)
+{
+    static lossy_link_t a_to_b = {.drop_every = 4};
+    static lossy_link_t b_to_a = {.drop_every = 5};
+    static protocol_reliable_t a;
+    static protocol_reliable_t b;
+    protocol_receiver rx_a;
+    protocol_receiver rx_b;
+    protocol_receiver_init(&rx_a, 256, reliable_frame_callback);
+    protocol_receiver_init(&rx_b, 256, reliable_frame_callback);
+    protocol_reliable_init(&a, 8, 50, lossy_link_send, NULL, &a_to_b);
+    protocol_reliable_init(&b, 8, 50, lossy_link_send, reliable_deliver_cb, &b_to_a);
+    reliable_received_count = 0;
+
+    const int total = 200;
+    int next = 0;
+    for (reliable_now = 0; reliable_now < 100000 && reliable_received_count < total; reliable_now += 10)
+    {
+        while (next < total && protocol_reliable_can_send(&a))
+        {
+            const uint8_t msg[4] = {(uint8_t)next, 0x11, 0x22, 0x33};
+            TEST_ASSERT_EQUAL(0, protocol_reliable_send(&a, PROTOCOL_TYPE_SENSOR, msg, sizeof(msg), reliable_now));
+            next++;
+        }
+        lossy_link_pump(&a_to_b, &rx_b, &b);
+        lossy_link_pump(&b_to_a, &rx_a, &a);
+        protocol_reliable_poll(&a, reliable_now);
+    }
+
+    TEST_ASSERT_EQUAL(total, reliable_received_count);
+    for (int i = 0; i < total; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX8((uint8_t)i, reliable_received[i]);
+    }
+    TEST_ASSERT_TRUE(a.stats.retransmits > 0);
+    TEST_ASSERT_EQUAL(total, b.stats.delivered);
+
+    // 负载超过槽位的数据帧（如解压后的 RELIABLE 帧）丢弃并计数，不影响后续帧
+    static uint8_t oversized[PROTOCOL_RELIABLE_HEADER_LEN + 500];
+    memset(oversized, 0x41, sizeof(oversized));
+    pkt_store_le16(oversized, b.rcv_nxt);
+    oversized[2] = PROTOCOL_TYPE_SENSOR;
+    protocol_reliable_on_frame(&b, PROTOCOL_TYPE_RELIABLE, oversized, sizeof(oversized), reliable_now);
+    TEST_ASSERT_EQUAL(1, b.stats.malformed);
+    TEST_ASSERT_EQUAL(total, b.stats.delivered);
+    protocol_reliable_on_frame(&b, PROTOCOL_TYPE_RELIABLE, oversized,
+                               PROTOCOL_RELIABLE_HEADER_LEN + PROTOCOL_RELIABLE_DATA_LEN, reliable_now);
+    TEST_ASSERT_EQUAL(total + 1, b.stats.delivered);
+    TEST_ASSERT_EQUAL_HEX8(0x41, reliable_received[total]);
+    protocol_receiver_destroy(&rx_a);
+    protocol_receiver_destroy(&rx_b);
+}
+
+static void* pool_worker(void* arg)
+{
+    (void)arg;
+    const uint8_t sensor_data[PROTOCOL_MAX_DATA_LEN] = {0x01, 0x02};
+    protocol_receiver rx;
+    protocol_receiver_init(&rx, 256, NULL);
+    for (int i = 0; i < 2000; i++)
+    {
+        uint16_t frame_len;
+        uint8_t* frame = protocol_pack_frame(PROTOCOL_TYPE_SENSOR, sensor_data, (uint16_t)(i % PROTOCOL_MAX_DATA_LEN),
+                                             &frame_len);
+        protocol_receiver_append(&rx, frame, frame_len);
+        protocol_free(frame);
+    }
+    protocol_receiver_destroy(&rx);
+    return NULL;
+}
+
+void test_frame_pool_allocator(void)
+{
+    // setUp 中的接收器使用默认分配器创建，切换前先释放
+    protocol_receiver_destroy(&receiver);
+    protocol_set_allocator(protocol_pool_allocator());
+
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_create(&threads[i], NULL, pool_worker, NULL);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    protocol_pool_stats_t stats;
+    protocol_pool_get_stats(&stats);
+    uint64_t allocs = 0;
+    for (int i = 0; i < PROTOCOL_POOL_CLASS_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL(0, stats.classes[i].in_use);
+        // 每个线程同时最多持有打包帧 + 解析数据两个块，容量应远小于分配次数
+        TEST_ASSERT_TRUE(stats.classes[i].capacity <= 64 * 8);
+        allocs += stats.classes[i].allocs;
+    }
+    TEST_ASSERT_TRUE(allocs >= 4 * 2000 * 2);
+    TEST_ASSERT_EQUAL(stats.large_allocs, stats.large_frees);
+
+    protocol_set_allocator(NULL);
+    protocol_receiver_init(&receiver, 100, (frame_callback)mock_callback);
+}
+
+void test_receiver_chunked_stream(void)
+{
+    // 多帧连续数据按不同长度切块追加，半帧跨越多次追加时不能丢帧
+    uint8_t stream[40 * PROTOCOL_MAX_FRAME_LEN];
+    uint16_t stream_len = 0;
+    for (int i = 0; i < 40; i++)
+    {
+        uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+        memset(payload, i, sizeof(payload));
+        stream_len += protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, (uint16_t)(i * 7 % PROTOCOL_MAX_DATA_LEN),
+                                               stream + stream_len, sizeof(stream) - stream_len);
+    }
+    for (uint16_t pos = 0, chunk = 1; pos < stream_len; pos += chunk, chunk = chunk % 61 + 3)
+    {
+        const uint16_t n = stream_len - pos < chunk ? stream_len - pos : chunk;
+        protocol_receiver_append(&receiver, stream + pos, n);
+    }
+    TEST_ASSERT_EQUAL(40, callback_triggered);
+    TEST_ASSERT_EQUAL(0, receiver.parser.stats.crc_errors);
+    TEST_ASSERT_EQUAL(0, receiver.parser.stats.format_errors);
+}
+
+void test_capture_roundtrip(void)
+{
+    const char* path = "pkt_capture_test.cap";
+    const uint8_t sensor_data[] = {0x01, 0x02, 0x03, 0x04};
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    const uint16_t frame_len = protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, sensor_data, sizeof(sensor_data),
+                                                        frame, sizeof(frame));
+
+    protocol_capture_writer_t writer;
+    TEST_ASSERT_TRUE(protocol_capture_open(&writer, path, 0));
+    // 一帧拆成两次读取，另一个端口写入一帧
+    TEST_ASSERT_EQUAL(0, protocol_capture_write(&writer, 1, 100, frame, 6));
+    TEST_ASSERT_EQUAL(0, protocol_capture_write(&writer, 1, 200, frame + 6, frame_len - 6));
+    TEST_ASSERT_EQUAL(0, protocol_capture_write(&writer, 2, 300, frame, frame_len));
+    protocol_capture_close(&writer);
+
+    protocol_capture_reader_t reader;
+    TEST_ASSERT_TRUE(protocol_capture_map(&reader, path));
+    protocol_capture_record_t record;
+    int records = 0;
+    while (protocol_capture_next(&reader, &record) == 1)
+    {
+        if (record.port_id == 1)
+        {
+            protocol_receiver_append(&receiver, record.data, record.len);
+        }
+        records++;
+    }
+    TEST_ASSERT_EQUAL(3, records);
+    TEST_ASSERT_EQUAL(300, record.ts_ns);
+    TEST_ASSERT_EQUAL(1, callback_triggered);
+    TEST_ASSERT_EQUAL(1, receiver.parser.stats.frames);
+    protocol_capture_unmap(&reader);
+
+    // 未知版本拒绝打开
+    const int fd = open(path, O_WRONLY);
+    TEST_ASSERT_TRUE(fd >= 0);
+    uint8_t version[4];
+    pkt_store_le32(version, PROTOCOL_CAPTURE_VERSION + 1);
+    TEST_ASSERT_EQUAL(4, pwrite(fd, version, sizeof(version), 8));
+    close(fd);
+    TEST_ASSERT_FALSE(protocol_capture_map(&reader, path));
+    remove(path);
+}
+
+// 打开一对原始模式的伪终端，返回主端
+static int open_raw_pty(int* slave)
+{
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+    {
+        return -1;
+    }
+    *slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    struct termios tio;
+    if (*slave < 0 || tcgetattr(*slave, &tio) < 0)
+    {
+        close(master);
+        return -1;
+    }
+    tio.c_iflag = 0;
+    tio.c_oflag = 0;
+    tio.c_lflag = 0;
+    tio.c_cflag = (tio.c_cflag & ~(tcflag_t)(CSIZE | PARENB)) | CS8 | CREAD | CLOCAL;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(*slave, TCSANOW, &tio);
+    return master;
+}
+
+static void serial_io_pty_roundtrip(const bool prefer_uring)
+{
+    int slave = -1;
+    const int master = open_raw_pty(&slave);
+    TEST_ASSERT_TRUE(master >= 0);
+
+    protocol_receiver master_rx;
+    protocol_receiver_init(&master_rx, 256, capture_callback);
+    protocol_receiver_destroy(&receiver);
+    protocol_receiver_init(&receiver, 256, capture_callback);
+    serial_io_t io;
+    TEST_ASSERT_TRUE(serial_io_init(&io, 2, prefer_uring));
+    const int a = serial_io_add_port(&io, master, &master_rx);
+    const int b = serial_io_add_port(&io, slave, &receiver);
+    TEST_ASSERT_EQUAL(0, a);
+    TEST_ASSERT_EQUAL(1, b);
+
+    // 主端批量发送 20 帧，从端回送 1 帧
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    for (uint8_t i = 0; i < 20; i++)
+    {
+        const uint8_t payload[] = {i, (uint8_t)(i * 3), 0x55, 0xAA};
+        const uint16_t len = protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, sizeof(payload), frame,
+                                                      sizeof(frame));
+        TEST_ASSERT_EQUAL(0, serial_io_send(&io, a, frame, len));
+    }
+    const uint8_t reply[] = {0x42};
+    const uint16_t reply_len = protocol_pack_frame_into(PROTOCOL_TYPE_CONTROL, reply, sizeof(reply), frame,
+                                                        sizeof(frame));
+    TEST_ASSERT_EQUAL(0, serial_io_send(&io, b, frame, reply_len));
+
+    for (int round = 0; round < 200 && callback_triggered < 21; round++)
+    {
+        TEST_ASSERT_TRUE(serial_io_poll(&io, 10) >= 0);
+    }
+    TEST_ASSERT_EQUAL(21, callback_triggered);
+    TEST_ASSERT_EQUAL(0, io.ports[a].tx_len);
+    TEST_ASSERT_EQUAL(io.ports[a].tx_bytes, io.ports[b].rx_bytes);
+    TEST_ASSERT_EQUAL(0, receiver.parser.stats.crc_errors);
+    serial_io_destroy(&io);
+
+    // 扩容上限小于读取块时按剩余空间读取，不会一直预留失败
+    protocol_receiver small;
+    protocol_receiver_init(&small, 100, capture_callback);
+    protocol_receiver_set_limits(&small, 0, 0);
+    TEST_ASSERT_TRUE(serial_io_init(&io, 1, prefer_uring));
+    TEST_ASSERT_EQUAL(0, serial_io_add_port(&io, slave, &small));
+    TEST_ASSERT_EQUAL(reply_len, write(master, frame, reply_len));
+    for (int round = 0; round < 200 && callback_triggered < 22; round++)
+    {
+        TEST_ASSERT_TRUE(serial_io_poll(&io, 10) >= 0);
+    }
+    TEST_ASSERT_EQUAL(22, callback_triggered);
+    TEST_ASSERT_EQUAL(0, io.ports[0].rx_stalls);
+    serial_io_destroy(&io);
+    protocol_receiver_destroy(&small);
+
+    // 拉取模式下无人取帧、缓冲区已满且没有读写在途时，一直等待的 poll 也必须返回并计数
+    protocol_receiver stalled;
+    protocol_receiver_init(&stalled, 100, capture_callback);
+    protocol_receiver_set_limits(&stalled, 0, 0);
+    protocol_receiver_set_pull(&stalled, true);
+    TEST_ASSERT_NOT_NULL(protocol_receiver_reserve(&stalled, PROTOCOL_RECEIVER_MIN_SIZE));
+    protocol_receiver_commit(&stalled, PROTOCOL_RECEIVER_MIN_SIZE);
+    TEST_ASSERT_TRUE(serial_io_init(&io, 1, prefer_uring));
+    TEST_ASSERT_EQUAL(0, serial_io_add_port(&io, slave, &stalled));
+    TEST_ASSERT_EQUAL(1, write(master, reply, sizeof(reply)));
+    TEST_ASSERT_TRUE(serial_io_poll(&io, -1) >= 0);
+    TEST_ASSERT_TRUE(io.ports[0].rx_stalls > 0);
+    serial_io_destroy(&io);
+    protocol_receiver_destroy(&stalled);
+
+    protocol_receiver_destroy(&master_rx);
+    close(slave);
+    close(master);
+}
+
+void test_serial_io_pty_fallback(void)
+{
+    serial_io_pty_roundtrip(false);
+}
+
+void test_serial_io_pty_uring(void)
+{
+    // 内核不支持 io_uring 时自动退化为 poll 后端，测试同样通过
+    serial_io_pty_roundtrip(true);
+}
+
+static int backpressure_high;
+static int backpressure_low;
+
+static void backpressure_cb(void* user, const bool throttled)
+{
+    (void)user;
+    if (throttled)
+    {
+        backpressure_high++;
+    }
+    else
+    {
+        backpressure_low++;
+    }
+}
+
+void test_txq_writev_backpressure(void)
+{
+    int slave = -1;
+    const int master = open_raw_pty(&slave);
+    TEST_ASSERT_TRUE(master >= 0);
+    protocol_receiver_destroy(&receiver);
+    protocol_receiver_init(&receiver, 1024, capture_callback);
+    backpressure_high = 0;
+    backpressure_low = 0;
+
+    protocol_txq_t txq;
+    TEST_ASSERT_TRUE(protocol_txq_init(&txq, master, 128, 8 * 1024, 1024, backpressure_cb, NULL));
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    int queued = 0;
+    for (;;)
+    {
+        memset(payload, queued, sizeof(payload));
+        if (protocol_txq_pack(&txq, PROTOCOL_TYPE_SENSOR, payload, sizeof(payload)) != 0)
+        {
+            break;
+        }
+        queued++;
+    }
+    // 入队不写 fd，满时拒绝而不是阻塞
+    TEST_ASSERT_EQUAL(128, queued);
+    TEST_ASSERT_EQUAL(1, txq.stats.rejected);
+    TEST_ASSERT_EQUAL(1, backpressure_high);
+    TEST_ASSERT_TRUE(protocol_txq_pending(&txq));
+
+    uint8_t buf[512];
+    for (int round = 0; round < 1000 && callback_triggered < queued; round++)
+    {
+        TEST_ASSERT_TRUE(protocol_txq_flush(&txq) >= 0);
+        const ssize_t n = read(slave, buf, sizeof(buf));
+        if (n > 0)
+        {
+            protocol_receiver_append(&receiver, buf, (uint16_t)n);
+        }
+    }
+    TEST_ASSERT_EQUAL(queued, callback_triggered);
+    TEST_ASSERT_EQUAL(127, last_data[0]);
+    TEST_ASSERT_EQUAL(1, backpressure_low);
+    TEST_ASSERT_FALSE(protocol_txq_pending(&txq));
+    TEST_ASSERT_EQUAL(queued, txq.stats.frames);
+    // 多帧合并为一次 writev
+    TEST_ASSERT_TRUE(txq.stats.writev_calls < (uint32_t)queued);
+    protocol_txq_destroy(&txq);
+
+    // 默认水位 + 小帧：字节数远达不到高水位，按帧数在队列满之前进入背压
+    backpressure_high = 0;
+    backpressure_low = 0;
+    TEST_ASSERT_TRUE(protocol_txq_init(&txq, master, 16, 0, 0, backpressure_cb, NULL));
+    for (int i = 0; i < 12; i++)
+    {
+        TEST_ASSERT_EQUAL(0, protocol_txq_pack(&txq, PROTOCOL_TYPE_ACK, payload, 1));
+        TEST_ASSERT_EQUAL(i >= 11 ? 1 : 0, backpressure_high);
+    }
+    TEST_ASSERT_EQUAL(0, txq.stats.rejected);
+    for (int round = 0; round < 1000 && protocol_txq_pending(&txq); round++)
+    {
+        if (protocol_txq_flush(&txq) > 0)
+        {
+            TEST_ASSERT_TRUE(read(slave, buf, sizeof(buf)) > 0);
+        }
+    }
+    TEST_ASSERT_EQUAL(1, backpressure_low);
+    protocol_txq_destroy(&txq);
+    close(slave);
+    close(master);
+}
+
+static size_t naive_scan_header(const uint8_t* data, const size_t len)
+{
+    for (size_t i = 0; i + 1 < len; i++)
+    {
+        if (data[i] == 0x55 && data[i + 1] == 0xAA)
+        {
+            return i;
+        }
+    }
+    return len > 0 && data[len - 1] == 0x55 ? len - 1 : len;
+}
+
+void test_scan_header_matches_naive(void)
+{
+    uint8_t noise[300];
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < sizeof(noise); i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        // 噪声中混入大量 0x55 和 0xAA，但不构成字节对
+        const uint8_t r = (uint8_t)(seed >> 16);
+        noise[i] = r < 64 ? 0x55 : r;
+        if (noise[i] == 0xAA && i > 0 && noise[i - 1] == 0x55)
+        {
+            noise[i] = 0x00;
+        }
+    }
+    // 每个偏移、每个长度上植入帧头，覆盖向量块边界和尾部
+    for (size_t len = 0; len <= 80; len++)
+    {
+        for (size_t at = 0; at <= len; at++)
+        {
+            uint8_t buf[80];
+            memcpy(buf, noise + at, len);
+            if (at + 1 < len)
+            {
+                buf[at] = 0x55;
+                buf[at + 1] = 0xAA;
+            }
+            const size_t expect = naive_scan_header(buf, len);
+            TEST_ASSERT_EQUAL(expect, protocol_scan_header(buf, len));
+            TEST_ASSERT_EQUAL(expect, protocol_scan_header_scalar(buf, len));
+        }
+    }
+    TEST_ASSERT_EQUAL(sizeof(noise) - (noise[sizeof(noise) - 1] == 0x55),
+                      protocol_scan_header(noise, sizeof(noise)));
+}
+
+void test_receiver_resync_after_noise(void)
+{
+    protocol_receiver_destroy(&receiver);
+    protocol_receiver_init(&receiver, 256, capture_callback);
+    uint8_t stream[1200];
+    memset(stream, 0x55, 400); // 帧头前是连续的 0x55
+    uint16_t len = 400;
+    const uint8_t payload[] = {0xAA, 0x55, 0x55, 0xAA};
+    len += protocol_pack_frame_into(PROTOCOL_TYPE_LOG, payload, sizeof(payload), stream + len, sizeof(stream) - len);
+    for (int i = 0; i < 700; i++)
+    {
+        stream[len++] = (uint8_t)(i * 37);
+    }
+    len += protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, 2, stream + len, sizeof(stream) - len);
+    for (uint16_t pos = 0; pos < len; pos += 50)
+    {
+        protocol_receiver_append(&receiver, stream + pos, len - pos < 50 ? len - pos : 50);
+    }
+    TEST_ASSERT_EQUAL(2, callback_triggered);
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_SENSOR, last_type);
+    TEST_ASSERT_EQUAL(2, last_len);
+}
+
+static void static_frame_cb(void* user, const pkt_static_parser_t* parser)
+{
+    (void)user;
+    capture_callback(parser->type, parser->data, parser->len);
+}
+
+void test_static_parser_interop(void)
+{
+    uint8_t stream[4 * PROTOCOL_MAX_FRAME_LEN];
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    for (size_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t)(i * 11);
+    }
+    // 库打包的帧、非法类型的帧、空负载帧、纯头文件打包的帧
+    size_t len = protocol_pack_frame_into(PROTOCOL_TYPE_LOG, payload, sizeof(payload), stream, sizeof(stream));
+    len += protocol_pack_frame_into(0x7F, payload, 4, stream + len, (uint16_t)(sizeof(stream) - len));
+    len += protocol_pack_frame_into(PROTOCOL_TYPE_ACK, payload, 0, stream + len, (uint16_t)(sizeof(stream) - len));
+    TEST_ASSERT_EQUAL(0, pkt_static_pack(0x7F, payload, 4, stream + len, sizeof(stream) - len));
+    const uint16_t static_len = pkt_static_pack(PROTOCOL_TYPE_SENSOR, payload, 9, stream + len, sizeof(stream) - len);
+    TEST_ASSERT_EQUAL(PROTOCOL_HEADER_SIZE + 9 + PROTOCOL_TRAILER_SIZE, static_len);
+
+    // 与库的打包结果逐字节一致
+    uint8_t expect[PROTOCOL_MAX_FRAME_LEN];
+    protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, 9, expect, sizeof(expect));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, stream + len, static_len);
+    len += static_len;
+
+    pkt_static_parser_t parser;
+    pkt_static_parser_init(&parser);
+    TEST_ASSERT_EQUAL(3, pkt_static_feed(&parser, stream, len, static_frame_cb, NULL));
+    TEST_ASSERT_EQUAL(1, parser.format_errors);
+    TEST_ASSERT_EQUAL(0, parser.crc_errors);
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_SENSOR, last_type);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, last_data, 9);
+
+    // 篡改负载后 CRC 校验失败
+    stream[PROTOCOL_HEADER_SIZE] ^= 1;
+    pkt_static_parser_init(&parser);
+    TEST_ASSERT_EQUAL(2, pkt_static_feed(&parser, stream, len, static_frame_cb, NULL));
+    TEST_ASSERT_EQUAL(1, parser.crc_errors);
+}
+
+void test_receiver_large_append_and_shrink(void)
+{
+    protocol_receiver_destroy(&receiver);
+    protocol_receiver_init(&receiver, 256, capture_callback);
+    protocol_receiver_set_limits(&receiver, 4096, 4);
+
+    // 单次追加远超 64 KB 的数据：到达上限后分块解析，不丢数据
+    const size_t frames = 2000;
+    uint8_t* stream = malloc(frames * PROTOCOL_MAX_FRAME_LEN);
+    size_t len = 0;
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    for (size_t i = 0; i < frames; i++)
+    {
+        memset(payload, (int)i, sizeof(payload));
+        len += protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, sizeof(payload), stream + len,
+                                        PROTOCOL_MAX_FRAME_LEN);
+    }
+    TEST_ASSERT_TRUE(len > 65536);
+    protocol_receiver_append(&receiver, stream, len);
+    TEST_ASSERT_EQUAL(frames, callback_triggered);
+    TEST_ASSERT_EQUAL(4096, receiver.buffer_size);
+    TEST_ASSERT_EQUAL(0, receiver.dropped_bytes);
+
+    // 突发结束后连续小块追加，缓冲区按滞回逐级收缩回初始大小
+    for (size_t pos = 0; pos < 40 * PROTOCOL_MAX_FRAME_LEN; pos += 13)
+    {
+        protocol_receiver_append(&receiver, stream + pos, 13);
+    }
+    TEST_ASSERT_EQUAL(256, receiver.buffer_size);
+    TEST_ASSERT_EQUAL(frames + 40, callback_triggered);
+    TEST_ASSERT_EQUAL(0, receiver.parser.stats.crc_errors);
+    free(stream);
+}
+
+typedef struct
+{
+    protocol_stream_t* stream;
+    int received;
+    int out_of_order;
+} demux_consumer_t;
+
+static void* ordered_consumer(void* arg)
+{
+    demux_consumer_t* c = arg;
+    protocol_stream_frame_t* frame;
+    while ((frame = protocol_stream_pop(c->stream, -1)) != NULL)
+    {
+        if (frame->seq != (uint32_t)c->received || frame->data[0] != (uint8_t)c->received)
+        {
+            c->out_of_order++;
+        }
+        c->received++;
+        protocol_stream_release(c->stream, frame);
+    }
+    return NULL;
+}
+
+static void* parallel_consumer(void* arg)
+{
+    demux_consumer_t* c = arg;
+    protocol_stream_frame_t* frame;
+    while ((frame = protocol_stream_pop(c->stream, -1)) != NULL)
+    {
+        __atomic_fetch_add(&c->received, 1, __ATOMIC_RELAXED);
+        const struct timespec work = {0, 50000};
+        nanosleep(&work, NULL);
+        protocol_stream_release(c->stream, frame);
+    }
+    return NULL;
+}
+
+void test_demux_streams(void)
+{
+    protocol_stream_t control, sensor, log;
+    TEST_ASSERT_TRUE(protocol_stream_init(&control, PROTOCOL_STREAM_ORDERED, 8));
+    TEST_ASSERT_TRUE(protocol_stream_init(&sensor, PROTOCOL_STREAM_PARALLEL, 8));
+    TEST_ASSERT_TRUE(protocol_stream_init(&log, PROTOCOL_STREAM_BEST_EFFORT, 4));
+    // 有消费者的队列允许短暂等待，保证不丢帧
+    protocol_stream_set_push_timeout(&control, 5000);
+    protocol_stream_set_push_timeout(&sensor, 5000);
+    protocol_demux_t demux;
+    protocol_demux_init(&demux);
+    protocol_demux_route(&demux, PROTOCOL_TYPE_CONTROL, &control);
+    protocol_demux_route(&demux, PROTOCOL_TYPE_SENSOR, &sensor);
+    protocol_demux_route(&demux, PROTOCOL_TYPE_LOG, &log);
+
+    protocol_receiver_destroy(&receiver);
+    protocol_receiver_init(&receiver, 1024, capture_callback);
+    protocol_demux_attach(&demux, &receiver);
+
+    demux_consumer_t ctrl_consumer = {&control, 0, 0};
+    demux_consumer_t sensor_consumer = {&sensor, 0, 0};
+    pthread_t ctrl_thread, sensor_threads[3];
+    pthread_create(&ctrl_thread, NULL, ordered_consumer, &ctrl_consumer);
+    for (int i = 0; i < 3; i++)
+    {
+        pthread_create(&sensor_threads[i], NULL, parallel_consumer, &sensor_consumer);
+    }
+
+    // 控制、传感器、日志帧交错到达；未路由的类型计入 unrouted
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    uint8_t payload[32];
+    const int rounds = 300;
+    for (int i = 0; i < rounds; i++)
+    {
+        memset(payload, i, sizeof(payload));
+        uint16_t n = protocol_pack_frame_into(PROTOCOL_TYPE_CONTROL, payload, sizeof(payload), frame, sizeof(frame));
+        protocol_receiver_append(&receiver, frame, n);
+        n = protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, sizeof(payload), frame, sizeof(frame));
+        protocol_receiver_append(&receiver, frame, n);
+        if (i % 10 == 0)
+        {
+            n = protocol_pack_frame_into(PROTOCOL_TYPE_LOG, payload, sizeof(payload), frame, sizeof(frame));
+            protocol_receiver_append(&receiver, frame, n);
+        }
+    }
+    uint16_t n = protocol_pack_frame_into(PROTOCOL_TYPE_ACK, payload, 1, frame, sizeof(frame));
+    protocol_receiver_append(&receiver, frame, n);
+
+    protocol_stream_close(&control);
+    protocol_stream_close(&sensor);
+    pthread_join(ctrl_thread, NULL);
+    for (int i = 0; i < 3; i++)
+    {
+        pthread_join(sensor_threads[i], NULL);
+    }
+
+    // 处理器接管后不再调用原回调
+    TEST_ASSERT_EQUAL(0, callback_triggered);
+    TEST_ASSERT_EQUAL(rounds, ctrl_consumer.received);
+    TEST_ASSERT_EQUAL(0, ctrl_consumer.out_of_order);
+    TEST_ASSERT_EQUAL(rounds, sensor_consumer.received);
+    TEST_ASSERT_EQUAL(0, sensor.stats.dropped);
+    TEST_ASSERT_EQUAL(1, demux.unrouted);
+
+    // 日志队列无人消费：只保留最新的 4 帧
+    TEST_ASSERT_EQUAL(rounds / 10, log.stats.pushed);
+    TEST_ASSERT_EQUAL(rounds / 10 - 4, log.stats.dropped);
+    protocol_stream_close(&log);
+    for (int i = 0; i < 4; i++)
+    {
+        protocol_stream_frame_t* f = protocol_stream_pop(&log, 0);
+        TEST_ASSERT_NOT_NULL(f);
+        TEST_ASSERT_EQUAL(rounds / 10 - 4 + i, f->seq);
+        TEST_ASSERT_EQUAL(PROTOCOL_TYPE_LOG, f->type);
+        protocol_stream_release(&log, f);
+    }
+    TEST_ASSERT_NULL(protocol_stream_pop(&log, 0));
+    protocol_stream_destroy(&control);
+    protocol_stream_destroy(&sensor);
+    protocol_stream_destroy(&log);
+
+    // 默认不等待：传感器队列无人消费时丢弃新帧，控制帧照常入队
+    TEST_ASSERT_TRUE(protocol_stream_init(&control, PROTOCOL_STREAM_ORDERED, 4));
+    TEST_ASSERT_TRUE(protocol_stream_init(&sensor, PROTOCOL_STREAM_PARALLEL, 2));
+    for (int i = 0; i < 4; i++)
+    {
+        n = protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, sizeof(payload), frame, sizeof(frame));
+        protocol_receiver_append(&receiver, frame, n);
+        n = protocol_pack_frame_into(PROTOCOL_TYPE_CONTROL, payload, sizeof(payload), frame, sizeof(frame));
+        protocol_receiver_append(&receiver, frame, n);
+    }
+    TEST_ASSERT_EQUAL(2, sensor.stats.dropped);
+    TEST_ASSERT_EQUAL(0, sensor.stats.producer_waits);
+    TEST_ASSERT_EQUAL(4, control.ready);
+
+    // 超长负载拒绝而不是截断
+    static uint8_t big[PROTOCOL_STREAM_FRAME_MAX + 1];
+    TEST_ASSERT_EQUAL(-1, protocol_stream_push(&control, PROTOCOL_TYPE_CONTROL, big, sizeof(big), NULL));
+    TEST_ASSERT_EQUAL(1, control.stats.dropped);
+
+    // 有限等待：超时后丢弃
+    protocol_stream_set_push_timeout(&control, 10);
+    TEST_ASSERT_EQUAL(-1, protocol_stream_push(&control, PROTOCOL_TYPE_CONTROL, payload, 1, NULL));
+    TEST_ASSERT_EQUAL(1, control.stats.producer_waits);
+    TEST_ASSERT_EQUAL(2, control.stats.dropped);
+    protocol_stream_destroy(&control);
+    protocol_stream_destroy(&sensor);
+}
+
+static protocol_frame_times_t traced_times;
+static int traced_frames;
+
+static void trace_handler(void* user, const uint8_t type, const uint8_t* data, const uint16_t len,
+                          const protocol_frame_times_t* times)
+{
+    (void)user;
+    (void)type;
+    (void)data;
+    (void)len;
+    TEST_ASSERT_NOT_NULL(times);
+    traced_times = *times;
+    traced_frames++;
+}
+
+void test_frame_timestamps_and_latency(void)
+{
+    protocol_latency_hist_t hist;
+    protocol_latency_reset(&hist);
+    protocol_receiver_enable_timestamps(&receiver, true, &hist);
+    protocol_receiver_set_handler(&receiver, trace_handler, NULL);
+    traced_frames = 0;
+
+    // 帧分两次到达，中间间隔 2ms：帧头时间早于负载完成时间
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    const uint8_t payload[16] = {1, 2, 3};
+    const uint16_t n = protocol_pack_frame_into(PROTOCOL_TYPE_CONTROL, payload, sizeof(payload), frame, sizeof(frame));
+    protocol_receiver_append(&receiver, frame, 8);
+    const struct timespec gap = {0, 2000000};
+    nanosleep(&gap, NULL);
+    protocol_receiver_append(&receiver, frame + 8, n - 8);
+    TEST_ASSERT_EQUAL(1, traced_frames);
+    TEST_ASSERT_TRUE(traced_times.header_ns > 0);
+    TEST_ASSERT_TRUE(traced_times.payload_ns - traced_times.header_ns >= 2000000);
+    TEST_ASSERT_TRUE(traced_times.dispatch_ns >= traced_times.payload_ns);
+    TEST_ASSERT_EQUAL(1, hist.count);
+    TEST_ASSERT_EQUAL(traced_times.dispatch_ns - traced_times.header_ns, hist.max_ns);
+
+    // 解析器重置后开关保持
+    for (int i = 0; i < 9; i++)
+    {
+        protocol_receiver_append(&receiver, frame, n);
+    }
+    TEST_ASSERT_EQUAL(10, traced_frames);
+    TEST_ASSERT_EQUAL(10, hist.count);
+
+    // 分位数落在真实值的 1/8 相对误差内
+    protocol_latency_reset(&hist);
+    for (uint64_t v = 1; v <= 100000; v++)
+    {
+        protocol_latency_record(&hist, v * 100);
+    }
+    const uint64_t p50 = protocol_latency_quantile(&hist, 0.5);
+    const uint64_t p99 = protocol_latency_quantile(&hist, 0.99);
+    TEST_ASSERT_TRUE(p50 >= 5000000 && p50 <= 5000000 + 5000000 / 8);
+    TEST_ASSERT_TRUE(p99 >= 9900000 && p99 <= 9900000 + 9900000 / 8);
+    TEST_ASSERT_EQUAL(10000000, protocol_latency_quantile(&hist, 1.0));
+    TEST_ASSERT_EQUAL(100, hist.min_ns);
+    TEST_ASSERT_EQUAL(5000050, protocol_latency_mean(&hist));
+
+    // 关闭后处理函数收到 NULL 时间戳不再统计
+    protocol_receiver_enable_timestamps(&receiver, false, &hist);
+    protocol_receiver_set_handler(&receiver, NULL, NULL);
+    protocol_receiver_append(&receiver, frame, n);
+    TEST_ASSERT_EQUAL(100000, hist.count);
+    TEST_ASSERT_EQUAL(1, callback_triggered);
+}
+
+#define MPMC_TEST_PRODUCERS 4
+#define MPMC_TEST_CONSUMERS 2
+#define MPMC_TEST_FRAMES 20000
+
+typedef struct
+{
+    MpmcRing_t* ring;
+    uint8_t id;
+    uint32_t received[MPMC_TEST_PRODUCERS];
+    uint32_t last_seq[MPMC_TEST_PRODUCERS];
+    int errors;
+} mpmc_test_ctx_t;
+
+static atomic_int mpmc_producers_done;
+
+static void* mpmc_producer(void* arg)
+{
+    mpmc_test_ctx_t* ctx = arg;
+    uint8_t frames[4][PROTOCOL_MAX_FRAME_LEN];
+    const uint8_t* ptrs[4] = {frames[0], frames[1], frames[2], frames[3]};
+    uint16_t lens[4];
+    uint32_t seq = 0;
+    while (seq < MPMC_TEST_FRAMES)
+    {
+        // 单帧与批量入队交替使用
+        const uint32_t batch = (seq % 3 == 0) ? 1 : 4;
+        uint32_t built = 0;
+        for (; built < batch && seq + built < MPMC_TEST_FRAMES; built++)
+        {
+            uint8_t payload[24] = {0};
+            payload[0] = ctx->id;
+            pkt_store_le32(payload + 1, seq + built);
+            lens[built] = protocol_pack_frame_into(PROTOCOL_TYPE_CONTROL, payload, (uint16_t)(5 + (seq + built) % 20),
+                                                   frames[built], PROTOCOL_MAX_FRAME_LEN);
+        }
+        uint32_t sent = 0;
+        while (sent < built)
+        {
+            const uint32_t n = MpmcRing_EnqueueBatch(ctx->ring, ptrs + sent, lens + sent, built - sent);
+            if (n == 0)
+            {
+                sched_yield();
+            }
+            sent += n;
+        }
+        seq += built;
+    }
+    atomic_fetch_add(&mpmc_producers_done, 1);
+    return NULL;
+}
+
+static void mpmc_check_frame(mpmc_test_ctx_t* ctx, const uint8_t* frame, const uint16_t len)
+{
+    const uint8_t producer = frame[PROTOCOL_HEADER_SIZE];
+    const uint32_t seq = pkt_load_le32(frame + PROTOCOL_HEADER_SIZE + 1);
+    if (producer >= MPMC_TEST_PRODUCERS || len != PROTOCOL_HEADER_SIZE + 5 + seq % 20 + PROTOCOL_TRAILER_SIZE)
+    {
+        ctx->errors++;
+        return;
+    }
+    // 同一消费者看到的同一生产者的帧保持入队顺序
+    if (ctx->received[producer] > 0 && seq <= ctx->last_seq[producer])
+    {
+        ctx->errors++;
+    }
+    ctx->last_seq[producer] = seq;
+    ctx->received[producer]++;
+}
+
+static void* mpmc_consumer(void* arg)
+{
+    mpmc_test_ctx_t* ctx = arg;
+    uint8_t out[8 * PROTOCOL_MAX_FRAME_LEN];
+    uint16_t lens[8];
+    for (;;)
+    {
+        const int done = atomic_load(&mpmc_producers_done);
+        uint32_t n;
+        if (ctx->id & 1)
+        {
+            n = MpmcRing_DequeueBatch(ctx->ring, out, sizeof(out), lens, 8);
+        }
+        else
+        {
+            n = MpmcRing_Dequeue(ctx->ring, out, lens) ? 1 : 0;
+        }
+        size_t offset = 0;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            mpmc_check_frame(ctx, out + offset, lens[i]);
+            offset += lens[i];
+        }
+        if (n == 0 && done == MPMC_TEST_PRODUCERS)
+        {
+            break;
+        }
+        if (n == 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_mpmc_ring_concurrent(void)
+{
+    MpmcRing_t ring;
+    TEST_ASSERT_TRUE(MpmcRing_Init(&ring, 100, PROTOCOL_MAX_FRAME_LEN));
+    TEST_ASSERT_EQUAL(128, ring.capacity);
+
+    // 单线程：满、空、过长帧与批量截断
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN + 1] = {0};
+    uint16_t len;
+    TEST_ASSERT_FALSE(MpmcRing_Dequeue(&ring, frame, &len));
+    TEST_ASSERT_FALSE(MpmcRing_Enqueue(&ring, frame, PROTOCOL_MAX_FRAME_LEN + 1));
+    for (uint32_t i = 0; i < ring.capacity; i++)
+    {
+        frame[0] = (uint8_t)i;
+        TEST_ASSERT_TRUE(MpmcRing_Enqueue(&ring, frame, (uint16_t)(1 + i % 50)));
+    }
+    TEST_ASSERT_FALSE(MpmcRing_Enqueue(&ring, frame, 1));
+    TEST_ASSERT_EQUAL(128, MpmcRing_GetCount(&ring));
+    uint8_t out[4 * PROTOCOL_MAX_FRAME_LEN];
+    uint16_t lens[4];
+    TEST_ASSERT_EQUAL(4, MpmcRing_DequeueBatch(&ring, out, sizeof(out), lens, 10));
+    TEST_ASSERT_EQUAL(1 + 2 + 3 + 4, lens[0] + lens[1] + lens[2] + lens[3]);
+    TEST_ASSERT_EQUAL(1, out[lens[0]]);
+    const uint8_t* ptrs[6] = {frame, frame, frame, frame, frame, frame};
+    const uint16_t batch_lens[6] = {10, 10, 10, 10, 10, 10};
+    TEST_ASSERT_EQUAL(4, MpmcRing_EnqueueBatch(&ring, ptrs, batch_lens, 6));
+    while (MpmcRing_Dequeue(&ring, frame, &len))
+    {
+    }
+    TEST_ASSERT_EQUAL(0, MpmcRing_GetCount(&ring));
+
+    // 多生产者多消费者
+    atomic_store(&mpmc_producers_done, 0);
+    mpmc_test_ctx_t producers[MPMC_TEST_PRODUCERS];
+    mpmc_test_ctx_t consumers[MPMC_TEST_CONSUMERS];
+    pthread_t threads[MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS];
+    memset(producers, 0, sizeof(producers));
+    memset(consumers, 0, sizeof(consumers));
+    for (int i = 0; i < MPMC_TEST_CONSUMERS; i++)
+    {
+        consumers[i].ring = &ring;
+        consumers[i].id = (uint8_t)i;
+        pthread_create(&threads[MPMC_TEST_PRODUCERS + i], NULL, mpmc_consumer, &consumers[i]);
+    }
+    for (int i = 0; i < MPMC_TEST_PRODUCERS; i++)
+    {
+        producers[i].ring = &ring;
+        producers[i].id = (uint8_t)i;
+        pthread_create(&threads[i], NULL, mpmc_producer, &producers[i]);
+    }
+    for (int i = 0; i < MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    for (int p = 0; p < MPMC_TEST_PRODUCERS; p++)
+    {
+        uint32_t total = 0;
+        for (int c = 0; c < MPMC_TEST_CONSUMERS; c++)
+        {
+            TEST_ASSERT_EQUAL(0, consumers[c].errors);
+            total += consumers[c].received[p];
+        }
+        TEST_ASSERT_EQUAL(MPMC_TEST_FRAMES, total);
+    }
+    MpmcRing_Free(&ring);
+}
+
+#define RECORD_TEST_FRAMES 5000
+
+typedef struct
+{
+    RecordRing_t* ring;
+    uint32_t received;
+    int errors;
+} record_test_ctx_t;
+
+// 解析线程：帧直接组装进记录环（类型 + 负载），不分配内存
+static void record_ring_handler(void* user, const uint8_t type, const uint8_t* data, const uint16_t len,
+                                const protocol_frame_times_t* times)
+{
+    (void)times;
+    RecordRing_t* ring = user;
+    uint8_t* dst;
+    while ((dst = RecordRing_Reserve(ring, 1u + len)) == NULL)
+    {
+        sched_yield();
+    }
+    dst[0] = type;
+    memcpy(dst + 1, data, len);
+    RecordRing_Commit(ring, 1u + len);
+}
+
+static void* record_ring_consumer(void* arg)
+{
+    record_test_ctx_t* ctx = arg;
+    while (ctx->received < RECORD_TEST_FRAMES)
+    {
+        uint32_t len;
+        const uint8_t* rec = RecordRing_Peek(ctx->ring, &len);
+        if (rec == NULL)
+        {
+            sched_yield();
+            continue;
+        }
+        if (rec[0] != PROTOCOL_TYPE_SENSOR || len != 1 + 4 + ctx->received % 90 ||
+            pkt_load_le32(rec + 1) != ctx->received)
+        {
+            ctx->errors++;
+        }
+        ctx->received++;
+        RecordRing_Release(ctx->ring);
+    }
+    return NULL;
+}
+
+void test_record_ring_handoff(void)
+{
+    RecordRing_t ring;
+    TEST_ASSERT_TRUE(RecordRing_Init(&ring, 250));
+    TEST_ASSERT_EQUAL(256, ring.capacity);
+    TEST_ASSERT_EQUAL(120, ring.maxRecord);
+    TEST_ASSERT_NULL(RecordRing_Reserve(&ring, 121));
+
+    // 预留后按实际长度提交，放弃的预留不可见
+    uint8_t* dst = RecordRing_Reserve(&ring, 100);
+    TEST_ASSERT_NOT_NULL(dst);
+    memset(dst, 0xAB, 10);
+    RecordRing_Commit(&ring, 10);
+    TEST_ASSERT_EQUAL(24, RecordRing_GetUsedSpace(&ring));
+    TEST_ASSERT_NOT_NULL(RecordRing_Reserve(&ring, 50));
+    RecordRing_Abort(&ring);
+    TEST_ASSERT_EQUAL(24, RecordRing_GetUsedSpace(&ring));
+
+    // 写满到尾部，下一条记录放不下时填充并绕回开头，记录保持连续
+    uint8_t data[120];
+    memset(data, 0x11, sizeof(data));
+    TEST_ASSERT_TRUE(RecordRing_Write(&ring, data, 100)); // 24..136
+    TEST_ASSERT_TRUE(RecordRing_Write(&ring, data, 80)); // 136..224
+    TEST_ASSERT_FALSE(RecordRing_Write(&ring, data, 40)); // 尾部只剩 32 字节，开头被占用
+    uint32_t len;
+    TEST_ASSERT_NOT_NULL(RecordRing_Peek(&ring, &len));
+    TEST_ASSERT_EQUAL(10, len);
+    RecordRing_Release(&ring);
+    memset(data, 0x22, sizeof(data));
+    TEST_ASSERT_TRUE(RecordRing_Write(&ring, data, 12)); // 224..248
+    TEST_ASSERT_TRUE(RecordRing_Write(&ring, data, 16)); // 填充 248..256，记录 0..24
+    TEST_ASSERT_EQUAL(256, RecordRing_GetUsedSpace(&ring));
+    const uint32_t expect_len[] = {100, 80, 12, 16};
+    for (int i = 0; i < 4; i++)
+    {
+        const uint8_t* rec = RecordRing_Peek(&ring, &len);
+        TEST_ASSERT_NOT_NULL(rec);
+        TEST_ASSERT_EQUAL(expect_len[i], len);
+        TEST_ASSERT_EQUAL(i < 2 ? 0x11 : 0x22, rec[len - 1]);
+        RecordRing_Release(&ring);
+    }
+    TEST_ASSERT_TRUE(RecordRing_IsEmpty(&ring));
+    TEST_ASSERT_NULL(RecordRing_Peek(&ring, &len));
+    RecordRing_Free(&ring);
+
+    // 不经 Peek 直接 Release：队首的填充记录同样被跳过
+    TEST_ASSERT_TRUE(RecordRing_Init(&ring, 256));
+    TEST_ASSERT_TRUE(RecordRing_Write(&ring, data, 100)); // 0..112
+    TEST_ASSERT_TRUE(RecordRing_Write(&ring, data, 100)); // 112..224
+    RecordRing_Release(&ring);
+    TEST_ASSERT_TRUE(RecordRing_Write(&ring, data, 40)); // 填充 224..256，记录 256..304
+    RecordRing_Release(&ring);
+    RecordRing_Release(&ring);
+    TEST_ASSERT_TRUE(RecordRing_IsEmpty(&ring));
+    TEST_ASSERT_EQUAL(0, RecordRing_GetUsedSpace(&ring));
+
+    // 空记录与普通记录一样可见
+    TEST_ASSERT_TRUE(RecordRing_Write(&ring, data, 0));
+    TEST_ASSERT_EQUAL(RECORD_RING_HEADER_SIZE, RecordRing_GetUsedSpace(&ring));
+    TEST_ASSERT_NOT_NULL(RecordRing_Peek(&ring, &len));
+    TEST_ASSERT_EQUAL(0, len);
+    RecordRing_Release(&ring);
+    TEST_ASSERT_TRUE(RecordRing_IsEmpty(&ring));
+    RecordRing_Free(&ring);
+
+    // 解析线程到处理线程的交接
+    TEST_ASSERT_TRUE(RecordRing_Init(&ring, 1024));
+    protocol_receiver_set_handler(&receiver, record_ring_handler, &ring);
+    record_test_ctx_t ctx = {&ring, 0, 0};
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, record_ring_consumer, &ctx);
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN] = {0};
+    for (uint32_t i = 0; i < RECORD_TEST_FRAMES; i++)
+    {
+        pkt_store_le32(payload, i);
+        const uint16_t n = protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, (uint16_t)(4 + i % 90), frame,
+                                                    sizeof(frame));
+        protocol_receiver_append(&receiver, frame, n);
+    }
+    pthread_join(consumer, NULL);
+    TEST_ASSERT_EQUAL(RECORD_TEST_FRAMES, ctx.received);
+    TEST_ASSERT_EQUAL(0, ctx.errors);
+    TEST_ASSERT_TRUE(RecordRing_IsEmpty(&ring));
+    RecordRing_Free(&ring);
+}
+
+void test_mirror_ring_wrap(void)
+{
+    MirrorRing_t ring;
+    TEST_ASSERT_TRUE(MirrorRing_Init(&ring, 1000, true));
+    TEST_ASSERT_TRUE(ring.capacity >= 1000);
+    const size_t cap = ring.capacity;
+
+    // 两份映射指向同一块内存
+    ring.buffer[0] = 0x5A;
+    TEST_ASSERT_EQUAL_HEX8(0x5A, ring.buffer[cap]);
+    ring.buffer[2 * cap - 1] = 0xA5;
+    TEST_ASSERT_EQUAL_HEX8(0xA5, ring.buffer[cap - 1]);
+
+    // 写读位置移到绕回点前 50 字节，之后的帧跨越绕回点
+    uint8_t filler[256];
+    memset(filler, 0, sizeof(filler));
+    for (size_t left = cap - 50; left > 0;)
+    {
+        const size_t n = left < sizeof(filler) ? left : sizeof(filler);
+        TEST_ASSERT_TRUE(MirrorRing_Write(&ring, filler, n));
+        TEST_ASSERT_EQUAL(n, MirrorRing_Read(&ring, filler, n));
+        left -= n;
+    }
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    for (int i = 0; i < PROTOCOL_MAX_DATA_LEN; i++)
+    {
+        payload[i] = (uint8_t)i;
+    }
+    const uint16_t n = protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, sizeof(payload), frame, sizeof(frame));
+    TEST_ASSERT_TRUE(MirrorRing_Write(&ring, frame, n));
+    TEST_ASSERT_FALSE(MirrorRing_Write(&ring, filler, cap));
+
+    // 跨越绕回点的帧在虚拟地址上连续，可直接在环内解析
+    size_t avail;
+    const uint8_t* span = MirrorRing_ReadPtr(&ring, &avail);
+    TEST_ASSERT_EQUAL(n, avail);
+    TEST_ASSERT_EQUAL_MEMORY(frame, span, n);
+    protocol_parser_t parser;
+    protocol_parser_init(&parser);
+    int frames = 0;
+    for (size_t i = 0; i < avail; i++)
+    {
+        if (protocol_parse_byte(&parser, span[i]))
+        {
+            TEST_ASSERT_EQUAL_MEMORY(payload, parser.frame.data, parser.frame.len);
+            protocol_parser_reset(&parser);
+            frames++;
+        }
+    }
+    TEST_ASSERT_EQUAL(1, frames);
+    MirrorRing_Consume(&ring, avail);
+    TEST_ASSERT_EQUAL(0, MirrorRing_GetUsedSpace(&ring));
+
+    // 零拷贝写入区域同样连续
+    uint8_t* dst = MirrorRing_WritePtr(&ring, &avail);
+    TEST_ASSERT_EQUAL(cap, avail);
+    memset(dst, 0x77, cap);
+    MirrorRing_Produce(&ring, cap);
+    TEST_ASSERT_EQUAL(0, MirrorRing_GetFreeSpace(&ring));
+    uint8_t out[64];
+    TEST_ASSERT_EQUAL(64, MirrorRing_Read(&ring, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_HEX8(0x77, out[63]);
+    MirrorRing_Free(&ring);
+}
+
+static size_t read_pipe(const int fd, char* out, const size_t cap)
+{
+    size_t len = 0;
+    ssize_t n;
+    while (len < cap && (n = read(fd, out + len, cap - len)) > 0)
+    {
+        len += (size_t)n;
+    }
+    return len;
+}
+
+void test_flight_recorder_dump(void)
+{
+    protocol_flight_t flight;
+    TEST_ASSERT_TRUE(protocol_flight_init(&flight, 6));
+    TEST_ASSERT_EQUAL(8, flight.capacity);
+    protocol_receiver_set_flight(&receiver, &flight);
+
+    // 正常帧、CRC 错误帧、正常帧
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    const uint8_t payload[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+    const uint16_t n = protocol_pack_frame_into(PROTOCOL_TYPE_CONTROL, payload, sizeof(payload), frame, sizeof(frame));
+    protocol_receiver_append(&receiver, frame, n);
+    frame[PROTOCOL_HEADER_SIZE] ^= 0xFF;
+    protocol_receiver_append(&receiver, frame, n);
+    frame[PROTOCOL_HEADER_SIZE] ^= 0xFF;
+    protocol_receiver_append(&receiver, frame, n);
+    TEST_ASSERT_EQUAL(2, callback_triggered);
+    TEST_ASSERT_EQUAL(3, atomic_load(&flight.next));
+
+    int fds[2];
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+    TEST_ASSERT_EQUAL(3, protocol_flight_dump(&flight, fds[1], PROTOCOL_FLIGHT_DUMP_HEX));
+    close(fds[1]);
+    char text[4096];
+    const size_t text_len = read_pipe(fds[0], text, sizeof(text) - 1);
+    text[text_len] = '\0';
+    close(fds[0]);
+    TEST_ASSERT_NOT_NULL(strstr(text, "RX type=0x02 len=13: 55 AA 02 04 00 DE AD BE EF"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "CRC_ERROR type=0x02 len=13: 55 AA 02 04 00 21 AD BE EF"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\n2 "));
+
+    // 环满后只保留最近 8 条，二进制导出从旧到新
+    for (int i = 0; i < 20; i++)
+    {
+        const uint8_t b = (uint8_t)i;
+        protocol_flight_record(&flight, PROTOCOL_FLIGHT_USER, 0x7F, &b, 1);
+    }
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+    TEST_ASSERT_EQUAL(8, protocol_flight_dump(&flight, fds[1], PROTOCOL_FLIGHT_DUMP_BINARY));
+    close(fds[1]);
+    uint8_t bin[1024];
+    const size_t bin_len = read_pipe(fds[0], (char*)bin, sizeof(bin));
+    close(fds[0]);
+    TEST_ASSERT_EQUAL(PROTOCOL_FLIGHT_FILE_HEADER_LEN + 8 * (PROTOCOL_FLIGHT_ENTRY_HEADER_LEN + 1), bin_len);
+    TEST_ASSERT_EQUAL_MEMORY(PROTOCOL_FLIGHT_MAGIC, bin, 8);
+    TEST_ASSERT_EQUAL(8, pkt_load_le32(bin + 12));
+    const uint8_t* rec = bin + PROTOCOL_FLIGHT_FILE_HEADER_LEN;
+    for (int i = 0; i < 8; i++, rec += PROTOCOL_FLIGHT_ENTRY_HEADER_LEN + 1)
+    {
+        TEST_ASSERT_EQUAL(15 + i, pkt_load_le64(rec));
+        TEST_ASSERT_EQUAL(PROTOCOL_FLIGHT_USER, rec[16]);
+        TEST_ASSERT_EQUAL(12 + i, rec[PROTOCOL_FLIGHT_ENTRY_HEADER_LEN]);
+    }
+
+    // 收到信号时导出
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+    TEST_ASSERT_EQUAL(0, protocol_flight_install_signal(&flight, SIGUSR1, fds[1], PROTOCOL_FLIGHT_DUMP_HEX));
+    raise(SIGUSR1);
+    close(fds[1]);
+    const size_t sig_len = read_pipe(fds[0], text, sizeof(text) - 1);
+    text[sig_len] = '\0';
+    close(fds[0]);
+    TEST_ASSERT_NOT_NULL(strstr(text, "USER type=0x7F len=1: 13\n"));
+    signal(SIGUSR1, SIG_DFL);
+
+    protocol_receiver_set_flight(&receiver, NULL);
+    protocol_flight_destroy(&flight);
+}
+
+static int diag_sink_events;
+static protocol_diag_event_t diag_last_event;
+
+static void diag_test_sink(void* user, const protocol_diag_event_t* event)
+{
+    (void)user;
+    diag_sink_events++;
+    diag_last_event = *event;
+}
+
+void test_diag_rate_limited_channel(void)
+{
+    protocol_diag_reset_stats();
+    TEST_ASSERT_TRUE(protocol_diag_init(64, 4, 50));
+    protocol_diag_set_sink(diag_test_sink, NULL);
+    diag_sink_events = 0;
+
+    // 错误风暴：全部计数，只有 burst 条排队，不做任何 I/O
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN + 1] = {0};
+    uint16_t frame_len;
+    for (int i = 0; i < 10000; i++)
+    {
+        TEST_ASSERT_NULL(protocol_pack_frame(PROTOCOL_TYPE_SENSOR, payload, sizeof(payload), &frame_len));
+    }
+    protocol_diag_stats_t stats;
+    protocol_diag_get_stats(&stats);
+    TEST_ASSERT_EQUAL(10000, stats.counts[PROTOCOL_DIAG_PACK_TOO_LONG]);
+    TEST_ASSERT_EQUAL(10000 - 4, stats.suppressed);
+    TEST_ASSERT_EQUAL(0, diag_sink_events);
+
+    // 由调用方取出并格式化
+    TEST_ASSERT_EQUAL(4, protocol_diag_drain());
+    TEST_ASSERT_EQUAL(4, diag_sink_events);
+    TEST_ASSERT_EQUAL(PROTOCOL_DIAG_PACK_TOO_LONG, diag_last_event.code);
+    TEST_ASSERT_EQUAL(PROTOCOL_MAX_DATA_LEN + 1, diag_last_event.arg);
+
+    // 下一个窗口的第一条事件带上被限速的条数，由后台线程输出
+    const struct timespec window = {0, 60 * 1000000L};
+    nanosleep(&window, NULL);
+    TEST_ASSERT_TRUE(protocol_diag_start(5));
+    protocol_diag_report(PROTOCOL_DIAG_RX_DISCARDED, 7);
+    protocol_diag_report(PROTOCOL_DIAG_PACK_TOO_LONG, 200);
+    protocol_diag_stop();
+    TEST_ASSERT_EQUAL(6, diag_sink_events);
+    TEST_ASSERT_EQUAL(10000 - 4, diag_last_event.suppressed);
+    char line[160];
+    protocol_diag_format(&diag_last_event, line, sizeof(line));
+    TEST_ASSERT_NOT_NULL(strstr(line, "pack: data length too long (200), 9996 similar suppressed"));
+
+    protocol_diag_get_stats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.counts[PROTOCOL_DIAG_RX_DISCARDED]);
+    TEST_ASSERT_EQUAL(6, stats.delivered);
+    TEST_ASSERT_EQUAL(0, stats.queue_dropped);
+
+    // 无效类型与负载过长分别上报
+    protocol_compressor_t compressor;
+    protocol_compressor_init(&compressor);
+    TEST_ASSERT_NULL(protocol_pack_frame_compressed(&compressor, PROTOCOL_TYPE_MAX, payload, 1, &frame_len));
+    protocol_diag_get_stats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.counts[PROTOCOL_DIAG_PACK_BAD_TYPE]);
+    TEST_ASSERT_EQUAL(10001, stats.counts[PROTOCOL_DIAG_PACK_TOO_LONG]);
+    protocol_diag_shutdown();
+
+    // 关闭后只计数；队列保留，再次初始化沿用原队列
+    protocol_diag_report(PROTOCOL_DIAG_TXQ_REJECTED, 1);
+    TEST_ASSERT_EQUAL(0, protocol_diag_drain());
+    TEST_ASSERT_TRUE(protocol_diag_init(64, 4, 50));
+    protocol_diag_report(PROTOCOL_DIAG_TXQ_REJECTED, 2);
+    TEST_ASSERT_EQUAL(1, protocol_diag_drain());
+    protocol_diag_shutdown();
+    protocol_diag_reset_stats();
+}
+
+void test_crc16_multi_buffer(void)
+{
+    // 长度各异（含空缓冲区）的随机数据，与逐个 crc16_ccitt 一致
+    enum { BUFFERS = 1000 };
+    uint8_t* pool = malloc(BUFFERS * 300);
+    const uint8_t* data[BUFFERS];
+    size_t lens[BUFFERS];
+    uint16_t crcs[BUFFERS];
+    uint32_t seed = 12345;
+    for (int i = 0; i < BUFFERS; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        lens[i] = (seed >> 16) % 300;
+        data[i] = pool + i * 300;
+        for (size_t j = 0; j < lens[i]; j++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            pool[i * 300 + j] = (uint8_t)(seed >> 16);
+        }
+    }
+    lens[7] = 0;
+    protocol_crc16_multi(data, lens, crcs, BUFFERS);
+    for (int i = 0; i < BUFFERS; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX16(crc16_ccitt(data[i], (uint16_t)lens[i]), crcs[i]);
+        TEST_ASSERT_EQUAL_HEX16(crcs[i], protocol_crc16_update(0xFFFF, data[i], lens[i]));
+    }
+    // 少于通道数
+    protocol_crc16_multi(data, lens, crcs, 3);
+    TEST_ASSERT_EQUAL_HEX16(crc16_ccitt(data[2], (uint16_t)lens[2]), crcs[2]);
+    free(pool);
+
+    // 校验线上帧：每 7 帧损坏一帧
+    enum { FRAMES = 3000 };
+    uint8_t* wire = malloc(FRAMES * PROTOCOL_MAX_FRAME_LEN);
+    const uint8_t* frames[FRAMES];
+    size_t frame_lens[FRAMES];
+    uint8_t ok[FRAMES];
+    uint8_t ok_mt[FRAMES];
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    size_t expect = 0;
+    for (int i = 0; i < FRAMES; i++)
+    {
+        memset(payload, i, sizeof(payload));
+        uint8_t* f = wire + i * PROTOCOL_MAX_FRAME_LEN;
+        frames[i] = f;
+        frame_lens[i] = protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, (uint16_t)(i % (PROTOCOL_MAX_DATA_LEN + 1)),
+                                                 f, PROTOCOL_MAX_FRAME_LEN);
+        if (i % 7 == 3)
+        {
+            f[PROTOCOL_OFFSET_TYPE] ^= 0x01;
+        }
+        else
+        {
+            expect++;
+        }
+    }
+    frame_lens[12] = 3; // 不完整的帧
+    expect--;
+    TEST_ASSERT_EQUAL(expect, protocol_crc16_verify_frames(frames, frame_lens, ok, FRAMES));
+    TEST_ASSERT_EQUAL(expect, protocol_crc16_verify_frames_mt(frames, frame_lens, ok_mt, FRAMES, 4));
+    TEST_ASSERT_EQUAL_MEMORY(ok, ok_mt, FRAMES);
+    TEST_ASSERT_EQUAL(0, ok[3]);
+    TEST_ASSERT_EQUAL(0, ok[12]);
+    TEST_ASSERT_EQUAL(1, ok[11]);
+    free(wire);
+}
+
+void test_receiver_pull_frames(void)
+{
+    protocol_compressor_t compressor;
+    protocol_compressor_init(&compressor);
+    protocol_receiver_set_compressor(&receiver, &compressor);
+    protocol_receiver_set_pull(&receiver, true);
+
+    // 噪声 + 5 个帧（第 4 个为压缩帧）+ 半个帧，追加时不回调
+    uint8_t wire[1024];
+    size_t wire_len = 0;
+    const uint8_t noise[] = {0x00, 0x55, 0x13};
+    memcpy(wire, noise, sizeof(noise));
+    wire_len += sizeof(noise);
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    for (int i = 0; i < 5; i++)
+    {
+        if (i == 3)
+        {
+            char log[200];
+            memset(log, 'x', sizeof(log));
+            uint16_t frame_len;
+            uint8_t* frame = protocol_pack_frame_compressed(&compressor, PROTOCOL_TYPE_LOG, (const uint8_t*)log,
+                                                            sizeof(log), &frame_len);
+            memcpy(wire + wire_len, frame, frame_len);
+            wire_len += frame_len;
+            protocol_free(frame);
+            continue;
+        }
+        memset(payload, i, sizeof(payload));
+        wire_len += protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, (uint16_t)(10 + i), wire + wire_len,
+                                             sizeof(wire) - wire_len);
+    }
+    const size_t tail_len = protocol_pack_frame_into(PROTOCOL_TYPE_CONTROL, payload, 4, wire + wire_len,
+                                                     sizeof(wire) - wire_len);
+    protocol_receiver_append(&receiver, wire, wire_len + 6);
+    TEST_ASSERT_EQUAL(0, callback_triggered);
+
+    // 单帧拉取：负载直接指向接收器缓冲区
+    protocol_frame_view_t views[8];
+    TEST_ASSERT_TRUE(protocol_receiver_next_frame(&receiver, &views[0]));
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_SENSOR, views[0].type);
+    TEST_ASSERT_EQUAL(10, views[0].len);
+    TEST_ASSERT_TRUE(views[0].data >= receiver.buffer && views[0].data < receiver.buffer + receiver.buffer_size);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0, views[0].data, 10);
+
+    // 成批拉取：解压后的帧结束本批次
+    TEST_ASSERT_EQUAL(3, protocol_receiver_next_frames(&receiver, views, 8));
+    TEST_ASSERT_EQUAL(11, views[0].len);
+    TEST_ASSERT_EACH_EQUAL_UINT8(1, views[0].data, 11);
+    TEST_ASSERT_EACH_EQUAL_UINT8(2, views[1].data, 12);
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_LOG, views[2].type);
+    TEST_ASSERT_EQUAL(200, views[2].len);
+    TEST_ASSERT_EACH_EQUAL_UINT8('x', views[2].data, 200);
+
+    TEST_ASSERT_EQUAL(1, protocol_receiver_next_frames(&receiver, views, 8));
+    TEST_ASSERT_EACH_EQUAL_UINT8(4, views[0].data, 14);
+    TEST_ASSERT_FALSE(protocol_receiver_next_frame(&receiver, &views[0]));
+
+    // 补齐半帧后可以继续拉取
+    protocol_receiver_append(&receiver, wire + wire_len + 6, tail_len - 6);
+    TEST_ASSERT_TRUE(protocol_receiver_next_frame(&receiver, &views[0]));
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_CONTROL, views[0].type);
+    TEST_ASSERT_EQUAL(4, views[0].len);
+    TEST_ASSERT_EQUAL(0, protocol_receiver_next_frames(&receiver, views, 8));
+    TEST_ASSERT_EQUAL(6, receiver.parser.stats.frames);
+
+    // 关闭拉取模式后恢复回调
+    protocol_receiver_set_pull(&receiver, false);
+    protocol_receiver_append(&receiver, wire + sizeof(noise), wire_len - sizeof(noise));
+    TEST_ASSERT_EQUAL(5, callback_triggered);
+}
+
+void test_parallel_decode_matches_sequential(void)
+{
+    // 帧、噪声、错位帧头、CRC 错误、长度越界和帧尾错误混杂，结尾是半个帧
+    enum { STREAM_CAP = 400 * 1024 };
+    uint8_t* stream = malloc(STREAM_CAP);
+    size_t len = 0;
+    uint32_t seed = 2024;
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    while (len + 2 * PROTOCOL_MAX_FRAME_LEN < STREAM_CAP)
+    {
+        seed = seed * 1103515245u + 12345u;
+        const uint32_t r = seed >> 8;
+        uint8_t* at = stream + len;
+        switch (r % 8)
+        {
+        case 0:
+            // 噪声，偶尔含 0x55 0xAA 或长度越界的帧头
+            for (uint32_t i = 0; i < 1 + (r >> 4) % 40; i++)
+            {
+                at[i] = (uint8_t)(r >> (i % 24));
+            }
+            at[0] = 0x55;
+            at[1] = (r & 0x100) ? 0xAA : 0x55;
+            len += 1 + (r >> 4) % 40 + 1;
+            break;
+        case 1:
+            len += protocol_pack_frame_into(PROTOCOL_TYPE_LOG, payload, (uint16_t)(r % 50), at, PROTOCOL_MAX_FRAME_LEN);
+            at[5 + r % 50] ^= 0x5A; // CRC 错误
+            break;
+        case 2:
+            len += protocol_pack_frame_into(PROTOCOL_TYPE_CONTROL, payload, (uint16_t)(r % 30), at,
+                                            PROTOCOL_MAX_FRAME_LEN);
+            stream[len - 1] = 0x00; // 帧尾错误
+            break;
+        default:
+            memset(payload, (int)r, sizeof(payload));
+            len += protocol_pack_frame_into((uint8_t)(1 + r % 5), payload, (uint16_t)(r % (PROTOCOL_MAX_DATA_LEN + 1)),
+                                            at, PROTOCOL_MAX_FRAME_LEN);
+            break;
+        }
+    }
+    len += protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, payload, 40, stream + len, PROTOCOL_MAX_FRAME_LEN) - 10;
+
+    // 顺序解析作为参照
+    protocol_parser_t parser;
+    protocol_parser_init(&parser);
+    uint64_t offsets[8192];
+    uint64_t expect_types[256] = {0};
+    size_t expect_frames = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (protocol_parse_byte(&parser, stream[i]))
+        {
+            TEST_ASSERT_TRUE(expect_frames < 8192);
+            offsets[expect_frames++] = i + 1 - (PROTOCOL_HEADER_SIZE + parser.frame.len + PROTOCOL_TRAILER_SIZE);
+            expect_types[parser.frame.type]++;
+            protocol_parser_reset(&parser);
+        }
+    }
+    TEST_ASSERT_TRUE(parser.stats.crc_errors > 0);
+    TEST_ASSERT_TRUE(parser.stats.format_errors > 0);
+
+    // 小块、多线程，帧必然跨越块边界
+    const protocol_decode_options_t opts = {4, PROTOCOL_DECODE_MIN_CHUNK, true};
+    protocol_decode_result_t result;
+    TEST_ASSERT_TRUE(protocol_decode_buffer(stream, len, &opts, &result));
+    TEST_ASSERT_EQUAL(parser.stats.frames, result.frames);
+    TEST_ASSERT_EQUAL(parser.stats.crc_errors, result.crc_errors);
+    TEST_ASSERT_EQUAL(parser.stats.format_errors, result.format_errors);
+    TEST_ASSERT_EQUAL(PROTOCOL_HEADER_SIZE + 40 + PROTOCOL_TRAILER_SIZE - 10, result.incomplete_bytes);
+    TEST_ASSERT_EQUAL_MEMORY(expect_types, result.type_counts, sizeof(expect_types));
+    TEST_ASSERT_EQUAL(expect_frames, result.frame_count);
+    for (size_t i = 0; i < expect_frames; i++)
+    {
+        TEST_ASSERT_EQUAL(offsets[i], result.frame_list[i].offset);
+    }
+    const protocol_decoded_frame_t* last = &result.frame_list[result.frame_count - 1];
+    TEST_ASSERT_EQUAL_MEMORY(stream + last->offset + PROTOCOL_HEADER_SIZE, protocol_decode_frame_data(&result, last),
+                             last->len);
+    protocol_decode_result_free(&result);
+
+    // 映射文件，只统计
+    const char* path = "pkt_decode_test.bin";
+    FILE* file = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL(len, fwrite(stream, 1, len, file));
+    fclose(file);
+    const protocol_decode_options_t stats_only = {0, PROTOCOL_DECODE_MIN_CHUNK * 3, false};
+    TEST_ASSERT_TRUE(protocol_decode_file(path, &stats_only, &result));
+    TEST_ASSERT_EQUAL(parser.stats.frames, result.frames);
+    TEST_ASSERT_EQUAL(parser.stats.crc_errors, result.crc_errors);
+    TEST_ASSERT_EQUAL(parser.stats.format_errors, result.format_errors);
+    TEST_ASSERT_NULL(result.frame_list);
+    protocol_decode_result_free(&result);
+    unlink(path);
+    protocol_parser_reset(&parser);
+    free(stream);
+}
+
+void test_crc32c_frames(void)
+{
+    // 标准测试向量，硬件与软件实现一致，可分段计算
+    const uint8_t check[] = "123456789";
+    TEST_ASSERT_EQUAL_HEX32(0xE3069283, protocol_crc32c(0, check, 9));
+    TEST_ASSERT_EQUAL_HEX32(0xE3069283, protocol_crc32c_sw(0, check, 9));
+    TEST_ASSERT_EQUAL_HEX32(0xE3069283, protocol_crc32c(protocol_crc32c(0, check, 4), check + 4, 5));
+    uint8_t buf[301];
+    for (size_t i = 0; i < sizeof(buf); i++)
+    {
+        buf[i] = (uint8_t)(i * 37 + 5);
+    }
+    for (size_t n = 0; n <= sizeof(buf); n += 7)
+    {
+        TEST_ASSERT_EQUAL_HEX32(protocol_crc32c_sw(0, buf, n), protocol_crc32c(0, buf, n));
+    }
+
+    // CRC32C 帧比 CRC16 帧长 2 字节，最大负载仍能放进 PROTOCOL_MAX_FRAME_LEN
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    memset(payload, 0x3C, sizeof(payload));
+    uint8_t stream[4 * PROTOCOL_MAX_FRAME_LEN];
+    const uint8_t type = PROTOCOL_TYPE_SENSOR | PROTOCOL_TYPE_FLAG_CRC32C;
+    size_t len = protocol_pack_frame_into(type, payload, sizeof(payload), stream, PROTOCOL_MAX_FRAME_LEN);
+    TEST_ASSERT_EQUAL(PROTOCOL_MAX_FRAME_LEN, len);
+    TEST_ASSERT_EQUAL_HEX32(protocol_crc32c(0, stream, PROTOCOL_HEADER_SIZE + sizeof(payload)),
+                            pkt_load_le32(stream + PROTOCOL_HEADER_SIZE + sizeof(payload)));
+    len += protocol_pack_frame_into(PROTOCOL_TYPE_CONTROL, payload, 3, stream + len, PROTOCOL_MAX_FRAME_LEN);
+    const size_t empty_len = protocol_pack_frame_into(PROTOCOL_TYPE_ACK | PROTOCOL_TYPE_FLAG_CRC32C, payload, 0,
+                                                      stream + len, PROTOCOL_MAX_FRAME_LEN);
+    TEST_ASSERT_EQUAL(PROTOCOL_HEADER_SIZE + PROTOCOL_CRC32C_TRAILER_SIZE, empty_len);
+    len += empty_len;
+
+    // 接收器同时接受两种帧尾，交给上层的类型不含 CRC32C 标志
+    receiver.callback = capture_callback;
+    protocol_receiver_append(&receiver, stream, 50);
+    protocol_receiver_append(&receiver, stream + 50, len - 50);
+    TEST_ASSERT_EQUAL(3, callback_triggered);
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_ACK, last_type);
+    TEST_ASSERT_EQUAL(0, last_len);
+    TEST_ASSERT_EQUAL(0, receiver.parser.stats.crc_errors);
+
+    // 篡改负载后按 CRC32C 校验失败
+    stream[PROTOCOL_HEADER_SIZE + 10] ^= 0x10;
+    protocol_receiver_append(&receiver, stream, len);
+    TEST_ASSERT_EQUAL(5, callback_triggered);
+    TEST_ASSERT_EQUAL(1, receiver.parser.stats.crc_errors);
+
+    // 批量校验与并行解码也按类型字节选择 CRC
+    const uint8_t* frames[3] = {stream, stream + PROTOCOL_MAX_FRAME_LEN, stream + PROTOCOL_MAX_FRAME_LEN + 12};
+    const size_t lens[3] = {PROTOCOL_MAX_FRAME_LEN, 12, empty_len};
+    uint8_t ok[3];
+    TEST_ASSERT_EQUAL(2, protocol_crc16_verify_frames(frames, lens, ok, 3));
+    TEST_ASSERT_EQUAL(0, ok[0]);
+    protocol_decode_result_t result;
+    TEST_ASSERT_TRUE(protocol_decode_buffer(stream, len, NULL, &result));
+    TEST_ASSERT_EQUAL(2, result.frames);
+    TEST_ASSERT_EQUAL(1, result.crc_errors);
+    TEST_ASSERT_EQUAL(1, result.type_counts[PROTOCOL_TYPE_ACK | PROTOCOL_TYPE_FLAG_CRC32C]);
+    protocol_decode_result_free(&result);
+}
+
+void test_shm_broadcast(void)
+{
+    // 跨进程：子进程按名字订阅，父进程发布
+    char name[64];
+    snprintf(name, sizeof(name), "/spkt_test_%d", (int)getpid());
+    protocol_shm_pub_t pub;
+    TEST_ASSERT_TRUE(protocol_shm_create(&pub, name, 100));
+    TEST_ASSERT_EQUAL(127, pub.mask);
+    int ready[2];
+    TEST_ASSERT_EQUAL(0, pipe(ready));
+    const pid_t pid = fork();
+    TEST_ASSERT_TRUE(pid >= 0);
+    if (pid == 0)
+    {
+        protocol_shm_sub_t sub;
+        const bool opened = protocol_shm_open(&sub, name);
+        const char c = opened ? 'y' : 'n';
+        if (write(ready[1], &c, 1) != 1 || !opened)
+        {
+            _exit(1);
+        }
+        callback_triggered = 0;
+        int rounds = 0;
+        while (callback_triggered < 50 && rounds++ < 1000)
+        {
+            protocol_shm_wait(&sub, 100);
+            protocol_shm_poll(&sub, capture_callback, SIZE_MAX);
+        }
+        // 最后一帧：类型与内容都对得上，且没有丢帧
+        const bool ok = callback_triggered == 50 && sub.lost == 0 && sub.torn == 0 &&
+            last_type == PROTOCOL_TYPE_SENSOR && last_len == 49 && last_data[0] == 49 && last_data[48] == 49;
+        protocol_shm_close(&sub);
+        _exit(ok ? 0 : 2);
+    }
+    char c = 0;
+    TEST_ASSERT_EQUAL(1, read(ready[0], &c, 1));
+    TEST_ASSERT_EQUAL('y', c);
+    uint8_t payload[PROTOCOL_SHM_MAX_PAYLOAD];
+    for (int i = 0; i < 50; i++)
+    {
+        memset(payload, i, sizeof(payload));
+        TEST_ASSERT_TRUE(protocol_shm_publish(&pub, PROTOCOL_TYPE_SENSOR, payload, (uint16_t)i));
+        if (i % 10 == 9)
+        {
+            const struct timespec pause = {0, 1000000};
+            nanosleep(&pause, NULL);
+        }
+    }
+    int status = -1;
+    TEST_ASSERT_EQUAL(pid, waitpid(pid, &status, 0));
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL(0, WEXITSTATUS(status));
+    close(ready[0]);
+    close(ready[1]);
+    TEST_ASSERT_FALSE(protocol_shm_publish(&pub, PROTOCOL_TYPE_SENSOR, payload, PROTOCOL_SHM_MAX_PAYLOAD + 1));
+
+    // 同名重建不截断旧对象：旧订阅者的映射仍可访问，新订阅者打开的是新环
+    protocol_shm_sub_t sub;
+    TEST_ASSERT_TRUE(protocol_shm_open(&sub, name));
+    protocol_shm_pub_t again;
+    TEST_ASSERT_TRUE(protocol_shm_create(&again, name, 2));
+    callback_triggered = 0;
+    TEST_ASSERT_EQUAL(0, protocol_shm_poll(&sub, capture_callback, SIZE_MAX));
+    TEST_ASSERT_TRUE(protocol_shm_publish(&pub, PROTOCOL_TYPE_SENSOR, payload, 3));
+    TEST_ASSERT_EQUAL(1, protocol_shm_poll(&sub, capture_callback, SIZE_MAX));
+    protocol_shm_close(&sub);
+    TEST_ASSERT_TRUE(protocol_shm_open(&sub, name));
+    TEST_ASSERT_EQUAL(1, sub.mask);
+    protocol_shm_close(&sub);
+
+    // 旧发布方后退出（网关重启）：不能删除新环的名字
+    protocol_shm_destroy(&pub);
+    TEST_ASSERT_TRUE(protocol_shm_open(&sub, name));
+    TEST_ASSERT_EQUAL(1, sub.mask);
+    protocol_shm_close(&sub);
+    protocol_shm_destroy(&again);
+    TEST_ASSERT_FALSE(protocol_shm_open(&sub, name));
+
+    // 匿名 memfd：落后超过一圈的订阅者丢帧并计数
+    TEST_ASSERT_TRUE(protocol_shm_create(&pub, NULL, 4));
+    TEST_ASSERT_TRUE(protocol_shm_open_fd(&sub, pub.fd));
+    TEST_ASSERT_FALSE(protocol_shm_wait(&sub, 0));
+    for (int i = 0; i < 10; i++)
+    {
+        payload[0] = (uint8_t)i;
+        protocol_shm_publish(&pub, PROTOCOL_TYPE_CONTROL, payload, 1);
+    }
+    TEST_ASSERT_TRUE(protocol_shm_wait(&sub, 0));
+    callback_triggered = 0;
+    TEST_ASSERT_EQUAL(4, protocol_shm_poll(&sub, capture_callback, SIZE_MAX));
+    TEST_ASSERT_EQUAL(4, callback_triggered);
+    TEST_ASSERT_EQUAL(6, sub.lost);
+    TEST_ASSERT_EQUAL(9, last_data[0]);
+
+    // 挂到接收器上：收到的帧直接进入共享内存
+    uint8_t frame[PROTOCOL_MAX_FRAME_LEN];
+    const uint8_t data[] = {0xDE, 0xAD, 0xBE, 0xEF};
+    const size_t len = protocol_pack_frame_into(PROTOCOL_TYPE_SENSOR, data, sizeof(data), frame, sizeof(frame));
+    protocol_shm_attach(&pub, &receiver);
+    protocol_receiver_append(&receiver, frame, len);
+    TEST_ASSERT_EQUAL(1, protocol_shm_poll(&sub, capture_callback, SIZE_MAX));
+    TEST_ASSERT_EQUAL(PROTOCOL_TYPE_SENSOR, last_type);
+    TEST_ASSERT_EQUAL(sizeof(data), last_len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data, last_data, sizeof(data));
+    TEST_ASSERT_EQUAL(5, sub.delivered);
+    protocol_shm_close(&sub);
+    protocol_shm_destroy(&pub);
+}
+
 // --- 主函数运行所有测试 ---
 int main(void)
 {
     UNITY_BEGIN();
     // RUN_TEST(test_mqtt_topic_match);
     RUN_TEST(test_ctrl_protocol);
+    RUN_TEST(test_le_codec);
+    RUN_TEST(test_ctrl_cmd_codec);
+    RUN_TEST(test_compress_lz_roundtrip);
+    RUN_TEST(test_compress_delta16_roundtrip);
+    RUN_TEST(test_compressed_frame_receive);
+    RUN_TEST(test_fragment_reassemble);
+    RUN_TEST(test_fragment_out_of_order_timeout_and_hold);
+    RUN_TEST(test_reliable_lossy_loopback);
+    RUN_TEST(test_frame_pool_allocator);
+    RUN_TEST(test_receiver_chunked_stream);
+    RUN_TEST(test_capture_roundtrip);
+    RUN_TEST(test_serial_io_pty_fallback);
+    RUN_TEST(test_serial_io_pty_uring);
+    RUN_TEST(test_txq_writev_backpressure);
+    RUN_TEST(test_scan_header_matches_naive);
+    RUN_TEST(test_receiver_resync_after_noise);
+    RUN_TEST(test_static_parser_interop);
+    RUN_TEST(test_receiver_large_append_and_shrink);
+    RUN_TEST(test_demux_streams);
+    RUN_TEST(test_frame_timestamps_and_latency);
+    RUN_TEST(test_mpmc_ring_concurrent);
+    RUN_TEST(test_record_ring_handoff);
+    RUN_TEST(test_mirror_ring_wrap);
+    RUN_TEST(test_flight_recorder_dump);
+    RUN_TEST(test_diag_rate_limited_channel);
+    RUN_TEST(test_crc16_multi_buffer);
+    RUN_TEST(test_receiver_pull_frames);
+    RUN_TEST(test_parallel_decode_matches_sequential);
+    RUN_TEST(test_crc32c_frames);
+    RUN_TEST(test_shm_broadcast);
 
-    // RUN_TEST(test_htole16);
     // RUN_TEST(test_all_append);
     // RUN_TEST(test_partial_append);
     // RUN_TEST(test_pack_and_parse);
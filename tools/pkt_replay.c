@@ -0,0 +1,214 @@
+/*
+ * 抓包回放工具
+ *
+ * 用法: pkt_replay [-p] [-n loops] <capture>
+ *       pkt_replay -r [-t threads] <raw dump>
+ *   -p          按原始时间间隔回放（默认最大速度）
+ *   -n loops    重复回放次数（默认 1）
+ *   -r          输入为单个串口的原始字节转储，用并行解码器统计（不回放）
+ *   -t threads  并行解码线程数（默认在线 CPU 数）
+ *
+ * 每个端口使用独立的 protocol_receiver，结束后输出帧率与错误统计。
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "pkt_capture.h"
+#include "pkt_decode.h"
+#include "pkt_protocol.h"
+#include "pkt_protocol_buf.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_PORTS 256
+#define RECEIVER_BUFFER_SIZE 4096
+
+static uint64_t frames_total;
+static uint64_t payload_bytes_total;
+
+static void count_frame(uint8_t type, const uint8_t* data, uint16_t len)
+{
+    (void)type;
+    (void)data;
+    frames_total++;
+    payload_bytes_total += len;
+}
+
+static void sleep_until(const uint64_t deadline_ns)
+{
+    const uint64_t now = protocol_capture_now_ns();
+    if (deadline_ns <= now)
+    {
+        return;
+    }
+    const uint64_t delta = deadline_ns - now;
+    const struct timespec ts = {(time_t)(delta / 1000000000ull), (long)(delta % 1000000000ull)};
+    nanosleep(&ts, NULL);
+}
+
+static int decode_raw(const char* path, const unsigned threads)
+{
+    const protocol_decode_options_t opts = {threads, 0, false};
+    protocol_decode_result_t result;
+    const uint64_t start_ns = protocol_capture_now_ns();
+    if (!protocol_decode_file(path, &opts, &result))
+    {
+        fprintf(stderr, "replay: cannot decode %s\n", path);
+        return 1;
+    }
+    const double elapsed = (double)(protocol_capture_now_ns() - start_ns) / 1e9;
+
+    printf("raw bytes:     %llu\n", (unsigned long long)result.bytes);
+    printf("frames:        %llu (payload %llu bytes)\n", (unsigned long long)result.frames,
+           (unsigned long long)result.payload_bytes);
+    for (int type = 0; type < 256; type++)
+    {
+        if (result.type_counts[type])
+        {
+            printf("  type 0x%02X:   %llu\n", type, (unsigned long long)result.type_counts[type]);
+        }
+    }
+    printf("crc errors:    %llu\n", (unsigned long long)result.crc_errors);
+    printf("format errors: %llu\n", (unsigned long long)result.format_errors);
+    printf("incomplete:    %llu bytes at end\n", (unsigned long long)result.incomplete_bytes);
+    printf("elapsed:       %.3f s\n", elapsed);
+    if (elapsed > 0)
+    {
+        printf("throughput:    %.0f frames/s, %.2f MB/s\n", (double)result.frames / elapsed,
+               (double)result.bytes / elapsed / 1e6);
+    }
+    protocol_decode_result_free(&result);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    bool paced = false;
+    bool raw = false;
+    unsigned threads = 0;
+    int loops = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "pn:rt:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            paced = true;
+            break;
+        case 'n':
+            loops = atoi(optarg);
+            break;
+        case 'r':
+            raw = true;
+            break;
+        case 't':
+            threads = (unsigned)atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-p] [-n loops] <capture> | -r [-t threads] <raw dump>\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "usage: %s [-p] [-n loops] <capture> | -r [-t threads] <raw dump>\n", argv[0]);
+        return 2;
+    }
+    if (raw)
+    {
+        return decode_raw(argv[optind], threads);
+    }
+
+    protocol_capture_reader_t reader;
+    if (!protocol_capture_map(&reader, argv[optind]))
+    {
+        fprintf(stderr, "replay: cannot map capture %s\n", argv[optind]);
+        return 1;
+    }
+
+    static protocol_receiver receivers[MAX_PORTS];
+    static bool receiver_used[MAX_PORTS];
+    uint64_t records = 0;
+    uint64_t raw_bytes = 0;
+    uint64_t skipped = 0;
+    int truncated = 0;
+
+    const uint64_t start_ns = protocol_capture_now_ns();
+    for (int loop = 0; loop < loops; loop++)
+    {
+        protocol_capture_record_t record;
+        uint64_t first_ts = 0;
+        const uint64_t loop_start = protocol_capture_now_ns();
+        protocol_capture_rewind(&reader);
+        int rc;
+        while ((rc = protocol_capture_next(&reader, &record)) == 1)
+        {
+            if (paced)
+            {
+                if (first_ts == 0)
+                {
+                    first_ts = record.ts_ns;
+                }
+                sleep_until(loop_start + (record.ts_ns - first_ts));
+            }
+            // 端口号取模会把不同端口的字节流混在一个接收器里，超出范围的记录直接跳过
+            if (record.port_id >= MAX_PORTS)
+            {
+                skipped++;
+                continue;
+            }
+            const uint16_t port = record.port_id;
+            if (!receiver_used[port])
+            {
+                protocol_receiver_init(&receivers[port], RECEIVER_BUFFER_SIZE, count_frame);
+                receiver_used[port] = true;
+            }
+            protocol_receiver_append(&receivers[port], record.data, record.len);
+            records++;
+            raw_bytes += record.len;
+        }
+        if (rc < 0)
+        {
+            truncated = 1;
+        }
+    }
+    const double elapsed = (double)(protocol_capture_now_ns() - start_ns) / 1e9;
+
+    protocol_parse_stats_t errors = {0};
+    int ports = 0;
+    for (int i = 0; i < MAX_PORTS; i++)
+    {
+        if (receiver_used[i])
+        {
+            errors.crc_errors += receivers[i].parser.stats.crc_errors;
+            errors.format_errors += receivers[i].parser.stats.format_errors;
+            ports++;
+            protocol_receiver_destroy(&receivers[i]);
+        }
+    }
+    protocol_capture_unmap(&reader);
+
+    printf("records:       %llu (%d port(s)%s)\n", (unsigned long long)records, ports,
+           truncated ? ", capture truncated" : "");
+    if (skipped > 0)
+    {
+        fprintf(stderr, "replay: skipped %llu record(s) with port id >= %d\n", (unsigned long long)skipped, MAX_PORTS);
+    }
+    printf("raw bytes:     %llu\n", (unsigned long long)raw_bytes);
+    printf("frames:        %llu (payload %llu bytes)\n", (unsigned long long)frames_total,
+           (unsigned long long)payload_bytes_total);
+    printf("crc errors:    %u\n", errors.crc_errors);
+    printf("format errors: %u\n", errors.format_errors);
+    printf("elapsed:       %.3f s\n", elapsed);
+    if (elapsed > 0)
+    {
+        printf("throughput:    %.0f frames/s, %.2f MB/s\n", (double)frames_total / elapsed,
+               (double)raw_bytes / elapsed / 1e6);
+    }
+    return 0;
+}
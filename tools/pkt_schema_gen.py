@@ -0,0 +1,502 @@
+#!/usr/bin/env python3
+"""
+负载结构体编解码生成器
+
+用法: pkt_schema_gen.py <schema> <out_dir> [--name NAME]
+
+输入 schema 示例:
+
+    # 注释
+    message servo_ctrl {
+        u8 angle            # 目标角度
+        u8 speed
+    }
+    message imu_sample {
+        u32 timestamp_ms
+        i16 accel[3]        # 定长数组
+        f32 temperature
+        bytes<16> label     # 变长字节串，线上为 u8 长度 + 数据
+    }
+
+字段类型: u8 i8 u16 i16 u32 i32 u64 i64 f32 f64，可加 [N] 组成定长数组；bytes<N> 为最长 N(<=255) 的字节串。
+线上格式按声明顺序紧密排列，多字节字段为小端（pkt_endian.h）。
+
+输出（NAME 默认取 schema 文件名）:
+    NAME.h / NAME.c     结构体、<msg>_encode/<msg>_decode/<msg>_wire_size
+    NAME_test.c         Unity 往返测试
+    NAME_bench.c        编解码基准
+"""
+import argparse
+import os
+import re
+import sys
+
+SCALARS = {
+    # 类型: (C 类型, 线上字节数, 存储函数, 读取函数, 存储转换, 读取转换)
+    "u8": ("uint8_t", 1, "pkt_store_u8", "pkt_load_u8", "{v}", "{v}"),
+    "i8": ("int8_t", 1, "pkt_store_u8", "pkt_load_u8", "(uint8_t){v}", "(int8_t){v}"),
+    "u16": ("uint16_t", 2, "pkt_store_le16", "pkt_load_le16", "{v}", "{v}"),
+    "i16": ("int16_t", 2, "pkt_store_le16", "pkt_load_le16", "(uint16_t){v}", "(int16_t){v}"),
+    "u32": ("uint32_t", 4, "pkt_store_le32", "pkt_load_le32", "{v}", "{v}"),
+    "i32": ("int32_t", 4, "pkt_store_le32", "pkt_load_le32", "(uint32_t){v}", "(int32_t){v}"),
+    "u64": ("uint64_t", 8, "pkt_store_le64", "pkt_load_le64", "{v}", "{v}"),
+    "i64": ("int64_t", 8, "pkt_store_le64", "pkt_load_le64", "(uint64_t){v}", "(int64_t){v}"),
+    "f32": ("float", 4, "pkt_store_le32", "pkt_load_le32", "schema_f32_bits({v})", "schema_bits_f32({v})"),
+    "f64": ("double", 8, "pkt_store_le64", "pkt_load_le64", "schema_f64_bits({v})", "schema_bits_f64({v})"),
+}
+
+IDENT = r"[A-Za-z_][A-Za-z0-9_]*"
+FIELD_RE = re.compile(r"^(?:(?P<type>[a-z0-9]+)|bytes<(?P<bytes>\d+)>)\s+(?P<name>" + IDENT +
+                      r")(?:\[(?P<count>\d+)\])?$")
+
+
+class SchemaError(Exception):
+    pass
+
+
+class Field:
+    def __init__(self, name, type_, count=None, max_bytes=None, comment=""):
+        self.name = name
+        self.type = type_
+        self.count = count
+        self.max_bytes = max_bytes
+        self.comment = comment
+
+    @property
+    def is_bytes(self):
+        return self.type == "bytes"
+
+    @property
+    def min_size(self):
+        if self.is_bytes:
+            return 1
+        return SCALARS[self.type][1] * (self.count or 1)
+
+    @property
+    def max_size(self):
+        if self.is_bytes:
+            return 1 + self.max_bytes
+        return self.min_size
+
+
+class Message:
+    def __init__(self, name, comment=""):
+        self.name = name
+        self.comment = comment
+        self.fields = []
+
+    @property
+    def min_size(self):
+        return sum(f.min_size for f in self.fields)
+
+    @property
+    def max_size(self):
+        return sum(f.max_size for f in self.fields)
+
+    @property
+    def fixed(self):
+        return not any(f.is_bytes for f in self.fields)
+
+
+def parse_schema(text, path):
+    messages = []
+    current = None
+    pending_comment = ""
+    for lineno, raw in enumerate(text.splitlines(), 1):
+        line, _, comment = raw.partition("#")
+        line = line.strip()
+        comment = comment.strip()
+        where = "%s:%d" % (path, lineno)
+        if not line:
+            if comment and current is None:
+                pending_comment = comment
+            continue
+        if current is None:
+            m = re.match(r"^message\s+(" + IDENT + r")\s*\{$", line)
+            if not m:
+                raise SchemaError("%s: expected 'message <name> {'" % where)
+            if any(msg.name == m.group(1) for msg in messages):
+                raise SchemaError("%s: duplicate message %s" % (where, m.group(1)))
+            current = Message(m.group(1), comment or pending_comment)
+            pending_comment = ""
+            continue
+        if line == "}":
+            if not current.fields:
+                raise SchemaError("%s: message %s has no fields" % (where, current.name))
+            messages.append(current)
+            current = None
+            continue
+        m = FIELD_RE.match(line)
+        if not m:
+            raise SchemaError("%s: bad field '%s'" % (where, line))
+        name = m.group("name")
+        if any(f.name == name for f in current.fields):
+            raise SchemaError("%s: duplicate field %s" % (where, name))
+        count = int(m.group("count")) if m.group("count") else None
+        if count is not None and count == 0:
+            raise SchemaError("%s: zero-length array" % where)
+        if m.group("bytes"):
+            max_bytes = int(m.group("bytes"))
+            if not 0 < max_bytes <= 255 or count is not None:
+                raise SchemaError("%s: bytes<N> needs 1 <= N <= 255 and no array suffix" % where)
+            current.fields.append(Field(name, "bytes", max_bytes=max_bytes, comment=comment))
+        else:
+            if m.group("type") not in SCALARS:
+                raise SchemaError("%s: unknown type %s" % (where, m.group("type")))
+            current.fields.append(Field(name, m.group("type"), count=count, comment=comment))
+    if current is not None:
+        raise SchemaError("%s: unterminated message %s" % (path, current.name))
+    if not messages:
+        raise SchemaError("%s: no messages" % path)
+    return messages
+
+
+def comment_suffix(text):
+    return " // " + text if text else ""
+
+
+def gen_header(name, messages):
+    guard = name.upper() + "_H"
+    out = ["// 由 tools/pkt_schema_gen.py 生成，请勿手工修改",
+           "#ifndef " + guard,
+           "#define " + guard,
+           "",
+           "#include <stddef.h>",
+           "#include <stdint.h>",
+           ""]
+    for msg in messages:
+        upper = msg.name.upper()
+        out.append("/**")
+        out.append(" * @brief " + (msg.comment or msg.name))
+        out.append(" */")
+        out.append("typedef struct")
+        out.append("{")
+        for f in msg.fields:
+            if f.is_bytes:
+                out.append("    const uint8_t* %s; // 指向编码前的数据或解码输入，不拷贝%s" %
+                           (f.name, "；" + f.comment if f.comment else ""))
+                out.append("    uint8_t %s_len; // %s 长度（<= %d）" % (f.name, f.name, f.max_bytes))
+            else:
+                suffix = "[%d]" % f.count if f.count else ""
+                out.append("    %s %s%s;%s" % (SCALARS[f.type][0], f.name, suffix, comment_suffix(f.comment)))
+        out.append("} %s_t;" % msg.name)
+        out.append("")
+        if msg.fixed:
+            out.append("#define %s_WIRE_SIZE %d" % (upper, msg.min_size))
+        out.append("#define %s_WIRE_MIN %d" % (upper, msg.min_size))
+        out.append("#define %s_WIRE_MAX %d" % (upper, msg.max_size))
+        out.append("")
+        out.append("/**")
+        out.append(" * 编码后的长度")
+        out.append(" */")
+        out.append("size_t %s_wire_size(const %s_t* msg);" % (msg.name, msg.name))
+        out.append("")
+        out.append("/**")
+        out.append(" * 直接编码到调用方缓冲区")
+        out.append(" * @return 编码长度，缓冲区不足或字节串超长返回 0")
+        out.append(" */")
+        out.append("size_t %s_encode(const %s_t* msg, uint8_t* out, size_t out_cap);" % (msg.name, msg.name))
+        out.append("")
+        out.append("/**")
+        out.append(" * 解码（字节串字段指向 in，in 需在使用 msg 期间保持有效）")
+        out.append(" * @return 消耗的字节数，数据被截断或字节串超长返回 -1")
+        out.append(" */")
+        out.append("int %s_decode(%s_t* msg, const uint8_t* in, size_t len);" % (msg.name, msg.name))
+        out.append("")
+    out.append("#endif //" + guard)
+    return "\n".join(out) + "\n"
+
+
+def uses_float(messages):
+    return any(f.type in ("f32", "f64") for m in messages for f in m.fields)
+
+
+def gen_source(name, messages):
+    out = ["// 由 tools/pkt_schema_gen.py 生成，请勿手工修改",
+           '#include "%s.h"' % name,
+           '#include "pkt_endian.h"',
+           "",
+           "#include <string.h>",
+           ""]
+    if uses_float(messages):
+        out += ["static inline uint32_t schema_f32_bits(const float v)",
+                "{",
+                "    uint32_t bits;",
+                "    memcpy(&bits, &v, sizeof(bits));",
+                "    return bits;",
+                "}",
+                "",
+                "static inline float schema_bits_f32(const uint32_t bits)",
+                "{",
+                "    float v;",
+                "    memcpy(&v, &bits, sizeof(v));",
+                "    return v;",
+                "}",
+                "",
+                "static inline uint64_t schema_f64_bits(const double v)",
+                "{",
+                "    uint64_t bits;",
+                "    memcpy(&bits, &v, sizeof(bits));",
+                "    return bits;",
+                "}",
+                "",
+                "static inline double schema_bits_f64(const uint64_t bits)",
+                "{",
+                "    double v;",
+                "    memcpy(&v, &bits, sizeof(v));",
+                "    return v;",
+                "}",
+                ""]
+    for msg in messages:
+        n = msg.name
+        byte_fields = [f for f in msg.fields if f.is_bytes]
+        # wire_size
+        out.append("size_t %s_wire_size(const %s_t* msg)" % (n, n))
+        out.append("{")
+        if byte_fields:
+            out.append("    return %d%s;" % (msg.min_size, "".join(" + msg->%s_len" % f.name for f in byte_fields)))
+        else:
+            out.append("    (void)msg;")
+            out.append("    return %d;" % msg.min_size)
+        out.append("}")
+        out.append("")
+        # encode
+        out.append("size_t %s_encode(const %s_t* msg, uint8_t* out, const size_t out_cap)" % (n, n))
+        out.append("{")
+        for f in byte_fields:
+            out.append("    if (msg->%s_len > %d)" % (f.name, f.max_bytes))
+            out.append("    {")
+            out.append("        return 0;")
+            out.append("    }")
+        out.append("    const size_t len = %s_wire_size(msg);" % n)
+        out.append("    if (out_cap < len)")
+        out.append("    {")
+        out.append("        return 0;")
+        out.append("    }")
+        out.append("    uint8_t* p = out;")
+        for f in msg.fields:
+            if f.is_bytes:
+                out.append("    pkt_store_u8(p++, msg->%s_len);" % f.name)
+                out.append("    if (msg->%s_len > 0)" % f.name)
+                out.append("    {")
+                out.append("        memcpy(p, msg->%s, msg->%s_len);" % (f.name, f.name))
+                out.append("    }")
+                out.append("    p += msg->%s_len;" % f.name)
+                continue
+            _, size, store, _, conv, _ = SCALARS[f.type]
+            if f.count:
+                out.append("    for (int i = 0; i < %d; i++, p += %d)" % (f.count, size))
+                out.append("    {")
+                out.append("        %s(p, %s);" % (store, conv.format(v="msg->%s[i]" % f.name)))
+                out.append("    }")
+            else:
+                out.append("    %s(p, %s);" % (store, conv.format(v="msg->" + f.name)))
+                out.append("    p += %d;" % size)
+        out.append("    return (size_t)(p - out);")
+        out.append("}")
+        out.append("")
+        # decode
+        out.append("int %s_decode(%s_t* msg, const uint8_t* in, const size_t len)" % (n, n))
+        out.append("{")
+        out.append("    if (len < %s_WIRE_MIN)" % n.upper())
+        out.append("    {")
+        out.append("        return -1;")
+        out.append("    }")
+        out.append("    const uint8_t* p = in;")
+        if byte_fields:
+            out.append("    // 变长字段之后的剩余定长部分")
+            out.append("    size_t rest = %d;" % msg.min_size)
+        for f in msg.fields:
+            if f.is_bytes:
+                out.append("    msg->%s_len = pkt_load_u8(p++);" % f.name)
+                out.append("    rest -= 1;")
+                out.append("    if (msg->%s_len > %d || (size_t)(p - in) + msg->%s_len + rest > len)" %
+                           (f.name, f.max_bytes, f.name))
+                out.append("    {")
+                out.append("        return -1;")
+                out.append("    }")
+                out.append("    msg->%s = p;" % f.name)
+                out.append("    p += msg->%s_len;" % f.name)
+                continue
+            _, size, _, load, _, conv = SCALARS[f.type]
+            if f.count:
+                out.append("    for (int i = 0; i < %d; i++, p += %d)" % (f.count, size))
+                out.append("    {")
+                out.append("        msg->%s[i] = %s;" % (f.name, conv.format(v="%s(p)" % load)))
+                out.append("    }")
+            else:
+                out.append("    msg->%s = %s;" % (f.name, conv.format(v="%s(p)" % load)))
+                out.append("    p += %d;" % size)
+            if byte_fields:
+                out.append("    rest -= %d;" % f.min_size)
+        out.append("    return (int)(p - in);")
+        out.append("}")
+        out.append("")
+    return "\n".join(out)
+
+
+def sample_value(f, i, seed):
+    """生成测试用的确定性取值（C 表达式）"""
+    base = (seed * 31 + i * 7 + 3)
+    t = f.type
+    if t in ("f32", "f64"):
+        return "%d.25%s" % (base % 1000 - 500, "f" if t == "f32" else "")
+    bits = SCALARS[t][1] * 8
+    if t.startswith("i"):
+        return "(%s)%d" % (SCALARS[t][0], -(base * 2654435761 % (1 << (bits - 1))))
+    return "(%s)%du" % (SCALARS[t][0], base * 2654435761 % (1 << min(bits, 32)))
+
+
+def gen_test(name, messages):
+    out = ["// 由 tools/pkt_schema_gen.py 生成，请勿手工修改",
+           '#include "unity.h"',
+           '#include "%s.h"' % name,
+           "",
+           "#include <string.h>",
+           "",
+           "void setUp(void)",
+           "{",
+           "}",
+           "",
+           "void tearDown(void)",
+           "{",
+           "}",
+           ""]
+    for msg in messages:
+        n = msg.name
+        out.append("static void fill_%s(%s_t* msg)" % (n, n))
+        out.append("{")
+        out.append("    memset(msg, 0, sizeof(*msg));")
+        for seed, f in enumerate(msg.fields):
+            if f.is_bytes:
+                out.append("    static const uint8_t %s_data[%d] = {%s};" %
+                           (f.name, f.max_bytes, ", ".join(str((seed + k * 13) & 0xFF) for k in range(f.max_bytes))))
+                out.append("    msg->%s = %s_data;" % (f.name, f.name))
+                out.append("    msg->%s_len = %d;" % (f.name, f.max_bytes))
+            elif f.count:
+                for k in range(f.count):
+                    out.append("    msg->%s[%d] = %s;" % (f.name, k, sample_value(f, k, seed)))
+            else:
+                out.append("    msg->%s = %s;" % (f.name, sample_value(f, 0, seed)))
+        out.append("}")
+        out.append("")
+        out.append("void test_%s_roundtrip(void)" % n)
+        out.append("{")
+        out.append("    %s_t msg;" % n)
+        out.append("    fill_%s(&msg);" % n)
+        out.append("    uint8_t wire[%s_WIRE_MAX];" % n.upper())
+        out.append("    const size_t len = %s_encode(&msg, wire, sizeof(wire));" % n)
+        out.append("    TEST_ASSERT_EQUAL(%s_wire_size(&msg), len);" % n)
+        out.append("    TEST_ASSERT_EQUAL(0, %s_encode(&msg, wire, len - 1));" % n)
+        out.append("")
+        out.append("    %s_t back;" % n)
+        out.append("    TEST_ASSERT_EQUAL((int)len, %s_decode(&back, wire, len));" % n)
+        for f in msg.fields:
+            if f.is_bytes:
+                out.append("    TEST_ASSERT_EQUAL(msg.%s_len, back.%s_len);" % (f.name, f.name))
+                out.append("    TEST_ASSERT_EQUAL_MEMORY(msg.%s, back.%s, msg.%s_len);" % (f.name, f.name, f.name))
+            else:
+                out.append("    TEST_ASSERT_EQUAL_MEMORY(&msg.%s, &back.%s, sizeof(msg.%s));" % (f.name, f.name, f.name))
+        out.append("    // 任意截断都必须被拒绝")
+        out.append("    for (size_t cut = 0; cut < len; cut++)")
+        out.append("    {")
+        out.append("        TEST_ASSERT_EQUAL(-1, %s_decode(&back, wire, cut));" % n)
+        out.append("    }")
+        out.append("}")
+        out.append("")
+    out.append("int main(void)")
+    out.append("{")
+    out.append("    UNITY_BEGIN();")
+    for msg in messages:
+        out.append("    RUN_TEST(test_%s_roundtrip);" % msg.name)
+    out.append("    return UNITY_END();")
+    out.append("}")
+    return "\n".join(out) + "\n"
+
+
+def gen_bench(name, messages):
+    out = ["// 由 tools/pkt_schema_gen.py 生成，请勿手工修改",
+           "#define _POSIX_C_SOURCE 200809L",
+           "",
+           '#include "%s.h"' % name,
+           "",
+           "#include <stdio.h>",
+           "#include <stdlib.h>",
+           "#include <string.h>",
+           "#include <time.h>",
+           "",
+           "static double now_s(void)",
+           "{",
+           "    struct timespec ts;",
+           "    clock_gettime(CLOCK_MONOTONIC, &ts);",
+           "    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;",
+           "}",
+           "",
+           "int main(int argc, char** argv)",
+           "{",
+           "    const long iterations = argc > 1 ? atol(argv[1]) : 1000000;",
+           "    volatile size_t sink = 0;",
+           '    printf("%-24s %12s %12s\\n", "message", "encode(ns)", "decode(ns)");']
+    for msg in messages:
+        n = msg.name
+        out.append("    {")
+        out.append("        %s_t msg;" % n)
+        out.append("        memset(&msg, 0, sizeof(msg));")
+        out.append("        uint8_t wire[%s_WIRE_MAX];" % n.upper())
+        out.append("        double t = now_s();")
+        out.append("        for (long i = 0; i < iterations; i++)")
+        out.append("        {")
+        out.append("            sink += %s_encode(&msg, wire, sizeof(wire));" % n)
+        out.append("        }")
+        out.append("        const double enc = (now_s() - t) * 1e9 / (double)iterations;")
+        out.append("        const size_t len = %s_encode(&msg, wire, sizeof(wire));" % n)
+        out.append("        t = now_s();")
+        out.append("        for (long i = 0; i < iterations; i++)")
+        out.append("        {")
+        out.append("            sink += (size_t)%s_decode(&msg, wire, len);" % n)
+        out.append("        }")
+        out.append("        const double dec = (now_s() - t) * 1e9 / (double)iterations;")
+        out.append('        printf("%%-24s %%12.2f %%12.2f\\n", "%s", enc, dec);' % n)
+        out.append("    }")
+    out.append("    (void)sink;")
+    out.append("    return 0;")
+    out.append("}")
+    return "\n".join(out) + "\n"
+
+
+def write_if_changed(path, content):
+    # 内容不变时不改写文件，避免触发无谓的重新编译
+    if os.path.exists(path):
+        with open(path, encoding="utf-8") as f:
+            if f.read() == content:
+                return
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(content)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="generate payload encoders/decoders from a schema")
+    parser.add_argument("schema")
+    parser.add_argument("out_dir")
+    parser.add_argument("--name", help="output base name (default: schema file name)")
+    args = parser.parse_args()
+
+    name = args.name or os.path.splitext(os.path.basename(args.schema))[0]
+    if not re.match("^" + IDENT + "$", name):
+        sys.exit("pkt_schema_gen: invalid output name %s" % name)
+    with open(args.schema, encoding="utf-8") as f:
+        text = f.read()
+    try:
+        messages = parse_schema(text, args.schema)
+    except SchemaError as e:
+        sys.exit("pkt_schema_gen: %s" % e)
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    write_if_changed(os.path.join(args.out_dir, name + ".h"), gen_header(name, messages))
+    write_if_changed(os.path.join(args.out_dir, name + ".c"), gen_source(name, messages))
+    write_if_changed(os.path.join(args.out_dir, name + "_test.c"), gen_test(name, messages))
+    write_if_changed(os.path.join(args.out_dir, name + "_bench.c"), gen_bench(name, messages))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,316 @@
+/*
+ * 基于伪终端的端到端链路压测
+ *
+ * 用法: pty_link_bench [-n frames] [-b baud] [-s payload] [-p]
+ *   -n frames   每组发送帧数（默认 2000）
+ *   -b baud     只测指定波特率（默认遍历 9600/115200/460800/921600）
+ *   -s payload  只测指定负载长度（默认遍历 16/32/64/PROTOCOL_MAX_DATA_LEN）
+ *   -p          发送端按波特率限速（伪终端本身不按波特率节流）
+ *
+ * 每组打开一对伪终端，从端设置为原始模式和对应波特率；发送线程把 protocol_pack_frame
+ * 打包的帧写入主端，经内核 tty 层后由接收端读取并送入 protocol_receiver。
+ * 负载前 12 字节携带序号和发送时间戳，用于统计时延和丢帧。
+ * 任一组有丢帧时返回 1。
+ */
+#define _XOPEN_SOURCE 700
+
+#include "pkt_endian.h"
+#include "pkt_pool.h"
+#include "pkt_protocol.h"
+#include "pkt_protocol_buf.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define STAMP_LEN 12
+#define IDLE_TIMEOUT_MS 1000
+// 单次 read 的上限，与常见串口驱动每次交付的数据量相当
+#define READ_CHUNK 512
+
+typedef struct
+{
+    int fd; // 伪终端主端
+    uint32_t frames; // 发送帧数
+    uint16_t payload_len; // 负载长度
+    uint32_t baud; // 波特率
+    bool paced; // 是否按波特率限速
+    uint64_t bytes; // 已发送字节
+} bench_writer_t;
+
+static uint64_t* latencies;
+static uint32_t received;
+static uint32_t expected;
+static uint64_t payload_bytes;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static speed_t to_speed(const uint32_t baud)
+{
+    switch (baud)
+    {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B0;
+    }
+}
+
+// 等价于 cfmakeraw，后者不在 POSIX 中
+static int set_raw_mode(const int fd, const uint32_t baud)
+{
+    struct termios tio;
+    if (tcgetattr(fd, &tio) < 0)
+    {
+        return -1;
+    }
+    tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+    tio.c_oflag &= ~OPOST;
+    tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(CSIZE | PARENB);
+    tio.c_cflag |= CS8 | CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, to_speed(baud));
+    cfsetospeed(&tio, to_speed(baud));
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static int write_all(const int fd, const uint8_t* data, size_t len)
+{
+    while (len > 0)
+    {
+        const ssize_t n = write(fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void* writer_thread(void* arg)
+{
+    bench_writer_t* writer = arg;
+    uint8_t payload[PROTOCOL_MAX_DATA_LEN];
+    memset(payload, 0x5A, sizeof(payload));
+    // 8N1 每字节 10 bit
+    const double ns_per_byte = 1e9 * 10.0 / writer->baud;
+    const uint64_t start = now_ns();
+
+    for (uint32_t seq = 0; seq < writer->frames; seq++)
+    {
+        if (writer->paced)
+        {
+            const uint64_t due = start + (uint64_t)(writer->bytes * ns_per_byte);
+            const uint64_t now = now_ns();
+            if (due > now)
+            {
+                const struct timespec ts = {(time_t)((due - now) / 1000000000ull), (long)((due - now) % 1000000000ull)};
+                nanosleep(&ts, NULL);
+            }
+        }
+        const uint64_t stamp = now_ns();
+        pkt_store_le32(payload, seq);
+        pkt_store_le64(payload + 4, stamp);
+        uint16_t frame_len;
+        uint8_t* frame = protocol_pack_frame(PROTOCOL_TYPE_SENSOR, payload, writer->payload_len, &frame_len);
+        if (!frame || write_all(writer->fd, frame, frame_len) < 0)
+        {
+            protocol_free(frame);
+            break;
+        }
+        writer->bytes += frame_len;
+        protocol_free(frame);
+    }
+    return NULL;
+}
+
+static void on_frame(uint8_t type, const uint8_t* data, uint16_t len)
+{
+    (void)type;
+    if (len < STAMP_LEN || received >= expected)
+    {
+        return;
+    }
+    const uint64_t stamp = pkt_load_le64(data + 4);
+    latencies[received++] = now_ns() - stamp;
+    payload_bytes += len;
+}
+
+static int compare_u64(const void* a, const void* b)
+{
+    const uint64_t x = *(const uint64_t*)a;
+    const uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint32_t n, const double p)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    uint32_t idx = (uint32_t)(p * (n - 1) + 0.5);
+    return (double)latencies[idx] / 1000.0;
+}
+
+// 运行一组测试，返回丢帧数，打开伪终端或分配内存失败返回 -1
+static int run_case(const uint32_t baud, const uint16_t payload_len, const uint32_t frames, const bool paced)
+{
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+    {
+        perror("posix_openpt");
+        return -1;
+    }
+    const int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0 || set_raw_mode(slave, baud) < 0)
+    {
+        perror("pty slave");
+        close(master);
+        return -1;
+    }
+
+    received = 0;
+    expected = frames;
+    payload_bytes = 0;
+    latencies = calloc(frames, sizeof(uint64_t));
+    if (!latencies && frames > 0)
+    {
+        perror("calloc");
+        close(slave);
+        close(master);
+        return -1;
+    }
+
+    protocol_receiver receiver;
+    protocol_receiver_init(&receiver, 1024, on_frame);
+    bench_writer_t writer = {master, frames, payload_len, baud, paced, 0};
+    pthread_t tid;
+    const uint64_t start = now_ns();
+    pthread_create(&tid, NULL, writer_thread, &writer);
+
+    uint8_t buf[READ_CHUNK];
+    struct pollfd pfd = {slave, POLLIN, 0};
+    uint64_t last_rx = now_ns();
+    while (received < frames)
+    {
+        const int ready = poll(&pfd, 1, 100);
+        if (ready > 0)
+        {
+            const ssize_t n = read(slave, buf, sizeof(buf));
+            if (n > 0)
+            {
+                protocol_receiver_append(&receiver, buf, (uint16_t)n);
+                last_rx = now_ns();
+            }
+        }
+        else if (now_ns() - last_rx > (uint64_t)IDLE_TIMEOUT_MS * 1000000ull)
+        {
+            break;
+        }
+    }
+    const double elapsed = (double)(now_ns() - start) / 1e9;
+    pthread_join(tid, NULL);
+
+    qsort(latencies, received, sizeof(uint64_t), compare_u64);
+    const uint32_t lost = frames - received;
+    printf("%7u %7u %10.0f %12.0f %9.1f %9.1f %9.1f %9.1f %6u\n", baud, payload_len,
+           received / elapsed, writer.bytes / elapsed, percentile_us(received, 0.50),
+           percentile_us(received, 0.90), percentile_us(received, 0.99),
+           received ? (double)latencies[received - 1] / 1000.0 : 0.0, lost);
+
+    protocol_receiver_destroy(&receiver);
+    free(latencies);
+    close(slave);
+    close(master);
+    return (int)lost;
+}
+
+int main(int argc, char** argv)
+{
+    static const uint32_t default_bauds[] = {9600, 115200, 460800, 921600};
+    static const uint16_t default_sizes[] = {16, 32, 64, PROTOCOL_MAX_DATA_LEN};
+    uint32_t frames = 2000;
+    uint32_t baud = 0;
+    int size = -1;
+    bool paced = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:b:s:p")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            frames = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'b':
+            baud = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            size = atoi(optarg);
+            break;
+        case 'p':
+            paced = true;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n frames] [-b baud] [-s payload] [-p]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((baud && to_speed(baud) == B0) || size > PROTOCOL_MAX_DATA_LEN || (size >= 0 && size < STAMP_LEN))
+    {
+        fprintf(stderr, "bench: unsupported baud or payload size (%d..%d)\n", STAMP_LEN, PROTOCOL_MAX_DATA_LEN);
+        return 2;
+    }
+
+    printf("%7s %7s %10s %12s %9s %9s %9s %9s %6s\n", "baud", "payload", "frames/s", "bytes/s", "p50(us)",
+           "p90(us)", "p99(us)", "max(us)", "lost");
+    int failed = 0;
+    for (size_t b = 0; b < sizeof(default_bauds) / sizeof(default_bauds[0]); b++)
+    {
+        const uint32_t case_baud = baud ? baud : default_bauds[b];
+        for (size_t s = 0; s < sizeof(default_sizes) / sizeof(default_sizes[0]); s++)
+        {
+            const uint16_t case_size = size >= 0 ? (uint16_t)size : default_sizes[s];
+            if (run_case(case_baud, case_size, frames, paced) != 0)
+            {
+                failed = 1;
+            }
+            if (size >= 0)
+            {
+                break;
+            }
+        }
+        if (baud)
+        {
+            break;
+        }
+    }
+    return failed;
+}